@@ -0,0 +1,253 @@
+#include "arena.h"
+#include "telemetria.h"
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+#include <QStringList>
+#include <QDebug>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+bool    Arena::paginas_grandes = false;
+QString Arena::temporal;
+
+// tamaño a partir del cual la asignación de páginas se reparte entre varios hilos
+static const size_t BYTES_POR_HILO = 64 * 1024 * 1024;
+
+// ************************************************************************************************
+Arena::Arena()
+{
+    datos_gpu        = {nullptr, 0, 0, nullptr, 0, vector<float*>()};
+    coeficientes_gpu = {nullptr, 0, 0, nullptr, 0, vector<float*>()};
+    diferencias_dmr  = {nullptr, 0, 0, nullptr, 0, vector<float*>()};
+    datos_gpu_sucios = 0;
+}
+
+// ************************************************************************************************
+Arena::~Arena()
+{
+    liberar();
+}
+
+// ************************************************************************************************
+void Arena::configurar(bool paginas_grandesx, const QString &temporalx)
+{
+    paginas_grandes = paginas_grandesx;
+    temporal        = temporalx;
+}
+
+#ifdef __linux__
+// ************************************************************************************************
+// máscara de los nodos NUMA en línea según /sys, vacía en máquinas con un solo nodo
+static unsigned long nodos_numa()
+{
+    QFile f("/sys/devices/system/node/online");
+    if (!f.open(QIODevice::ReadOnly))
+        return 0;
+
+    // lista de nodos y rangos de nodos: "0", "0-1", "0,2-3"
+    unsigned long mascara = 0;
+    int           nodos   = 0;
+    foreach (const QString &tramo, QString(f.readAll()).trimmed().split(','))
+    {
+        int desde = tramo.section('-', 0, 0).toInt();
+        int hasta = tramo.contains('-') ? tramo.section('-', 1, 1).toInt() : desde;
+        for (int n = desde; n <= hasta && n < int(8 * sizeof(mascara)); n++)
+        {
+            mascara |= 1ul << n;
+            nodos++;
+        }
+    }
+
+    return nodos > 1 ? mascara : 0;
+}
+#endif
+
+// ************************************************************************************************
+void Arena::reservar(bufer &b, size_t n, int filas)
+{
+    Telemetria::Medida medida("allocate");
+
+    // fuera de memoria el búfer es un fichero temporal, que al crecer se llena de ceros sin
+    // escribirlos; las páginas se asignan según se usan y el sistema las devuelve al disco
+    if (!temporal.isEmpty())
+    {
+        qint64          bytes   = qint64(n * sizeof(float));
+        QTemporaryFile *fichero = new QTemporaryFile(QDir(temporal).filePath("hpg_dhunter_XXXXXX.arena"));
+        uchar          *mapa    = nullptr;
+        if (fichero->open() && fichero->resize(bytes))
+            mapa = fichero->map(0, bytes);
+
+        if (mapa != nullptr)
+        {
+            b.memoria   = reinterpret_cast<float *>(mapa);
+            b.bytes     = size_t(bytes);
+            b.fichero   = fichero;
+            b.capacidad = n;
+            medida.bytes(bytes);
+            return;
+        }
+
+        qDebug() << "arena: scratch file not available in" << temporal << "-" << fichero->errorString()
+                 << "- the buffer stays in memory";
+        delete fichero;
+    }
+
+#ifdef __linux__
+    // páginas a cero sin tocarlas, redondeadas a páginas grandes si se piden
+    size_t pagina = size_t(sysconf(_SC_PAGESIZE));
+    size_t bloque = paginas_grandes ? size_t(2 * 1024 * 1024) : pagina;
+    size_t bytes  = (n * sizeof(float) + bloque - 1) / bloque * bloque;
+
+    void *memoria = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memoria == MAP_FAILED)
+        throw std::bad_alloc();
+
+    if (paginas_grandes && madvise(memoria, bytes, MADV_HUGEPAGE) != 0)
+        qDebug() << "arena: transparent huge pages not available";
+
+    // reparto de las páginas entre todos los nodos antes de asignarlas (MPOL_INTERLEAVE)
+    unsigned long nodos = nodos_numa();
+    if (nodos != 0 && syscall(__NR_mbind, memoria, bytes, 3, &nodos, 8 * sizeof(nodos) + 1, 0) != 0)
+        qDebug() << "arena: mbind failed, pages stay on the first touching node";
+
+    // asignación de las páginas en paralelo, por tramos consecutivos de filas
+    size_t unidades = filas > 1 ? size_t(filas) : bytes / pagina;
+    size_t tamanyo  = filas > 1 ? bytes / size_t(filas) / pagina * pagina : pagina;
+    size_t hilos    = qMin(qMax(size_t(std::thread::hardware_concurrency()), size_t(1)),
+                           qMin(unidades, qMax(bytes / BYTES_POR_HILO, size_t(1))));
+
+    auto asignar = [=](size_t h) {
+        size_t desde = unidades * h / hilos * tamanyo;
+        size_t hasta = h + 1 == hilos ? bytes : unidades * (h + 1) / hilos * tamanyo;
+        for (size_t p = desde; p < hasta; p += pagina)
+            static_cast<volatile char *>(memoria)[p] = 0;
+    };
+
+    // ..con los contadores hardware de los hilos lanzados sumados a la etapa allocate
+    Telemetria::Reparto reparto;
+    vector<std::thread> asignadores;
+    for (size_t h = 1; h < hilos; h++)
+        asignadores.emplace_back([&reparto, asignar, h]() {
+            Telemetria::Reparto::Hilo hilo(reparto);
+            asignar(h);
+        });
+    asignar(0);
+    for (std::thread &t : asignadores)
+        t.join();
+
+    b.memoria = static_cast<float *>(memoria);
+    b.bytes   = bytes;
+#else
+    Q_UNUSED(filas);
+
+    b.memoria = new float[n]();
+    b.bytes   = n * sizeof(float);
+#endif
+
+    b.capacidad = n;
+    medida.bytes(qint64(b.bytes));
+}
+
+// ************************************************************************************************
+float **Arena::matriz(bufer &b, int filas, size_t columnas)
+{
+    size_t n = size_t(filas) * columnas;
+
+    // sólo se reserva de nuevo si la petición no cabe, sin copiar el contenido anterior
+    if (n > b.capacidad)
+    {
+        liberar(b);
+        reservar(b, n, filas);
+    }
+
+    b.usados = n;
+    b.filas.resize(size_t(filas));
+    for (int i = 0; i < filas; i++)
+        b.filas[size_t(i)] = b.memoria + size_t(i) * columnas;
+
+    return b.filas.data();
+}
+
+// ************************************************************************************************
+float **Arena::datos(int filas, size_t columnas)
+{
+    // una petición anterior con filas sin devolver se borra completa
+    if (datos_gpu_sucios > 0)
+        memset(datos_gpu.memoria, 0, datos_gpu.usados * sizeof(float));
+
+    float **m        = matriz(datos_gpu, filas, columnas);
+    datos_gpu_sucios = filas;
+
+    return m;
+}
+
+// ************************************************************************************************
+void Arena::devolver_datos(int fila, const vector<uint> &posiciones)
+{
+    float *f = datos_gpu.filas[size_t(fila)];
+    for (uint p : posiciones)
+        f[p] = 0.0;
+
+    datos_gpu_sucios--;
+}
+
+// ************************************************************************************************
+float **Arena::coeficientes(int filas, size_t columnas)
+{
+    return matriz(coeficientes_gpu, filas, columnas);
+}
+
+// ************************************************************************************************
+float *Arena::diferencias(size_t n)
+{
+    float *d = matriz(diferencias_dmr, 1, n)[0];
+    memset(d, 0, n * sizeof(float));
+
+    return d;
+}
+
+// ************************************************************************************************
+void Arena::liberar(bufer &b)
+{
+    // cerrar el fichero temporal deshace la proyección y lo borra
+    if (b.fichero != nullptr)
+        delete b.fichero;
+    else if (b.memoria != nullptr)
+    {
+#ifdef __linux__
+        munmap(b.memoria, b.bytes);
+#else
+        delete [] b.memoria;
+#endif
+    }
+
+    b.memoria   = nullptr;
+    b.capacidad = 0;
+    b.bytes     = 0;
+    b.fichero   = nullptr;
+    b.usados    = 0;
+    vector<float*>().swap(b.filas);
+}
+
+// ************************************************************************************************
+void Arena::liberar()
+{
+    liberar(datos_gpu);
+    liberar(coeficientes_gpu);
+    liberar(diferencias_dmr);
+    datos_gpu_sucios = 0;
+}
+
+// ************************************************************************************************
+qint64 Arena::reservados() const
+{
+    return qint64(datos_gpu.bytes + coeficientes_gpu.bytes + diferencias_dmr.bytes);
+}
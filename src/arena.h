@@ -0,0 +1,158 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <QString>
+#include <QtGlobal>
+#include <vector>
+
+using namespace std;
+
+class QTemporaryFile;
+
+/**
+ * @brief Memoria de trabajo de una ejecución para las matrices contiguas de la transformada y para
+ *        las diferencias de la búsqueda de DMRs.
+ *
+ *        Cada búfer se reserva la primera vez que se pide y sólo crece cuando un cromosoma o un
+ *        bloque de muestras necesita más que todos los anteriores, de forma que tras el cromosoma
+ *        más largo de la ejecución (el primero en los genomas humano y de ratón) ningún cromosoma ni
+ *        señal reserva, inicializa o libera memoria: las páginas ya están asignadas y no provocan
+ *        fallos de página. La memoria se libera de una vez al acabar la ejecución.
+ *
+ *        La matriz de datos se entrega siempre a cero. En lugar de borrarla entera en cada bloque,
+ *        quien la usa devuelve cada fila con las posiciones que ha escrito y sólo esas se ponen a
+ *        cero; si alguna fila no se devuelve, la siguiente petición borra la zona entregada.
+ *
+ *        En Linux los búferes se piden al sistema con mmap, que los entrega ya a cero sin tocarlos,
+ *        y sus páginas se asignan en paralelo, cada hilo un tramo consecutivo de filas. En máquinas
+ *        con varios nodos NUMA las páginas se reparten entre todos los nodos, para que cualquier
+ *        etapa lea con el ancho de banda de toda la máquina. Opcionalmente se piden páginas grandes
+ *        transparentes, que reducen los fallos de TLB en matrices de varios GB.
+ *
+ *        Fuera de memoria, con un disco de trabajo configurado, cada búfer es un fichero temporal
+ *        de ese disco proyectado en memoria, que el sistema escribe y vuelve a leer por páginas
+ *        cuando no cabe en RAM. El mismo disco recibe los registros leídos de las muestras.
+ */
+class Arena
+{
+public:
+    Arena();
+    ~Arena();
+
+    /**
+     * @fn static void configurar(bool, const QString &)
+     * @brief Elige cómo se colocan los búferes reservados a partir de ese momento
+     * @param paginas_grandes   pide páginas grandes transparentes para los búferes
+     * @param temporal          disco de trabajo local para trabajar fuera de memoria, vacío en memoria
+     */
+    static void configurar(bool paginas_grandes, const QString &temporal = QString());
+
+    /**
+     * @fn static QString directorio_temporal()
+     * @brief Disco de trabajo fuera de memoria, vacío si se trabaja en memoria
+     */
+    static QString directorio_temporal() { return temporal; }
+
+    /**
+     * @fn float **datos(int, size_t)
+     * @brief Matriz contigua a cero para las muestras que se envían a la GPU
+     * @param filas     número de muestras
+     * @param columnas  posiciones por muestra
+     * @return          punteros a cada fila, válidos hasta la siguiente petición
+     */
+    float **datos(int filas, size_t columnas);
+
+    /**
+     * @fn void devolver_datos(int, const vector<uint> &)
+     * @brief Pone a cero las posiciones escritas en una fila de la matriz de datos
+     * @param fila          fila de la última matriz entregada
+     * @param posiciones    posiciones escritas en la fila
+     */
+    void devolver_datos(int fila, const vector<uint> &posiciones);
+
+    /**
+     * @fn float **coeficientes(int, size_t)
+     * @brief Matriz contigua, con el contenido anterior, que recibe de la GPU los coeficientes transformados
+     * @return          punteros a cada fila, válidos hasta la siguiente petición
+     */
+    float **coeficientes(int filas, size_t columnas);
+
+    /**
+     * @fn float *diferencias(size_t)
+     * @brief Vector a cero para las diferencias entre grupos de cada ventana
+     */
+    float *diferencias(size_t n);
+
+    /**
+     * @fn void liberar()
+     * @brief Libera toda la memoria al acabar la ejecución
+     */
+    void liberar();
+
+    /**
+     * @fn qint64 reservados() const
+     * @brief Bytes reservados entre todos los búferes
+     */
+    qint64 reservados() const;
+
+private:
+    /**
+     * @brief búfer que sólo crece
+     * @param memoria      valores reservados
+     * @param capacidad    número de valores reservados
+     * @param bytes        bytes pedidos al sistema, redondeados a páginas
+     * @param fichero      fichero temporal proyectado en memoria, nullptr en memoria
+     * @param usados       valores de la última petición
+     * @param filas        punteros a cada fila de la última petición
+     */
+    struct bufer
+    {
+        float          *memoria;
+        size_t          capacidad;
+        size_t          bytes;
+        QTemporaryFile *fichero;
+        size_t          usados;
+        vector<float*>  filas;
+    };
+
+    /**
+     * @fn static float **matriz(bufer &, int, size_t)
+     * @brief Ajusta un búfer a una matriz, reservándolo de nuevo, a cero, sólo si no cabe
+     */
+    static float **matriz(bufer &b, int filas, size_t columnas);
+
+    /**
+     * @fn static void reservar(bufer &, size_t, int)
+     * @brief Reserva la memoria de un búfer a cero, repartida entre los nodos NUMA y asignando sus
+     *        páginas en paralelo
+     * @param n         valores a reservar
+     * @param filas     filas de la matriz, para repartir la asignación por tramos de filas
+     */
+    static void reservar(bufer &b, size_t n, int filas);
+
+    /**
+     * @fn static void liberar(bufer &)
+     * @brief Libera un búfer
+     */
+    static void liberar(bufer &b);
+
+    /**
+     * @brief colocación configurada para los búferes nuevos
+     */
+    static bool    paginas_grandes;
+    static QString temporal;
+
+    /**
+     * @brief búferes de la ejecución
+     * @param datos_gpu         matriz de datos de las muestras para la GPU
+     * @param datos_gpu_sucios  filas de la matriz de datos entregadas y no devueltas
+     * @param coeficientes_gpu  matriz de coeficientes de la transformada
+     * @param diferencias_dmr   vector de diferencias entre grupos
+     */
+    bufer datos_gpu;
+    int   datos_gpu_sucios;
+    bufer coeficientes_gpu;
+    bufer diferencias_dmr;
+};
+
+#endif // ARENA_H
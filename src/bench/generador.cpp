@@ -0,0 +1,229 @@
+#include "generador.h"
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+#include <fstream>
+#include <random>
+
+using namespace std;
+
+// nivel medio de metilación y concentración de la beta de cada CpG
+static const double NIVEL_FONDO   = 0.75;
+static const double NIVEL_ISLA    = 0.15;
+static const double CONCENTRACION = 10.0;
+// ruido de cada muestra sobre el nivel de la posición
+static const double RUIDO_MUESTRA = 0.05;
+// nivel de hidroximetilación
+static const double NIVEL_HMC     = 0.05;
+
+// ************************************************************************************************
+// nivel de metilación de una posición, beta con media 'media' construida con dos gammas
+static double beta(mt19937 &rng, double media)
+{
+    gamma_distribution<double> a(media * CONCENTRACION, 1.0);
+    gamma_distribution<double> b((1.0 - media) * CONCENTRACION, 1.0);
+    double x = a(rng);
+    double y = b(rng);
+
+    return x + y > 0 ? x / (x + y) : media;
+}
+
+// ************************************************************************************************
+// cobertura binomial negativa como mezcla gamma-Poisson
+static int cobertura(mt19937 &rng, double media, double dispersion)
+{
+    gamma_distribution<double> g(dispersion, media / dispersion);
+    poisson_distribution<int>  p(g(rng));
+
+    return p(rng);
+}
+
+// ************************************************************************************************
+bool Generador::generar(const parametros &param,
+                        const QString &ruta,
+                        QStringList &lista_casos,
+                        QStringList &lista_control,
+                        QList<region> &plantados,
+                        QString &error)
+{
+    if (param.islas < param.dmrs || param.longitud_dmr > param.longitud_isla ||
+        uint64_t(param.islas) * param.longitud_isla * 2 > param.longitud)
+    {
+        error = "invalid generator parameters: every planted DMR needs its own island and "
+                "the islands must fit in half the chromosome";
+        return false;
+    }
+
+    mt19937 rng(param.semilla);
+
+    // islas repartidas por el cromosoma, una en cada tramo de igual longitud
+    vector<region> islas;
+    uint32_t tramo = param.longitud / uint32_t(max(1, param.islas));
+    for (int i = 0; i < param.islas; i++)
+    {
+        uniform_int_distribution<uint32_t> desplazamiento(0, tramo - param.longitud_isla);
+        uint32_t inicio = uint32_t(i) * tramo + 1 + desplazamiento(rng);
+        islas.push_back({inicio, inicio + param.longitud_isla - 1});
+    }
+
+    // los DMRs se plantan en islas elegidas al azar, alternando hipermetilados e hipometilados
+    // ..en los hipometilados la isla está metilada para que el descenso sea posible
+    vector<int> orden(islas.size());
+    for (size_t i = 0; i < orden.size(); i++)
+        orden[i] = int(i);
+    shuffle(orden.begin(), orden.end(), rng);
+    orden.resize(size_t(param.dmrs));
+    sort(orden.begin(), orden.end());
+
+    vector<double> desplazamiento_isla(islas.size(), 0.0);
+    vector<double> nivel_isla(islas.size(), NIVEL_ISLA);
+    vector<region> dmrs;
+    for (size_t k = 0; k < orden.size(); k++)
+    {
+        const region &isla = islas[size_t(orden[k])];
+        uniform_int_distribution<uint32_t> desplazamiento(0, param.longitud_isla - param.longitud_dmr);
+        uint32_t inicio = isla.inicio + desplazamiento(rng);
+        dmrs.push_back({inicio, inicio + param.longitud_dmr - 1});
+
+        bool hiper = k % 2 == 0;
+        desplazamiento_isla[size_t(orden[k])] = hiper ? param.diferencia : -param.diferencia;
+        nivel_isla[size_t(orden[k])]          = hiper ? NIVEL_ISLA : 1.0 - NIVEL_ISLA;
+    }
+
+    // posiciones CpG con huecos geométricos según la densidad del tramo, con su nivel y su
+    // desplazamiento en los casos si están dentro de un DMR
+    vector<uint32_t> posiciones;
+    vector<float>    niveles;
+    vector<float>    desplazamientos;
+    geometric_distribution<uint32_t> hueco_fondo(param.densidad_cpg);
+    geometric_distribution<uint32_t> hueco_isla(param.densidad_isla);
+
+    size_t   isla = 0;
+    size_t   dmr  = 0;
+    uint64_t p    = 1 + hueco_fondo(rng);
+    while (p <= param.longitud)
+    {
+        while (isla < islas.size() && islas[isla].fin < p)
+            isla++;
+        while (dmr < dmrs.size() && dmrs[dmr].fin < p)
+            dmr++;
+
+        bool en_isla = isla < islas.size() && islas[isla].inicio <= p;
+        bool en_dmr  = dmr < dmrs.size() && dmrs[dmr].inicio <= p;
+
+        posiciones.push_back(uint32_t(p));
+        niveles.push_back(float(beta(rng, en_isla ? nivel_isla[isla] : NIVEL_FONDO)));
+        desplazamientos.push_back(en_dmr ? float(desplazamiento_isla[isla]) : 0.0f);
+
+        // el siguiente hueco usa la densidad del tramo donde cae la posición actual
+        // ..al salir de una isla se salta directamente al primer hueco de fondo
+        uint64_t siguiente = p + 1 + (en_isla ? hueco_isla(rng) : hueco_fondo(rng));
+        if (!en_isla && isla < islas.size() && siguiente > islas[isla].inicio)
+            siguiente = islas[isla].inicio + hueco_isla(rng);
+        p = siguiente;
+    }
+
+    // una muestra por directorio, con su propio generador para que no dependa del orden
+    lista_casos.clear();
+    lista_control.clear();
+    for (int m = 0; m < param.casos + param.controles; m++)
+    {
+        bool    caso       = m < param.casos;
+        QString directorio = ruta + (caso ? "/case_" + QString::number(m)
+                                          : "/control_" + QString::number(m - param.casos));
+        if (!QDir().mkpath(directorio))
+        {
+            error = "An error occurred creating the folder: " + directorio;
+            return false;
+        }
+        (caso ? lista_casos : lista_control) << directorio;
+
+        QString fichero = directorio + "/methylation_map_mix_" + QString::number(param.chrom) + ".csv";
+        ofstream salida(fichero.toStdString(), ios::trunc);
+        if (!salida.is_open())
+        {
+            error = "An error occurred opening the file: " + fichero;
+            return false;
+        }
+
+        mt19937 rng_muestra(param.semilla * 1000003u + uint32_t(m));
+        normal_distribution<double> ruido(0.0, RUIDO_MUESTRA);
+
+        for (size_t i = 0; i < posiciones.size(); i++)
+        {
+            int cobertura_mc  = cobertura(rng_muestra, param.cobertura_media, param.dispersion);
+            int cobertura_hmc = cobertura(rng_muestra, param.cobertura_media, param.dispersion);
+            if (cobertura_mc == 0 && cobertura_hmc == 0)
+                continue;
+
+            double nivel = niveles[i] + ruido(rng_muestra) + (caso ? desplazamientos[i] : 0.0);
+            nivel = min(1.0, max(0.0, nivel));
+
+            binomial_distribution<int> mc(cobertura_mc, nivel);
+            binomial_distribution<int> hmc(cobertura_hmc, NIVEL_HMC);
+            int metiladas = mc(rng_muestra);
+            int hidroxi   = hmc(rng_muestra);
+
+            // columnas que lee Files_worker: posición, C, -, mC, C (hmC), -, hmC
+            salida << posiciones[i] << ' '
+                   << cobertura_mc - metiladas << " 0 " << metiladas << ' '
+                   << cobertura_hmc - hidroxi  << " 0 " << hidroxi   << '\n';
+        }
+
+        if (!salida.good())
+        {
+            error = "An error occurred writing the file: " + fichero;
+            return false;
+        }
+    }
+
+    plantados.clear();
+    for (const region &r : dmrs)
+        plantados << r;
+
+    return true;
+}
+
+// ************************************************************************************************
+double Generador::sensibilidad(const QList<region> &plantados, const QList<region> &encontrados, int &acertados)
+{
+    int recuperados = 0;
+    acertados       = 0;
+
+    foreach (const region &p, plantados)
+        foreach (const region &e, encontrados)
+            if (e.inicio <= p.fin && e.fin >= p.inicio)
+            {
+                recuperados++;
+                break;
+            }
+
+    foreach (const region &e, encontrados)
+        foreach (const region &p, plantados)
+            if (e.inicio <= p.fin && e.fin >= p.inicio)
+            {
+                acertados++;
+                break;
+            }
+
+    return plantados.isEmpty() ? 1.0 : double(recuperados) / plantados.size();
+}
+
+// ************************************************************************************************
+bool Generador::leer_gff(const QString &fichero, QList<region> &regiones)
+{
+    regiones.clear();
+
+    QFile data(fichero);
+    if (!data.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    while (!data.atEnd())
+    {
+        QList<QByteArray> columnas = data.readLine().split('\t');
+        if (columnas.size() > 4)
+            regiones << region{columnas.at(3).toUInt(), columnas.at(4).toUInt()};
+    }
+
+    return true;
+}
@@ -0,0 +1,102 @@
+#ifndef GENERADOR_H
+#define GENERADOR_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+
+/**
+ * @brief Generación de muestras sintéticas con el formato de los ficheros methylation_map_*.csv
+ *        que lee Files_worker, con DMRs conocidos para medir la sensibilidad del análisis.
+ *
+ *        El cromosoma tiene posiciones CpG repartidas con una densidad de fondo baja e islas CpG
+ *        densas. Cada CpG tiene un nivel de metilación propio (alto fuera de las islas y bajo
+ *        dentro) al que cada muestra añade su ruido; la cobertura de cada posición sigue una
+ *        distribución binomial negativa (gamma-Poisson) con media y dispersión configurables.
+ *        Los DMRs plantados se colocan dentro de islas y desplazan el nivel de metilación de
+ *        las muestras caso. La misma semilla genera siempre los mismos ficheros.
+ */
+class Generador
+{
+public:
+    /**
+     * @brief parámetros de la generación
+     * @param chrom             número de cromosoma de los ficheros
+     * @param longitud          longitud del cromosoma en pares de bases
+     * @param casos             número de muestras caso
+     * @param controles         número de muestras control
+     * @param densidad_cpg      fracción de posiciones CpG fuera de las islas
+     * @param islas             número de islas CpG
+     * @param longitud_isla     longitud de cada isla
+     * @param densidad_isla     fracción de posiciones CpG dentro de las islas
+     * @param cobertura_media   cobertura media por posición
+     * @param dispersion        parámetro de forma de la binomial negativa (menor -> más dispersa)
+     * @param dmrs              número de DMRs plantados, cada uno dentro de una isla distinta
+     * @param longitud_dmr      longitud de cada DMR plantado
+     * @param diferencia        diferencia de metilación entre casos y controles en los DMRs
+     * @param semilla           semilla de los números aleatorios
+     */
+    struct parametros
+    {
+        int      chrom           = 1;
+        uint32_t longitud        = 10000000;
+        int      casos           = 4;
+        int      controles       = 4;
+        double   densidad_cpg    = 0.01;
+        int      islas           = 200;
+        uint32_t longitud_isla   = 2000;
+        double   densidad_isla   = 0.15;
+        double   cobertura_media = 30.0;
+        double   dispersion      = 5.0;
+        int      dmrs            = 50;
+        uint32_t longitud_dmr    = 1000;
+        double   diferencia      = 0.6;
+        uint32_t semilla         = 1;
+    };
+
+    /**
+     * @brief región [inicio, fin] de un DMR plantado, en base 1
+     */
+    struct region
+    {
+        uint32_t inicio;
+        uint32_t fin;
+    };
+
+    /**
+     * @fn static bool generar(const parametros &, const QString &, QStringList &, QStringList &, QList<region> &, QString &)
+     * @brief Escribe <ruta>/case_<i> y <ruta>/control_<i> con el fichero methylation_map_mix_<chrom>.csv
+     * @param param         parámetros de la generación
+     * @param ruta          directorio donde crear las muestras
+     * @param lista_casos   directorios de las muestras caso generadas
+     * @param lista_control directorios de las muestras control generadas
+     * @param plantados     DMRs plantados, ordenados por posición
+     * @param error         descripción del error
+     * @return              false si los parámetros no son válidos o no se pueden escribir los ficheros
+     */
+    static bool generar(const parametros &param,
+                        const QString &ruta,
+                        QStringList &lista_casos,
+                        QStringList &lista_control,
+                        QList<region> &plantados,
+                        QString &error);
+
+    /**
+     * @fn static double sensibilidad(const QList<region> &, const QList<region> &, int &)
+     * @brief Fracción de los DMRs plantados que solapan con algún DMR encontrado
+     * @param plantados     DMRs plantados
+     * @param encontrados   DMRs encontrados por el análisis
+     * @param acertados     número de DMRs encontrados que solapan con algún DMR plantado
+     */
+    static double sensibilidad(const QList<region> &plantados, const QList<region> &encontrados, int &acertados);
+
+    /**
+     * @fn static bool leer_gff(const QString &, QList<region> &)
+     * @brief Lee las regiones de un fichero GFF de resultados
+     * @return  false si el fichero no existe, que equivale a no haber encontrado DMRs
+     */
+    static bool leer_gff(const QString &fichero, QList<region> &regiones);
+};
+
+#endif // GENERADOR_H
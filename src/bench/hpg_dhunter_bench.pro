@@ -0,0 +1,29 @@
+#-------------------------------------------------
+#
+# Medida de tiempos por etapa sobre muestras sintéticas
+# con DMRs plantados
+#
+#-------------------------------------------------
+
+QT          += core
+QT          -= gui
+
+TARGET       = hpg_dhunter_bench
+TEMPLATE     = app
+
+DEFINES     += QT_DEPRECATED_WARNINGS
+
+SOURCES     += main_bench.cpp \
+               generador.cpp
+
+HEADERS     += generador.h
+
+CONFIG      += console
+CONFIG      -= app_bundle
+CONFIG      += C++11
+
+DESTDIR      = $$system(pwd)
+OBJECTS_DIR  = $$DESTDIR/Obj
+
+# motor de identificación de DMRs (lectura, transformada en GPU y salida csv / gff)
+include(../engine.pri)
@@ -0,0 +1,278 @@
+/*
+*  hpg_dhunter_bench times every stage of the DMR identification on synthetic samples
+*  Copyright (C) 2018 Lisardo Fernández Cordeiro <lisardo.fernandez@uv.es>
+*
+*  This program is free software; you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation; either version 3, or (at your option)
+*  any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*  or see <https://www.gnu.org/licenses/>.
+*
+*/
+
+
+#include "dmr_config.h"
+#include "dmr_engine.h"
+#include "run_file.h"
+#include "telemetria.h"
+#include "generador.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+
+// etapas medidas, en el orden del proceso
+static const QStringList ETAPAS = {"index", "parse", "read", "union", "coarse", "scatter", "transfer",
+                                   "transform", "search", "pairs", "annotate", "refine", "counts", "permute",
+                                   "regions", "write", "merge", "run"};
+
+// ************************************************************************************************
+// lista de enteros separados por comas
+static QList<int> lista_enteros(const QString &texto, bool &ok)
+{
+    QList<int> lista;
+    ok = true;
+    foreach (const QString &valor, texto.split(','))
+    {
+        if (valor.trimmed().isEmpty())
+            continue;
+
+        int n = valor.trimmed().toInt(&ok);
+        if (!ok || n <= 0)
+        {
+            ok = false;
+            break;
+        }
+        lista << n;
+    }
+
+    return lista;
+}
+
+// ************************************************************************************************
+// una ejecución del motor sobre las muestras generadas, con los milisegundos de cada etapa
+static bool ejecutar(const dmr_config &config, QMap<QString, double> &tiempos)
+{
+    // sin resultados anteriores, que la ejecución daría por terminados
+    QDir(config.ruta_salida).removeRecursively();
+    QDir().mkpath(config.ruta_salida);
+
+    Telemetria::activar();
+
+    Dmr_engine engine;
+    bool completo = false;
+    QObject::connect(&engine, &Dmr_engine::error, [](QString texto) {
+        cerr << "error: " << texto.toStdString() << endl;
+    });
+    QObject::connect(&engine, &Dmr_engine::terminado, [&completo](bool c) {
+        completo = c;
+    });
+
+    engine.solicitud_proceso(config);
+    engine.proceso();
+
+    tiempos.clear();
+    foreach (const Telemetria::tramo &t, Telemetria::registrados())
+        tiempos[QString(t.etapa)] += t.duracion / 1000.0;
+
+    return completo;
+}
+
+// ************************************************************************************************
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("hpg_dhunter_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Times every stage of the DMR identification on synthetic samples "
+                                     "with planted DMRs and reports how many of them are found");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"samples",        "Total sample counts, half cases and half controls.",  "list", "4,16,32"},
+        {"lengths",        "Chromosome lengths in Mb.",                            "list", "1,10,50"},
+        {"work",           "Folder for the generated samples and the results.",   "dir",
+                           QDir::tempPath() + "/hpg_dhunter_bench"},
+        {"repeat",         "Runs per data set, the fastest time per stage is kept.", "n", "1"},
+        {"seed",           "Random seed of the generator.",                        "n", "1"},
+        {"cpg-density",    "Fraction of CpG positions outside islands.",           "x", "0.01"},
+        {"islands",        "CpG islands per Mb.",                                  "n", "20"},
+        {"island-density", "Fraction of CpG positions inside islands.",            "x", "0.15"},
+        {"coverage",       "Mean coverage per position.",                          "x", "30"},
+        {"dispersion",     "Negative binomial shape of the coverage.",             "x", "5"},
+        {"dmrs",           "Planted DMRs per Mb.",                                 "n", "5"},
+        {"dmr-length",     "Length of each planted DMR.",                          "n", "1000"},
+        {"difference",     "Methylation difference inside planted DMRs.",          "x", "0.6"},
+        {"min-coverage",   "Minimum coverage per position of the analysis.",       "n", "10"},
+        {"threshold",      "DMR threshold of the analysis in hundredths.",         "n", "30"},
+        {"level",          "Wavelet transform level of the analysis.",             "n", "6"},
+        {"reference",      "Genome reference of the analysis: none or grch37.",    "name", "grch37"},
+        {"min-recall",     "Exit with an error when a recall is below this value.", "x", "0"},
+        {"report",         "Write the results to this JSON file.",                 "file"},
+        {"generate-only",  "Only write the synthetic samples into the work folder."}
+    });
+    parser.process(a);
+
+    bool ok_muestras, ok_longitudes;
+    QList<int> muestras   = lista_enteros(parser.value("samples"), ok_muestras);
+    QList<int> longitudes = lista_enteros(parser.value("lengths"), ok_longitudes);
+    if (!ok_muestras || !ok_longitudes || muestras.isEmpty() || longitudes.isEmpty())
+    {
+        cerr << "invalid list of samples or lengths" << endl;
+        return 1;
+    }
+
+    QString trabajo    = parser.value("work");
+    int     repetir    = qMax(1, parser.value("repeat").toInt());
+    double  min_recall = parser.value("min-recall").toDouble();
+
+    cout << left << setw(8) << "samples" << setw(8) << "Mb";
+    foreach (const QString &etapa, ETAPAS)
+        cout << setw(11) << (etapa + "_ms").toStdString();
+    cout << setw(9) << "planted" << setw(7) << "found" << setw(8) << "recall" << "precision" << endl;
+
+    QJsonArray resultados;
+    bool       sensibilidad_ok = true;
+
+    foreach (int longitud, longitudes)
+    {
+        foreach (int n, muestras)
+        {
+            Generador::parametros param;
+            param.longitud        = uint32_t(longitud) * 1000000u;
+            param.casos           = qMax(1, n / 2);
+            param.controles       = qMax(1, n - n / 2);
+            param.densidad_cpg    = parser.value("cpg-density").toDouble();
+            param.islas           = parser.value("islands").toInt() * longitud;
+            param.densidad_isla   = parser.value("island-density").toDouble();
+            param.cobertura_media = parser.value("coverage").toDouble();
+            param.dispersion      = parser.value("dispersion").toDouble();
+            param.dmrs            = parser.value("dmrs").toInt() * longitud;
+            param.longitud_dmr    = parser.value("dmr-length").toUInt();
+            param.diferencia      = parser.value("difference").toDouble();
+            param.semilla         = parser.value("seed").toUInt();
+
+            // las muestras de cada combinación se generan de nuevo y se borran al acabar
+            QString ruta = trabajo + "/" + QString::number(n) + "_samples_" + QString::number(longitud) + "Mb";
+            QDir(ruta).removeRecursively();
+
+            QStringList              casos, controles;
+            QList<Generador::region> plantados;
+            QString                  texto_error;
+            if (!Generador::generar(param, ruta + "/samples", casos, controles, plantados, texto_error))
+            {
+                cerr << texto_error.toStdString() << endl;
+                return 1;
+            }
+
+            if (parser.isSet("generate-only"))
+            {
+                cerr << "samples written to " << ruta.toStdString() << endl;
+                continue;
+            }
+
+            // análisis sólo de mC en el cromosoma generado
+            QMap<QString, QStringList> opciones;
+            opciones["case"]        = casos;
+            opciones["control"]     = controles;
+            opciones["out"]         = QStringList(ruta + "/out");
+            opciones["chroms"]      = QStringList(QString::number(param.chrom));
+            opciones["signal"]      = QStringList("mc");
+            opciones["reference"]   = QStringList(parser.value("reference"));
+            opciones["mc-coverage"] = QStringList(parser.value("min-coverage"));
+            opciones["threshold"]   = QStringList(parser.value("threshold"));
+            opciones["level"]       = QStringList(parser.value("level"));
+
+            dmr_config config;
+            if (!Run_file::configurar(opciones, config, texto_error))
+            {
+                cerr << texto_error.toStdString() << endl;
+                return 1;
+            }
+
+            // el tiempo más corto de cada etapa entre todas las repeticiones
+            QMap<QString, double> mejores;
+            for (int r = 0; r < repetir; r++)
+            {
+                QMap<QString, double> tiempos;
+                if (!ejecutar(config, tiempos))
+                {
+                    cerr << "the analysis did not finish" << endl;
+                    return 2;
+                }
+                foreach (const QString &etapa, ETAPAS)
+                    if (r == 0 || tiempos.value(etapa) < mejores.value(etapa))
+                        mejores[etapa] = tiempos.value(etapa);
+            }
+
+            // DMRs encontrados frente a plantados
+            QList<Generador::region> encontrados;
+            Generador::leer_gff(config.ruta_salida + "/" + Dmr_engine::nombre_gff(config, 0), encontrados);
+            int    acertados = 0;
+            double recall    = Generador::sensibilidad(plantados, encontrados, acertados);
+            double precision = encontrados.isEmpty() ? 0.0 : double(acertados) / encontrados.size();
+            sensibilidad_ok &= recall >= min_recall;
+
+            cout << left << setw(8) << n << setw(8) << longitud << fixed << setprecision(1);
+            foreach (const QString &etapa, ETAPAS)
+                cout << setw(11) << mejores.value(etapa);
+            cout << setprecision(3) << setw(9) << plantados.size() << setw(7) << encontrados.size()
+                 << setw(8) << recall << precision << endl;
+
+            QJsonObject tiempos;
+            foreach (const QString &etapa, ETAPAS)
+                tiempos[etapa] = mejores.value(etapa);
+
+            QJsonObject resultado;
+            resultado["samples"]   = n;
+            resultado["length_mb"] = longitud;
+            resultado["ms"]        = tiempos;
+            resultado["planted"]   = plantados.size();
+            resultado["found"]     = encontrados.size();
+            resultado["recall"]    = recall;
+            resultado["precision"] = precision;
+            resultados.append(resultado);
+
+            QDir(ruta).removeRecursively();
+        }
+    }
+
+    if (parser.isSet("report"))
+    {
+        QJsonObject informe;
+        informe["results"] = resultados;
+
+        QSaveFile data(parser.value("report"));
+        if (!data.open(QIODevice::WriteOnly))
+        {
+            cerr << "An error occurred opening the file: " << parser.value("report").toStdString() << endl;
+            return 1;
+        }
+        data.write(QJsonDocument(informe).toJson());
+        data.commit();
+    }
+
+    if (!sensibilidad_ok)
+    {
+        cerr << "error: recall below " << min_recall << endl;
+        return 2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,314 @@
+#include "bgzf_writer.h"
+#include <zlib.h>
+#include <cstring>
+#include <cstdio>
+
+// tamaño máximo de datos sin comprimir por bloque, garantiza que el bloque comprimido cabe en 64 KiB
+static const size_t   BGZF_BLOQUE   = 0xff00;
+// bytes de cabecera y cola gzip de cada bloque BGZF
+static const size_t   BGZF_CABECERA = 18;
+static const size_t   BGZF_COLA     = 8;
+// bin ficticio donde tabix guarda los offsets y el número de registros de cada secuencia
+static const uint32_t BIN_PSEUDO    = 37450;
+// valor de ventana lineal aún no asignada
+static const uint64_t SIN_OFFSET    = ~uint64_t(0);
+
+// bloque vacío que marca el final de un fichero BGZF
+static const unsigned char BGZF_EOF[28] = {0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00,
+                                           0x00, 0xff, 0x06, 0x00, 0x42, 0x43, 0x02, 0x00,
+                                           0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                           0x00, 0x00, 0x00, 0x00};
+
+// escritura little-endian de enteros en el buffer del índice
+template <typename T>
+static void anyadir(vector<char> &v, T valor)
+{
+    for (size_t i = 0; i < sizeof(T); i++)
+        v.push_back(char((uint64_t(valor) >> (8 * i)) & 0xff));
+}
+
+Bgzf_writer::Bgzf_writer()
+{
+    off_bloque = 0;
+    ordenado   = true;
+}
+
+// ************************************************************************************************
+Bgzf_writer::~Bgzf_writer()
+{
+    if (abierto())
+        cerrar();
+}
+
+// ************************************************************************************************
+bool Bgzf_writer::abrir(const string &ficherox)
+{
+    if (abierto())
+        cerrar();
+
+    // se escribe en un temporal que cerrar() renombra, así nunca queda un fichero final a medias
+    fichero = ficherox;
+    salida.open(fichero + ".tmp", ios::binary | ios::trunc);
+
+    buffer.clear();
+    buffer.reserve(2 * BGZF_BLOQUE);
+    off_bloque = 0;
+    nombres.clear();
+    indices.clear();
+    ordenado   = true;
+
+    return salida.is_open();
+}
+
+// ************************************************************************************************
+bool Bgzf_writer::abierto() const
+{
+    return salida.is_open();
+}
+
+// ************************************************************************************************
+uint64_t Bgzf_writer::offset_virtual() const
+{
+    return (off_bloque << 16) | uint64_t(buffer.size());
+}
+
+// ************************************************************************************************
+void Bgzf_writer::escribir_registro(const string &secuencia, uint32_t inicio, uint32_t fin, const string &linea)
+{
+    if (!abierto())
+        return;
+
+    // tabix trabaja con intervalos semiabiertos en base 0
+    uint32_t beg = inicio > 0 ? inicio - 1 : 0;
+    uint32_t end = fin > beg ? fin : beg + 1;
+
+    // nueva secuencia -> debe ser la primera vez que aparece para que el fichero sea indexable
+    if (nombres.empty() || nombres.back() != secuencia)
+    {
+        for (const string &n : nombres)
+            if (n == secuencia)
+                ordenado = false;
+
+        nombres.push_back(secuencia);
+        indice_secuencia nueva;
+        nueva.off_inicio    = offset_virtual();
+        nueva.off_fin       = nueva.off_inicio;
+        nueva.registros     = 0;
+        nueva.ultimo_inicio = 0;
+        indices.push_back(nueva);
+    }
+
+    indice_secuencia &idx = indices.back();
+    if (beg < idx.ultimo_inicio)
+        ordenado = false;
+    idx.ultimo_inicio = beg;
+
+    // escribe la línea en el buffer y comprime los bloques completos
+    uint64_t off_ini = offset_virtual();
+    buffer.insert(buffer.end(), linea.begin(), linea.end());
+    while (buffer.size() >= BGZF_BLOQUE && vaciar_bloque())
+        ;
+    uint64_t off_fin = offset_virtual();
+
+    // índice jerárquico por bins, fusionando con el chunk anterior si son contiguos
+    vector<pair<uint64_t, uint64_t>> &chunks = idx.bins[reg2bin(beg, end)];
+    if (!chunks.empty() && chunks.back().second == off_ini)
+        chunks.back().second = off_fin;
+    else
+        chunks.push_back(make_pair(off_ini, off_fin));
+
+    // índice lineal por ventanas de 16 kb
+    uint32_t v_ini = beg >> 14;
+    uint32_t v_fin = (end - 1) >> 14;
+    if (idx.lineal.size() <= v_fin)
+        idx.lineal.resize(v_fin + 1, SIN_OFFSET);
+    for (uint32_t v = v_ini; v <= v_fin; v++)
+        if (idx.lineal[v] == SIN_OFFSET)
+            idx.lineal[v] = off_ini;
+
+    idx.off_fin = off_fin;
+    idx.registros++;
+}
+
+// ************************************************************************************************
+bool Bgzf_writer::vaciar_bloque()
+{
+    size_t num = buffer.size() < BGZF_BLOQUE ? buffer.size() : BGZF_BLOQUE;
+    vector<char> bloque;
+
+    if (num == 0 || !comprimir_bloque(buffer.data(), num, bloque))
+        return false;
+
+    salida.write(bloque.data(), streamsize(bloque.size()));
+    off_bloque += bloque.size();
+    buffer.erase(buffer.begin(), buffer.begin() + long(num));
+
+    return true;
+}
+
+// ************************************************************************************************
+bool Bgzf_writer::comprimir_bloque(const char *datos, size_t num, vector<char> &bloque)
+{
+    bloque.assign(65536, 0);
+
+    // deflate crudo sin cabecera zlib, la cabecera gzip con el campo extra BC se escribe a mano
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+
+    zs.next_in   = reinterpret_cast<Bytef *>(const_cast<char *>(datos));
+    zs.avail_in  = uInt(num);
+    zs.next_out  = reinterpret_cast<Bytef *>(&bloque[BGZF_CABECERA]);
+    zs.avail_out = uInt(bloque.size() - BGZF_CABECERA - BGZF_COLA);
+
+    int estado = deflate(&zs, Z_FINISH);
+    size_t comprimido = zs.total_out;
+    deflateEnd(&zs);
+
+    if (estado != Z_STREAM_END)
+        return false;
+
+    size_t total = BGZF_CABECERA + comprimido + BGZF_COLA;
+    bloque.resize(total);
+
+    // cabecera gzip con subcampo BC que indica el tamaño total del bloque - 1
+    const unsigned char cabecera[16] = {0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00,
+                                        0x00, 0xff, 0x06, 0x00, 0x42, 0x43, 0x02, 0x00};
+    memcpy(&bloque[0], cabecera, 16);
+    bloque[16] = char((total - 1) & 0xff);
+    bloque[17] = char(((total - 1) >> 8) & 0xff);
+
+    // cola gzip: CRC32 y tamaño sin comprimir
+    uLong crc = crc32(0L, reinterpret_cast<const Bytef *>(datos), uInt(num));
+    for (size_t i = 0; i < 4; i++)
+    {
+        bloque[BGZF_CABECERA + comprimido + i]     = char((crc >> (8 * i)) & 0xff);
+        bloque[BGZF_CABECERA + comprimido + 4 + i] = char((num >> (8 * i)) & 0xff);
+    }
+
+    return true;
+}
+
+// ************************************************************************************************
+uint32_t Bgzf_writer::reg2bin(uint32_t inicio, uint32_t fin)
+{
+    --fin;
+    if (inicio >> 14 == fin >> 14) return ((1 << 15) - 1) / 7 + (inicio >> 14);
+    if (inicio >> 17 == fin >> 17) return ((1 << 12) - 1) / 7 + (inicio >> 17);
+    if (inicio >> 20 == fin >> 20) return ((1 <<  9) - 1) / 7 + (inicio >> 20);
+    if (inicio >> 23 == fin >> 23) return ((1 <<  6) - 1) / 7 + (inicio >> 23);
+    if (inicio >> 26 == fin >> 26) return ((1 <<  3) - 1) / 7 + (inicio >> 26);
+    return 0;
+}
+
+// ************************************************************************************************
+bool Bgzf_writer::cerrar()
+{
+    if (!abierto())
+        return false;
+
+    // vacía el último bloque parcial y añade el bloque de fin de fichero
+    while (!buffer.empty() && vaciar_bloque())
+        ;
+    salida.write(reinterpret_cast<const char *>(BGZF_EOF), sizeof(BGZF_EOF));
+    bool datos_ok = salida.good();
+    salida.close();
+
+    if (!datos_ok || rename((fichero + ".tmp").c_str(), fichero.c_str()) != 0)
+    {
+        remove((fichero + ".tmp").c_str());
+        return false;
+    }
+
+    // sin orden no hay índice válido: se elimina uno anterior para no dejarlo desfasado
+    bool indice_ok = ordenado && guardar_indice() &&
+                     rename((fichero + ".tbi.tmp").c_str(), (fichero + ".tbi").c_str()) == 0;
+    if (!indice_ok)
+    {
+        remove((fichero + ".tbi.tmp").c_str());
+        remove((fichero + ".tbi").c_str());
+    }
+
+    return indice_ok;
+}
+
+// ************************************************************************************************
+bool Bgzf_writer::guardar_indice()
+{
+    vector<char> tbi;
+
+    // cabecera tabix con el preset gff: formato genérico, columnas 1, 4 y 5, comentarios '#'
+    tbi.push_back('T'); tbi.push_back('B'); tbi.push_back('I'); tbi.push_back(1);
+    anyadir<int32_t>(tbi, int32_t(nombres.size()));
+    anyadir<int32_t>(tbi, 0);
+    anyadir<int32_t>(tbi, 1);
+    anyadir<int32_t>(tbi, 4);
+    anyadir<int32_t>(tbi, 5);
+    anyadir<int32_t>(tbi, '#');
+    anyadir<int32_t>(tbi, 0);
+
+    // nombres de las secuencias terminados en '\0'
+    int32_t l_nm = 0;
+    for (const string &n : nombres)
+        l_nm += int32_t(n.size() + 1);
+    anyadir<int32_t>(tbi, l_nm);
+    for (const string &n : nombres)
+    {
+        tbi.insert(tbi.end(), n.begin(), n.end());
+        tbi.push_back('\0');
+    }
+
+    for (indice_secuencia &idx : indices)
+    {
+        // bins con sus chunks más el pseudo-bin de estadísticas
+        anyadir<int32_t>(tbi, int32_t(idx.bins.size() + 1));
+        for (const auto &b : idx.bins)
+        {
+            anyadir<uint32_t>(tbi, b.first);
+            anyadir<int32_t>(tbi, int32_t(b.second.size()));
+            for (const auto &c : b.second)
+            {
+                anyadir<uint64_t>(tbi, c.first);
+                anyadir<uint64_t>(tbi, c.second);
+            }
+        }
+        anyadir<uint32_t>(tbi, BIN_PSEUDO);
+        anyadir<int32_t>(tbi, 2);
+        anyadir<uint64_t>(tbi, idx.off_inicio);
+        anyadir<uint64_t>(tbi, idx.off_fin);
+        anyadir<uint64_t>(tbi, idx.registros);
+        anyadir<uint64_t>(tbi, 0);
+
+        // ventanas sin registros heredan el offset de la anterior
+        uint64_t anterior = 0;
+        anyadir<int32_t>(tbi, int32_t(idx.lineal.size()));
+        for (uint64_t &off : idx.lineal)
+        {
+            if (off == SIN_OFFSET)
+                off = anterior;
+            anterior = off;
+            anyadir<uint64_t>(tbi, off);
+        }
+    }
+
+    // registros sin coordenadas
+    anyadir<uint64_t>(tbi, 0);
+
+    // el índice también se guarda comprimido en BGZF
+    ofstream indice(fichero + ".tbi.tmp", ios::binary | ios::trunc);
+    if (!indice.is_open())
+        return false;
+
+    vector<char> bloque;
+    for (size_t i = 0; i < tbi.size(); i += BGZF_BLOQUE)
+    {
+        size_t num = tbi.size() - i < BGZF_BLOQUE ? tbi.size() - i : BGZF_BLOQUE;
+        if (!comprimir_bloque(&tbi[i], num, bloque))
+            return false;
+        indice.write(bloque.data(), streamsize(bloque.size()));
+    }
+    indice.write(reinterpret_cast<const char *>(BGZF_EOF), sizeof(BGZF_EOF));
+
+    return indice.good();
+}
@@ -0,0 +1,128 @@
+#ifndef BGZF_WRITER_H
+#define BGZF_WRITER_H
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Escritura de ficheros de texto comprimidos en formato BGZF (bloques gzip concatenados)
+ *        con construcción simultánea del índice tabix (.tbi) compatible con htslib.
+ *
+ *        Los registros deben llegar agrupados por secuencia (cromosoma) y ordenados por posición
+ *        inicial dentro de cada secuencia, que es el orden en el que el proceso genera los DMRs.
+ *        Las coordenadas se reciben como en GFF: base 1 e intervalo cerrado [inicio, fin].
+ */
+class Bgzf_writer
+{
+public:
+    Bgzf_writer();
+    ~Bgzf_writer();
+
+    /**
+     * @fn bool abrir(const string &)
+     * @brief Crea el fichero comprimido en fichero + ".tmp" y prepara el índice
+     * @param fichero   ruta del fichero .gz a generar, el índice se guarda en fichero + ".tbi"
+     * @return          true si el fichero se ha abierto correctamente
+     */
+    bool abrir(const string &fichero);
+
+    /**
+     * @fn bool abierto() const
+     * @brief Informa si hay un fichero abierto para escritura
+     */
+    bool abierto() const;
+
+    /**
+     * @fn void escribir_registro(const string &, uint32_t, uint32_t, const string &)
+     * @brief Añade una línea al fichero comprimido y la registra en el índice
+     * @param secuencia nombre de la secuencia (columna 1 del GFF)
+     * @param inicio    posición inicial, base 1 (columna 4 del GFF)
+     * @param fin       posición final, base 1 incluida (columna 5 del GFF)
+     * @param linea     línea completa terminada en '\n'
+     */
+    void escribir_registro(const string &secuencia, uint32_t inicio, uint32_t fin, const string &linea);
+
+    /**
+     * @fn bool cerrar()
+     * @brief Vacía el último bloque, escribe el bloque EOF y guarda el índice tabix; ambos ficheros
+     *        se renombran a su nombre final sólo cuando están completos
+     * @return          true si el índice es válido (registros agrupados y ordenados)
+     */
+    bool cerrar();
+
+private:
+    /**
+     * @brief índice de una secuencia
+     * @param bins          chunks [inicio, fin) de offsets virtuales por bin de la jerarquía de BAM
+     * @param lineal        menor offset virtual de cada ventana de 16 kb
+     * @param off_inicio    offset virtual del primer registro de la secuencia
+     * @param off_fin       offset virtual tras el último registro de la secuencia
+     * @param registros     número de registros de la secuencia
+     * @param ultimo_inicio posición del último registro para comprobar el orden
+     */
+    struct indice_secuencia
+    {
+        map<uint32_t, vector<pair<uint64_t, uint64_t>>> bins;
+        vector<uint64_t> lineal;
+        uint64_t off_inicio;
+        uint64_t off_fin;
+        uint64_t registros;
+        uint32_t ultimo_inicio;
+    };
+
+    /**
+     * @fn uint64_t offset_virtual() const
+     * @brief Offset virtual BGZF de la posición actual: (offset del bloque << 16) | offset en bloque
+     */
+    uint64_t offset_virtual() const;
+
+    /**
+     * @fn bool vaciar_bloque()
+     * @brief Comprime el contenido del buffer como un bloque BGZF y lo escribe en disco
+     * @return          false si no había datos o no se ha podido comprimir
+     */
+    bool vaciar_bloque();
+
+    /**
+     * @fn static bool comprimir_bloque(const char *, size_t, vector<char> &)
+     * @brief Comprime datos (como máximo un bloque) en un bloque BGZF completo
+     */
+    static bool comprimir_bloque(const char *datos, size_t num, vector<char> &bloque);
+
+    /**
+     * @fn static uint32_t reg2bin(uint32_t, uint32_t)
+     * @brief Bin más pequeño que contiene el intervalo [inicio, fin) con 14 bits de ventana y 5 niveles
+     */
+    static uint32_t reg2bin(uint32_t inicio, uint32_t fin);
+
+    /**
+     * @fn bool guardar_indice()
+     * @brief Serializa el índice tabix y lo escribe como fichero BGZF independiente
+     */
+    bool guardar_indice();
+
+    /**
+     * @brief variables internas
+     * @param fichero       ruta del fichero comprimido
+     * @param salida        fichero comprimido en disco
+     * @param buffer        datos sin comprimir pendientes del bloque actual
+     * @param off_bloque    offset en disco del bloque que se está llenando
+     * @param nombres       secuencias en orden de aparición
+     * @param indices       índice de cada secuencia en el mismo orden que nombres
+     * @param ordenado      se mantiene a true mientras los registros lleguen agrupados y ordenados
+     */
+    string                   fichero;
+    ofstream                 salida;
+    vector<char>             buffer;
+    uint64_t                 off_bloque;
+    vector<string>           nombres;
+    vector<indice_secuencia> indices;
+    bool                     ordenado;
+};
+
+#endif // BGZF_WRITER_H
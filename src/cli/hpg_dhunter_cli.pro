@@ -0,0 +1,26 @@
+#-------------------------------------------------
+#
+# Aplicación de línea de comandos para identificación de DMRs
+# en lote, sin interfaz gráfica
+#
+#-------------------------------------------------
+
+QT          += core
+QT          -= gui
+
+TARGET       = hpg_dhunter_cli
+TEMPLATE     = app
+
+DEFINES     += QT_DEPRECATED_WARNINGS
+
+SOURCES     += main_cli.cpp
+
+CONFIG      += console
+CONFIG      -= app_bundle
+CONFIG      += C++11
+
+DESTDIR      = $$system(pwd)
+OBJECTS_DIR  = $$DESTDIR/Obj
+
+# motor de identificación de DMRs (lectura, transformada en GPU y salida csv / gff)
+include(../engine.pri)
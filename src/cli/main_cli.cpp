@@ -0,0 +1,313 @@
+/*
+*  hpg_dhunter_cli runs the DMR identification engine without graphical interface
+*  Copyright (C) 2018 Lisardo Fernández Cordeiro <lisardo.fernandez@uv.es>
+*
+*  This program is free software; you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation; either version 3, or (at your option)
+*  any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*  or see <https://www.gnu.org/licenses/>.
+*
+*/
+
+
+#include "arena.h"
+#include "contigs.h"
+#include "dmr_config.h"
+#include "dmr_engine.h"
+#include "planificador.h"
+#include "run_file.h"
+#include "shards.h"
+#include "telemetria.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <QProcess>
+#include <iostream>
+
+using namespace std;
+
+// ************************************************************************************************
+// ejecuta los shards en procesos hijos de este mismo ejecutable, con como mucho 'procesos' hijos a
+// la vez y, si se indica, sin pasar de 'memoria_mb' entre todos, y fusiona los resultados como lo
+// haría --merge; los contigs pequeños van en lotes y los lotes se lanzan del más costoso al menos
+static int ejecutar_procesos(const QList<dmr_config> &trabajos, int procesos, int memoria_mb)
+{
+    // argumentos de la llamada actual sin las opciones del reparto
+    QStringList argumentos = QCoreApplication::arguments().mid(1);
+    for (int i = 0; i < argumentos.size(); i++)
+    {
+        if (argumentos.at(i) == "--processes" || argumentos.at(i) == "--host-memory")
+            argumentos.erase(argumentos.begin() + i, argumentos.begin() + qMin(i + 2, argumentos.size()));
+        else if (argumentos.at(i).startsWith("--processes=") || argumentos.at(i).startsWith("--host-memory="))
+            argumentos.removeAt(i);
+        else
+            continue;
+        i--;
+    }
+
+    QList<QList<int>> cola        = Planificador::lotes(trabajos, procesos);
+    qint64            presupuesto = qint64(memoria_mb) * 1024 * 1024;
+    qint64            ocupada     = 0;
+    QList<QProcess*>  activos;
+    QStringList       fallidos;
+    QMap<QProcess*, QString> lote;
+    QMap<QProcess*, qint64>  reserva;
+
+    while (!cola.isEmpty() || !activos.isEmpty())
+    {
+        // lanza shards mientras haya hueco, el primer lote de la cola que cabe en la memoria libre
+        // ..sin procesos activos el primero se lanza aunque no quepa
+        while (activos.size() < procesos && !cola.isEmpty())
+        {
+            int siguiente = 0;
+            if (presupuesto > 0 && !activos.isEmpty())
+                for (siguiente = 0; siguiente < cola.size(); siguiente++)
+                    if (ocupada + Planificador::memoria(trabajos, cola.at(siguiente)) <= presupuesto)
+                        break;
+            if (siguiente == cola.size())
+                break;
+
+            QList<int>  chroms = cola.takeAt(siguiente);
+            QStringList nombres;
+            foreach (int chrom, chroms)
+                nombres << Contigs::nombre(chrom);
+
+            QProcess *p = new QProcess();
+            p->setProcessChannelMode(QProcess::ForwardedChannels);
+            p->start(QCoreApplication::applicationFilePath(),
+                     QStringList(argumentos) << "--shard" << nombres.join(","));
+            activos << p;
+            lote[p]    = nombres.join(",");
+            reserva[p] = Planificador::memoria(trabajos, chroms);
+            ocupada   += reserva[p];
+            cerr << "shard chromosome " << lote[p].toStdString() << " started" << endl;
+        }
+
+        // recoge los que han terminado
+        for (int i = 0; i < activos.size(); i++)
+        {
+            QProcess *p = activos.at(i);
+            if (!p->waitForFinished(200) && p->state() != QProcess::NotRunning)
+                continue;
+
+            if (p->exitStatus() != QProcess::NormalExit || p->exitCode() != 0)
+                fallidos << lote[p];
+            cerr << "shard chromosome " << lote[p].toStdString() << " finished" << endl;
+
+            ocupada -= reserva[p];
+            activos.removeAt(i--);
+            delete p;
+        }
+    }
+
+    QStringList avisos;
+    QString     texto_error;
+    bool        fusionado = Shards::fusionar(trabajos, avisos, texto_error);
+
+    foreach (const QString &aviso, avisos)
+        cerr << "error: " << aviso.toStdString() << endl;
+    if (!fusionado)
+        cerr << "error: " << texto_error.toStdString() << endl;
+
+    return (fusionado && fallidos.isEmpty() && avisos.isEmpty()) ? 0 : 2;
+}
+
+// ************************************************************************************************
+// guarda la telemetría de esta ejecución si se ha pedido, cada shard en sus propios ficheros
+static int terminar(const QCommandLineParser &parser, int codigo)
+{
+    if (!parser.isSet("telemetry"))
+        return codigo;
+
+    QString prefijo = parser.value("telemetry");
+    if (parser.isSet("shard"))
+        prefijo += ".chr" + QString(parser.value("shard")).replace(',', '_');
+
+    QString texto_error;
+    if (!Telemetria::guardar(prefijo, texto_error))
+    {
+        cerr << "error: " << texto_error.toStdString() << endl;
+        return codigo ? codigo : 2;
+    }
+
+    return codigo;
+}
+
+// ************************************************************************************************
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("hpg_dhunter_cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("DMR identification with DWT, batch mode without graphical interface");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"run",          "JSON run file with several jobs processed together.",          "file"},
+        {"memory",       "Memory limit in MiB for samples shared between jobs.",         "n"},
+        {"list-shards",  "Print the chromosomes (shards) of the run, one per line, largest first."},
+        {"shard",        "Process only this chromosome, or comma separated list, into <out>/shards for a later merge.", "chrom"},
+        {"merge",        "Merge the results of all finished shards into the output folder."},
+        {"processes",    "Run the shards in up to n local processes and merge them.",    "n"},
+        {"host-memory",  "Memory budget in MiB for all the --processes shards together.", "n"},
+        {"telemetry",    "Write per-stage timings to <prefix>.json and <prefix>.trace.json.", "prefix"},
+        {"profile",      "Add hardware counters (IPC, LLC and branch misses) to the telemetry."},
+        {"huge-pages",   "Ask for transparent huge pages for the large buffers."},
+        {"scratch",      "Out-of-core mode: keep samples and coefficients in files on this local disk.", "dir"},
+        {"streaming",    "Read, transform and add up one sample at a time, memory independent of the cohort size."},
+        {"case",         "Case sample folder (repeat for each case).",                   "dir"},
+        {"control",      "Control sample folder (repeat for each control).",             "dir"},
+        {"out",          "Output folder for csv and gff files.",                         "dir"},
+        {"chroms",       "Chromosomes or contigs to analyze, comma separated list or 'all'.", "list"},
+        {"fai",          "FASTA index (.fai) with the contigs and lengths for 'all'.",   "file"},
+        {"reference",    "Genome reference: none or grch37.",                            "name"},
+        {"signal",       "Signal to analyze: mc, hmc or both.",                          "type"},
+        {"strand",       "Strand files to read: forward, reverse or both.",              "type"},
+        {"mc-coverage",  "Minimum coverage per position for mC.",                        "n"},
+        {"hmc-coverage", "Minimum coverage per position for hmC.",                       "n"},
+        {"threshold",    "DMR threshold in hundredths (30 -> 0.30).",                    "n"},
+        {"level",        "Wavelet transform level.",                                     "n"},
+        {"density",      "Minimum percentage of methylated positions per region.",       "n"},
+        {"samples",      "Minimum percentage of covered samples per group and region.",  "n"},
+        {"stationary",   "Stationary transform: a 2^level window from every methylated position, not a fixed grid."},
+        {"refine",       "Trim each DMR to its outermost differential CpGs, comparing per-position ratios."},
+        {"coarse-level", "Hierarchical search: find candidates at this level, then test only them at --level.", "n"},
+        {"cpg-space",    "Transform over the covered CpGs of all samples instead of every base position."},
+        {"sample-sheet", "Tab separated folder and group per line, instead of --case/--control.", "file"},
+        {"contrasts",    "Group contrasts of the sample sheet: A:B pairs, all (default) or any.", "list"},
+        {"pairwise",     "Also compare single samples: all (every pair) or control (each case against the control mean).", "mode"},
+        {"pairwise-lists", "With --pairwise, also write the DMRs of every pair per chromosome."},
+        {"permutations", "Empirical p-value of every DMR from n case/control label permutations, with FDR.", "n"},
+        {"beta-binomial", "P-value of every DMR from a beta-binomial test on the read counts of its CpGs."},
+        {"regions",      "BED file of target regions: only the windows covering them are read and tested.", "file"}
+    });
+    parser.process(a);
+
+    QList<dmr_config> trabajos;
+    int     memoria_mb = 0;
+    QString texto_error;
+
+    if (parser.isSet("run"))
+    {
+        // todos los trabajos se describen en el fichero de ejecución
+        if (!Run_file::leer(parser.value("run"), trabajos, memoria_mb, texto_error))
+        {
+            cerr << texto_error.toStdString() << endl;
+            return 1;
+        }
+    }
+    else
+    {
+        // un único trabajo con las opciones de la línea de comandos
+        QMap<QString, QStringList> opciones;
+        foreach (const QString &opcion, Run_file::opciones())
+            if (parser.isSet(opcion))
+                opciones[opcion] = parser.values(opcion);
+
+        // ..o uno por contraste con una hoja de muestras
+        if (!Run_file::configurar_trabajos(opciones, trabajos, texto_error))
+        {
+            cerr << texto_error.toStdString() << endl;
+            return 1;
+        }
+    }
+
+    if (parser.isSet("memory"))
+        memoria_mb = parser.value("memory").toInt();
+
+    if (parser.isSet("profile") && !parser.isSet("telemetry"))
+    {
+        cerr << "--profile needs --telemetry" << endl;
+        return 1;
+    }
+
+    // la comparación muestra a muestra y las permutaciones necesitan todas las transformadas a la vez
+    foreach (const dmr_config &config, trabajos)
+        if (parser.isSet("streaming") && (!config.pares.isEmpty() || config.permutaciones > 0))
+        {
+            cerr << "--pairwise and --permutations cannot be combined with --streaming" << endl;
+            return 1;
+        }
+    if (parser.isSet("scratch") && !QFileInfo(parser.value("scratch")).isDir())
+    {
+        cerr << "scratch folder not found: " << parser.value("scratch").toStdString() << endl;
+        return 1;
+    }
+    Arena::configurar(parser.isSet("huge-pages"), parser.value("scratch"));
+
+    if (parser.isSet("telemetry"))
+    {
+        // sin contadores hardware la telemetría sigue midiendo tiempos y volúmenes
+        Telemetria::activar(parser.isSet("profile"));
+        if (!Telemetria::estado_contadores().isEmpty())
+            cerr << "hardware counters: " << Telemetria::estado_contadores().toStdString() << endl;
+    }
+
+    // ejecución repartida por cromosomas
+    if (parser.isSet("list-shards"))
+    {
+        foreach (int chrom, Planificador::orden(trabajos))
+            cout << Contigs::nombre(chrom).toStdString() << endl;
+        return 0;
+    }
+
+    if (parser.isSet("merge"))
+    {
+        QStringList avisos;
+        bool fusionado = Shards::fusionar(trabajos, avisos, texto_error);
+        foreach (const QString &aviso, avisos)
+            cerr << "error: " << aviso.toStdString() << endl;
+        if (!fusionado)
+            cerr << "error: " << texto_error.toStdString() << endl;
+
+        return terminar(parser, (fusionado && avisos.isEmpty()) ? 0 : 2);
+    }
+
+    if (parser.isSet("processes"))
+    {
+        int procesos = parser.value("processes").toInt();
+        if (procesos < 1)
+        {
+            cerr << "invalid value for processes: " << parser.value("processes").toStdString() << endl;
+            return 1;
+        }
+        return terminar(parser, ejecutar_procesos(trabajos, procesos, parser.value("host-memory").toInt()));
+    }
+
+    if (parser.isSet("shard") && !Shards::preparar(trabajos, Contigs::lista(parser.value("shard")), texto_error))
+    {
+        cerr << texto_error.toStdString() << endl;
+        return 1;
+    }
+
+    // el motor se ejecuta en el hilo principal, informando por la salida de errores
+    Dmr_engine engine;
+    bool completo = false;
+    bool errores  = false;
+    QObject::connect(&engine, &Dmr_engine::mensaje, [](QString texto) {
+        cerr << texto.toStdString() << endl;
+    });
+    QObject::connect(&engine, &Dmr_engine::error, [&errores](QString texto) {
+        errores = true;
+        cerr << "error: " << texto.toStdString() << endl;
+    });
+    QObject::connect(&engine, &Dmr_engine::terminado, [&completo](bool c) {
+        completo = c;
+    });
+
+    engine.modo_por_muestra(parser.isSet("streaming"));
+    engine.solicitud_proceso(trabajos, memoria_mb);
+    engine.proceso();
+
+    return terminar(parser, (completo && !errores) ? 0 : 2);
+}
@@ -0,0 +1,202 @@
+#include "contadores.h"
+#include <QStringList>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+
+// grupo de contadores de un hilo, se cierra al terminar el hilo
+struct grupo_contadores
+{
+    int     fd[Contadores::NUM_CONTADORES];
+    int     posicion[Contadores::NUM_CONTADORES];   // posición en la lectura del grupo, -1 sin contador
+    int     lider;
+    int     miembros;
+    bool    intentado;
+    QString motivo;                                 // contadores que no se han podido abrir
+
+    grupo_contadores()
+    {
+        for (int c = 0; c < Contadores::NUM_CONTADORES; c++)
+        {
+            fd[c]       = -1;
+            posicion[c] = -1;
+        }
+        lider     = -1;
+        miembros  = 0;
+        intentado = false;
+    }
+
+    ~grupo_contadores()
+    {
+        for (int c = 0; c < Contadores::NUM_CONTADORES; c++)
+            if (fd[c] >= 0)
+                close(fd[c]);
+    }
+};
+
+static thread_local grupo_contadores grupo_hilo;
+
+// ************************************************************************************************
+// abre un contador del hilo actual en modo usuario, como líder o dentro del grupo del líder
+static int abrir_contador(uint32_t tipo, uint64_t configuracion, int lider)
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = tipo;
+    attr.config         = configuracion;
+    attr.disabled       = lider < 0 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return int(syscall(__NR_perf_event_open, &attr, 0, -1, lider, 0));
+}
+
+// ************************************************************************************************
+// abre el grupo del hilo actual con los contadores que se puedan abrir
+static bool abrir_grupo(grupo_contadores &g, QString &motivo)
+{
+    g.intentado = true;
+
+    // los fallos de LLC se piden como fallos de lectura de la caché de último nivel y, si el
+    // procesador no los ofrece, como el evento genérico de fallos de caché
+    const uint64_t llc = PERF_COUNT_HW_CACHE_LL |
+                         (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+    int error_lider = 0;
+    for (int c = 0; c < Contadores::NUM_CONTADORES; c++)
+    {
+        int fd = -1;
+        switch (c)
+        {
+        case Contadores::CICLOS:
+            fd = abrir_contador(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, g.lider);
+            break;
+        case Contadores::INSTRUCCIONES:
+            fd = abrir_contador(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, g.lider);
+            break;
+        case Contadores::FALLOS_LLC:
+            fd = abrir_contador(PERF_TYPE_HW_CACHE, llc, g.lider);
+            if (fd < 0)
+                fd = abrir_contador(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, g.lider);
+            break;
+        case Contadores::FALLOS_SALTO:
+            fd = abrir_contador(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, g.lider);
+            break;
+        }
+
+        if (fd < 0)
+        {
+            if (g.lider < 0)
+                error_lider = errno;
+            continue;
+        }
+
+        g.fd[c]       = fd;
+        g.posicion[c] = g.miembros++;
+        if (g.lider < 0)
+            g.lider = fd;
+    }
+
+    if (g.lider < 0)
+    {
+        g.motivo = QString("perf_event_open: ") + strerror(error_lider);
+        if (error_lider == EACCES || error_lider == EPERM)
+            g.motivo += " (see /proc/sys/kernel/perf_event_paranoid)";
+        motivo = g.motivo;
+        return false;
+    }
+
+    QStringList faltan;
+    for (int c = 0; c < Contadores::NUM_CONTADORES; c++)
+        if (g.fd[c] < 0)
+            faltan << Contadores::nombre(c);
+    g.motivo = faltan.isEmpty() ? QString() : "not available: " + faltan.join(", ");
+    motivo   = g.motivo;
+
+    ioctl(g.lider, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(g.lider, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    return true;
+}
+
+// ************************************************************************************************
+bool Contadores::disponibles(QString &motivo)
+{
+    if (grupo_hilo.intentado)
+    {
+        motivo = grupo_hilo.motivo;
+        return grupo_hilo.lider >= 0;
+    }
+
+    return abrir_grupo(grupo_hilo, motivo);
+}
+
+// ************************************************************************************************
+bool Contadores::leer(valores &lectura)
+{
+    for (int c = 0; c < NUM_CONTADORES; c++)
+        lectura.cuenta[c] = -1;
+
+    QString motivo;
+    if (!grupo_hilo.intentado)
+        abrir_grupo(grupo_hilo, motivo);
+    if (grupo_hilo.lider < 0)
+        return false;
+
+    // formato de lectura del grupo: número de contadores, tiempo activo, tiempo contando, valores
+    uint64_t datos[3 + NUM_CONTADORES];
+    ssize_t  leidos = read(grupo_hilo.lider, datos, sizeof(datos));
+    if (leidos < ssize_t(3 * sizeof(uint64_t)) || datos[0] != uint64_t(grupo_hilo.miembros))
+        return false;
+
+    // si el núcleo ha repartido los contadores en el tiempo se extrapola al tiempo activo
+    double escala = (datos[2] > 0 && datos[2] < datos[1]) ? double(datos[1]) / double(datos[2]) : 1.0;
+    for (int c = 0; c < NUM_CONTADORES; c++)
+        if (grupo_hilo.posicion[c] >= 0)
+            lectura.cuenta[c] = qint64(double(datos[3 + grupo_hilo.posicion[c]]) * escala);
+
+    return true;
+}
+
+#else
+
+// ************************************************************************************************
+bool Contadores::disponibles(QString &motivo)
+{
+    motivo = "hardware counters need Linux perf_event_open";
+    return false;
+}
+
+// ************************************************************************************************
+bool Contadores::leer(valores &lectura)
+{
+    for (int c = 0; c < NUM_CONTADORES; c++)
+        lectura.cuenta[c] = -1;
+
+    return false;
+}
+
+#endif
+
+// ************************************************************************************************
+const char *Contadores::nombre(int c)
+{
+    switch (c)
+    {
+    case CICLOS:        return "cycles";
+    case INSTRUCCIONES: return "instructions";
+    case FALLOS_LLC:    return "llc_misses";
+    case FALLOS_SALTO:  return "branch_misses";
+    }
+
+    return "";
+}
@@ -0,0 +1,54 @@
+#ifndef CONTADORES_H
+#define CONTADORES_H
+
+#include <QString>
+
+/**
+ * @brief Contadores hardware del procesador (Linux perf_event_open) para la telemetría.
+ *
+ *        Cada hilo abre la primera vez que los lee un grupo con ciclos, instrucciones, fallos de
+ *        la caché de último nivel y fallos de predicción de saltos, que cuenta sólo en modo
+ *        usuario y sólo ese hilo; el grupo se cierra al terminar el hilo. Los contadores que el
+ *        procesador o la máquina virtual no ofrecen quedan sin valor y el resto sigue midiendo.
+ *        Fuera de Linux, o sin permisos (perf_event_paranoid), no hay contadores.
+ */
+class Contadores
+{
+public:
+    /**
+     * @brief contadores del grupo, en el orden de valores::cuenta
+     */
+    enum contador { CICLOS = 0, INSTRUCCIONES, FALLOS_LLC, FALLOS_SALTO, NUM_CONTADORES };
+
+    /**
+     * @brief lectura de los contadores del hilo
+     * @param cuenta    valor acumulado de cada contador, -1 si el contador no está disponible
+     */
+    struct valores
+    {
+        qint64 cuenta[NUM_CONTADORES];
+    };
+
+    /**
+     * @fn static bool disponibles(QString &)
+     * @brief Comprueba que se puede abrir el grupo de contadores en el hilo actual
+     * @param motivo    por qué no hay contadores, o cuáles faltan si sólo falta alguno
+     * @return          false si no se puede medir ningún contador
+     */
+    static bool disponibles(QString &motivo);
+
+    /**
+     * @fn static bool leer(valores &)
+     * @brief Lee los contadores del hilo actual, escalados si el núcleo los ha multiplexado
+     * @return          false si el hilo no tiene contadores
+     */
+    static bool leer(valores &lectura);
+
+    /**
+     * @fn static const char *nombre(int)
+     * @brief Nombre de un contador en los ficheros de telemetría
+     */
+    static const char *nombre(int c);
+};
+
+#endif // CONTADORES_H
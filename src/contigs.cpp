@@ -0,0 +1,156 @@
+#include "contigs.h"
+#include "files_worker.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSet>
+#include <QTextStream>
+#include <algorithm>
+
+QStringList       Contigs::nombres;
+QMap<int, qint64> Contigs::longitudes;
+
+// ************************************************************************************************
+// número de un cromosoma numerado escrito como número, 0 si es otro nombre
+static int numero(const QString &nombre)
+{
+    bool ok;
+    int  n = nombre.toInt(&ok);
+    return (ok && n > 0 && n <= Contigs::NUMERADOS && QString::number(n) == nombre) ? n : 0;
+}
+
+// ************************************************************************************************
+int Contigs::id(const QString &nombre)
+{
+    int chrom = buscar(nombre);
+    if (chrom != 0)
+        return chrom;
+
+    nombres << nombre;
+    return NUMERADOS + nombres.size();
+}
+
+// ************************************************************************************************
+int Contigs::buscar(const QString &nombre)
+{
+    if (numero(nombre) != 0)
+        return numero(nombre);
+
+    int i = nombres.indexOf(nombre);
+    return i < 0 ? 0 : NUMERADOS + 1 + i;
+}
+
+// ************************************************************************************************
+QString Contigs::nombre(int chrom)
+{
+    if (chrom <= NUMERADOS)
+        return QString::number(chrom);
+
+    return nombres.value(chrom - NUMERADOS - 1);
+}
+
+// ************************************************************************************************
+QString Contigs::secuencia(int chrom)
+{
+    return numerado(chrom) ? "chr" + QString::number(chrom) : nombre(chrom);
+}
+
+// ************************************************************************************************
+QList<int> Contigs::lista(const QString &texto)
+{
+    QList<int> chroms;
+    foreach (QString n, texto.split(QRegularExpression("[,\\s]+")))
+    {
+        if (n.isEmpty())
+            continue;
+
+        // chr1..chr24 se aceptan como los cromosomas numerados, igual que antes de admitir contigs
+        if (n.startsWith("chr", Qt::CaseInsensitive) && numero(n.mid(3)) != 0)
+            n = n.mid(3);
+
+        int chrom = id(n);
+        if (!chroms.contains(chrom))
+            chroms << chrom;
+    }
+
+    return chroms;
+}
+
+// ************************************************************************************************
+QList<int> Contigs::descubrir(const QStringList &directorios, bool forward, bool reverse)
+{
+    // nombre de fichero de cualquier contig con las cadenas que se leen: methylation_map_mix_*.csv
+    QString patron  = QFileInfo(Files_worker::fichero_muestra(QString(), forward, reverse, "*")).fileName();
+    int     prefijo = patron.indexOf('*');
+    int     sufijo  = patron.size() - prefijo - 1;
+
+    // contigs presentes en todas las muestras
+    QSet<QString> comunes;
+    for (int i = 0; i < directorios.size(); i++)
+    {
+        QSet<QString> presentes;
+        foreach (const QString &f, QDir(directorios.at(i)).entryList(QStringList(patron), QDir::Files))
+            presentes << f.mid(prefijo, f.size() - prefijo - sufijo);
+
+        comunes = i == 0 ? presentes : comunes.intersect(presentes);
+    }
+
+    // numerados en orden, después el resto por nombre con los números en orden numérico
+    QStringList ordenados = comunes.values();
+    std::sort(ordenados.begin(), ordenados.end(), [](const QString &a, const QString &b) {
+        bool    numerado_a = numero(a) != 0;
+        bool    numerado_b = numero(b) != 0;
+        bool    ok_a, ok_b;
+        qint64  n_a = a.toLongLong(&ok_a);
+        qint64  n_b = b.toLongLong(&ok_b);
+        if (numerado_a != numerado_b)
+            return numerado_a;
+        if (ok_a && ok_b)
+            return n_a < n_b;
+        if (ok_a != ok_b)
+            return ok_a;
+        return a < b;
+    });
+
+    QList<int> chroms;
+    foreach (const QString &n, ordenados)
+        chroms << id(n);
+
+    return chroms;
+}
+
+// ************************************************************************************************
+bool Contigs::leer_fai(const QString &fichero, QList<int> &contigs, QString &error)
+{
+    QFile data(fichero);
+    if (!data.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        error = "fai file not found: " + fichero;
+        return false;
+    }
+
+    contigs.clear();
+    QTextStream s(&data);
+    for (int linea = 1; !s.atEnd(); linea++)
+    {
+        QStringList campos = s.readLine().split('\t');
+        if (campos.size() == 1 && campos.at(0).trimmed().isEmpty())
+            continue;
+
+        bool   ok;
+        qint64 n = campos.value(1).toLongLong(&ok);
+        if (campos.at(0).isEmpty() || !ok || n <= 0)
+        {
+            error = "invalid line " + QString::number(linea) + " in fai file " + fichero;
+            return false;
+        }
+
+        int chrom = id(campos.at(0));
+        longitudes[chrom] = n;
+        if (!contigs.contains(chrom))
+            contigs << chrom;
+    }
+
+    return true;
+}
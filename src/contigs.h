@@ -0,0 +1,102 @@
+#ifndef CONTIGS_H
+#define CONTIGS_H
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+
+/**
+ * @brief Nombres de los cromosomas y contigs de una ejecución y su descubrimiento a partir de los
+ *        directorios de las muestras o de un índice .fai.
+ *
+ *        El motor identifica cada cromosoma con un número. Los cromosomas 1 a 24 son su número, con
+ *        los ficheros methylation_map_<cadena>_<N>.csv de siempre. El resto de contigs (cromosomas
+ *        de otras especies, X o Y con nombre, scaffolds) reciben un número a partir de 25 la primera
+ *        vez que aparecen y conservan su nombre para los ficheros de las muestras, los directorios
+ *        de shard y las salidas.
+ *
+ *        Los números de los contigs con nombre sólo valen dentro de un proceso: fuera de él, en la
+ *        línea de comandos, los shards o los manifiestos, se usa el nombre. El registro se completa
+ *        al configurar los trabajos, antes de lanzar hilos, y después sólo se consulta.
+ */
+class Contigs
+{
+public:
+    /**
+     * @brief cromosomas identificados por su número
+     */
+    static const int NUMERADOS = 24;
+
+    /**
+     * @fn static int id(const QString &)
+     * @brief Número de un cromosoma o contig por su nombre en los ficheros, registrándolo si es nuevo
+     */
+    static int id(const QString &nombre);
+
+    /**
+     * @fn static int buscar(const QString &)
+     * @brief Número de un cromosoma o contig ya conocido, 0 si no lo es
+     */
+    static int buscar(const QString &nombre);
+
+    /**
+     * @fn static QString nombre(int)
+     * @brief Nombre de un cromosoma o contig en los ficheros de las muestras
+     */
+    static QString nombre(int chrom);
+
+    /**
+     * @fn static QString secuencia(int)
+     * @brief Nombre de la secuencia en los GFF: chr<N> para los cromosomas numerados, el nombre del
+     *        contig para el resto
+     */
+    static QString secuencia(int chrom);
+
+    /**
+     * @fn static bool numerado(int)
+     * @brief Informa si un cromosoma es uno de los 24 numerados, los únicos con referencias genómicas
+     */
+    static bool numerado(int chrom) { return chrom > 0 && chrom <= NUMERADOS; }
+
+    /**
+     * @fn static QList<int> lista(const QString &)
+     * @brief Lista de cromosomas de un texto separado por comas o espacios, sin duplicados
+     *
+     *        1..24 y chr1..chr24 son los cromosomas numerados; cualquier otro nombre es un contig.
+     */
+    static QList<int> lista(const QString &texto);
+
+    /**
+     * @fn static QList<int> descubrir(const QStringList &, bool, bool)
+     * @brief Contigs con fichero en todos los directorios de muestras, para las cadenas que se leen
+     * @return          numerados primero en orden y después el resto por nombre
+     */
+    static QList<int> descubrir(const QStringList &directorios, bool forward, bool reverse);
+
+    /**
+     * @fn static bool leer_fai(const QString &, QList<int> &, QString &)
+     * @brief Lee un índice .fai de samtools: nombre y longitud de cada contig por línea
+     * @param contigs   contigs en el orden del índice
+     * @return          false si el fichero no se puede leer o alguna línea no es válida
+     */
+    static bool leer_fai(const QString &fichero, QList<int> &contigs, QString &error);
+
+    /**
+     * @fn static qint64 longitud(int)
+     * @brief Longitud de un contig según el último .fai leído, 0 si no se conoce
+     */
+    static qint64 longitud(int chrom) { return longitudes.value(chrom, 0); }
+
+private:
+    /**
+     * @brief registro de la ejecución
+     * @param nombres       nombres de los contigs a partir del 25, en orden de registro
+     * @param longitudes    longitud de cada contig leída de un .fai
+     */
+    static QStringList       nombres;
+    static QMap<int, qint64> longitudes;
+};
+
+#endif // CONTIGS_H
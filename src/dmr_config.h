@@ -0,0 +1,86 @@
+#ifndef DMR_CONFIG_H
+#define DMR_CONFIG_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+/** ***********************************************************************************************
+  *  \brief parámetros completos de un análisis de DMRs, independientes de la interfaz gráfica
+  *         los valores por defecto coinciden con los de la interfaz al arrancar
+  *  \param lista_casos             directorios con los ficheros de cada muestra caso
+  *  \param lista_control           directorios con los ficheros de cada muestra control
+  *  \param ruta_salida             directorio donde guardar los ficheros csv y gff
+  *  \param ruta_shard              si no está vacío, directorio donde guardar los resultados parciales
+  *                                 de un shard (un cromosoma) para fusionarlos después en ruta_salida
+  *  \param lista_chroms            cromosomas a analizar, en el orden de proceso
+  *  \param genome_reference        genoma de referencia: 0 ninguno, 1 homo sapiens GRCh.37.68
+  *  \param mc                      analiza metilación
+  *  \param hmc                     analiza hidroximetilación
+  *  \param forward                 lee los ficheros forward
+  *  \param reverse                 lee los ficheros reverse
+  *  \param mc_min_coverage         mínima cobertura por posición para mC
+  *  \param hmc_min_coverage        mínima cobertura por posición para hmC
+  *  \param threshold               umbral de diferencia de medias para DMR, en centésimas
+  *  \param dmr_dwt_level           nivel de la transformada wavelet
+  *  \param min_cpg_x_region        porcentaje mínimo de posiciones metiladas por ventana
+  *  \param min_samples_x_region    porcentaje mínimo de muestras por grupo con cobertura por ventana
+  *  \param fichero_regiones        si no está vacío, fichero BED con las regiones objetivo: sólo se
+  *                                 leen y analizan las ventanas de la transformada que las cubren
+  *  \param estacionaria            transformada estacionaria: una ventana de 2^nivel posiciones desde
+  *                                 cada posición metilada en lugar de la rejilla de la transformada
+  *  \param refinar                 recorta los extremos de cada DMR a las posiciones diferenciales
+  *                                 más externas, comparando las proporciones de cada posición
+  *  \param nivel_grueso            si es mayor que dmr_dwt_level, búsqueda jerárquica: los candidatos
+  *                                 se buscan en todo el cromosoma a este nivel y sólo sus ventanas y
+  *                                 las vecinas se transforman y se analizan a dmr_dwt_level; 0 sin ella
+  *  \param espacio_cpg             la transformada recorre las posiciones con cobertura de alguna
+  *                                 muestra, una tras otra, en lugar de todas las del cromosoma
+  *  \param grupos                  si no está vacío, grupo de cada muestra de lista_casos en una
+  *                                 comparación de varios grupos, sin controles: la diferencia de
+  *                                 cada ventana es la mayor entre las medias de los grupos
+  *  \param cohorte                 si no está vacío, todas las muestras de la hoja de muestras de la
+  *                                 que sale el trabajo: fijan la ventana del cromosoma para que los
+  *                                 trabajos de la hoja compartan transformadas y sumas por grupo
+  *  \param pares                   si no está vacío, comparación además muestra a muestra: "all" cada
+  *                                 muestra con cada otra, "control" cada caso con la media de los
+  *                                 controles; da una matriz con el número de DMRs de cada par
+  *  \param listas_pares            con pares, guarda también los DMRs de cada par por cromosoma
+  *  \param permutaciones           si es mayor que 0, permutaciones de las etiquetas caso / control
+  *                                 para el p-valor empírico de cada DMR, con su FDR al fusionar
+  *  \param beta_binomial           p-valor de cada DMR con una prueba beta-binomial sobre los reads de
+  *                                 sus posiciones
+  * ***********************************************************************************************
+  */
+struct dmr_config
+{
+    QStringList lista_casos;
+    QStringList lista_control;
+    QString     ruta_salida;
+    QString     ruta_shard;
+    QList<int>  lista_chroms;
+    int         genome_reference     = 1;
+    bool        mc                   = true;
+    bool        hmc                  = false;
+    bool        forward              = true;
+    bool        reverse              = true;
+    int         mc_min_coverage      = 100;
+    int         hmc_min_coverage     = 100;
+    int         threshold            = 30;
+    int         dmr_dwt_level        = 6;
+    int         min_cpg_x_region     = 7;
+    int         min_samples_x_region = 50;
+    QString     fichero_regiones;
+    bool        estacionaria         = false;
+    bool        refinar              = false;
+    int         nivel_grueso         = 0;
+    bool        espacio_cpg          = false;
+    QList<int>  grupos;
+    QStringList cohorte;
+    QString     pares;
+    bool        listas_pares         = false;
+    int         permutaciones        = 0;
+    bool        beta_binomial        = false;
+};
+
+#endif // DMR_CONFIG_H
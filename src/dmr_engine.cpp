@@ -0,0 +1,3024 @@
+#include "dmr_engine.h"
+#include "contigs.h"
+#include "planificador.h"
+#include "shards.h"
+#include "telemetria.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QCryptographicHash>
+#include <QtAlgorithms>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <exception>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <random>
+
+using namespace std;
+
+// ************************************************************************************************
+// ejecuta f(0)..f(n - 1) repartidos entre los núcleos, cada hilo toma el siguiente índice libre al
+// acabar el anterior
+// ..los contadores hardware de los hilos lanzados se suman a la etapa que mide el hilo que llama
+static void en_paralelo(size_t n, const function<void(size_t)> &f)
+{
+    atomic<size_t> siguiente(0);
+    auto trabajar = [&]() {
+        for (size_t i = siguiente++; i < n; i = siguiente++)
+            f(i);
+    };
+
+    Telemetria::Reparto reparto;
+    auto trabajar_aparte = [&]() {
+        Telemetria::Reparto::Hilo hilo(reparto);
+        trabajar();
+    };
+
+    size_t hilos = qMin(qMax(size_t(std::thread::hardware_concurrency()), size_t(1)), qMax(n, size_t(1)));
+    vector<std::thread> trabajadores;
+    for (size_t h = 1; h < hilos; h++)
+        trabajadores.emplace_back(trabajar_aparte);
+    trabajar();
+    for (std::thread &t : trabajadores)
+        t.join();
+}
+
+// bloques de 64 ventanas que recorre cada tarea al sumar los grupos
+static const size_t BLOQUES_POR_TRAMO = 64;
+
+// muestras por lado de los bloques de pares de la comparación muestra a muestra
+static const size_t MUESTRAS_POR_BLOQUE = 16;
+
+// permutaciones que recorre cada DMR a la vez y permutaciones que superan su estadístico tras las
+// que deja de permutarse
+static const size_t PERMUTACIONES_POR_LOTE = 64;
+static const int    EXCESOS_PARADA         = 10;
+
+// ************************************************************************************************
+// logaritmo de x > 0 normal sin llamadas a la librería, para que los bucles que lo usan se
+// vectoricen: x = m 2^e con m entre raíz(1/2) y raíz(2), y log(m) = 2 atanh((m - 1) / (m + 1))
+#pragma omp declare simd
+static inline double log_simd(double x)
+{
+    // m y e salen de los bits de x, sin saltos ni conversiones de enteros de 64 bits, que no tienen
+    // instrucción vectorial en SSE2 ni AVX2: e pasa a double como mantisa de 2^52 y, con una m
+    // mayor que raíz(2), m se divide por 2 y e crece en 1
+    uint64_t bits;
+    double   m;
+    memcpy(&bits, &x, sizeof(bits));
+    uint64_t mantisa = bits & 0x000fffffffffffffULL;
+    uint64_t uno     = mantisa | 0x3ff0000000000000ULL;
+    memcpy(&m, &uno, sizeof(m));
+
+    uint64_t exponente = (bits >> 52) | 0x4330000000000000ULL;
+    double   e;
+    memcpy(&e, &exponente, sizeof(e));
+
+    double mayor = m > 1.4142135623730951 ? 1.0 : 0.0;
+    m -= 0.5 * m * mayor;
+    e += mayor - 4503599627370496.0 - 1023.0;
+
+    double t  = (m - 1.0) / (m + 1.0);
+    double t2 = t * t;
+    double serie = 1.0 + t2 * (1.0 / 3 + t2 * (1.0 / 5 + t2 * (1.0 / 7 + t2 * (1.0 / 9 + t2 * (1.0 / 11 +
+                   t2 * (1.0 / 13 + t2 * (1.0 / 15 + t2 / 17)))))));
+    return 2.0 * t * serie + e * 0.6931471805599453;
+}
+
+// ************************************************************************************************
+// logaritmo de la función gamma de x > 0: lgamma(x) = lgamma(x + 8) - log(x (x + 1) .. (x + 7)) y
+// serie de Stirling en x + 8
+#pragma omp declare simd
+static inline double log_gamma(double x)
+{
+    double producto = x * (x + 1.0) * (x + 2.0) * (x + 3.0) * (x + 4.0) * (x + 5.0) * (x + 6.0) * (x + 7.0);
+    double z   = x + 8.0;
+    double zi  = 1.0 / z;
+    double zi2 = zi * zi;
+    return (z - 0.5) * log_simd(z) - z + 0.9189385332046727 +
+           zi * (1.0 / 12 - zi2 * (1.0 / 360 - zi2 * (1.0 / 1260 - zi2 / 1680))) - log_simd(producto);
+}
+
+// ************************************************************************************************
+Dmr_engine::Dmr_engine(QObject *parent) :
+    QObject(parent),
+    mutex()
+{
+    // inicialización de variables ------------------------------------------------------------
+    aborted            = false;
+    _threshold         = 0.0;
+    fichero            = "";
+    region_gff         = 0;
+    num_genes          = 0;
+    contador           = 0;
+    memory_available   = 0;
+    limite_inferior    = 500000000;
+    limite_superior    = 0;
+    siguientes_lectura = 0;
+    cuda_data.mc_full  = nullptr;
+    cuda_data.h_haar_C = nullptr;
+    cuda_data.d_haar   = nullptr;
+    cuda_data.d_aux    = nullptr;
+    cuda_data.refGen   = nullptr;
+    dmr_diff           = nullptr;
+    dmr_diff_cols      = 0;
+    hilo_refGen        = nullptr;
+    memoria_cache      = 0;
+    memoria_maxima     = 0;
+    trabajo_cromosoma  = 0;
+    por_muestra        = false;
+    cromosoma          = 0;
+}
+
+// ************************************************************************************************
+Dmr_engine::~Dmr_engine()
+{
+    liberar_memoria();
+    if (cuda_data.refGen != nullptr)
+    {
+        delete [] cuda_data.refGen[0];
+        delete [] cuda_data.refGen;
+    }
+}
+
+// ************************************************************************************************
+void Dmr_engine::solicitud_proceso(const dmr_config &configx)
+{
+    solicitud_proceso(QList<dmr_config>() << configx);
+}
+
+// ************************************************************************************************
+void Dmr_engine::solicitud_proceso(const QList<dmr_config> &trabajosx, int memoria_mbx)
+{
+    trabajos = trabajosx;
+
+    if (!trabajos.isEmpty())
+        config = trabajos.front();
+
+    memoria_maxima = qint64(memoria_mbx) * 1024 * 1024;
+    aborted        = false;
+
+    emit proceso_solicitado();
+}
+
+// ************************************************************************************************
+void Dmr_engine::modo_por_muestra(bool activo)
+{
+    por_muestra = activo;
+}
+
+// ************************************************************************************************
+void Dmr_engine::abort()
+{
+    aborted = true;
+
+    mutex.lock();
+    foreach (Files_worker *h, files_worker)
+        h->abort();
+    mutex.unlock();
+}
+
+// ************************************************************************************************
+int Dmr_engine::memoria_gpu_disponible()
+{
+    // comprueba la memoria disponible en la tarjeta gráfica para controlar los ficheros a cargar
+    // ..captura la información suministrada por el comando "nvidia-smi"
+    QProcess p;
+    p.start("nvidia-smi");
+    p.waitForFinished();
+    QString data = p.readAllStandardOutput();
+    p.close();
+
+    // ..busca los datos que concuerdan con "[[:digit:]]+MiB" y se queda con el segundo dato
+    //   que informa de la capacidad total de memoria de la tarjeta
+    QRegularExpression re("(\\d+)MiB");
+    QRegularExpressionMatchIterator i = re.globalMatch(data);
+    if (!i.hasNext())
+        return 0;
+    QRegularExpressionMatch match_1 = i.next();
+    if (!i.hasNext())
+        return 0;
+    QRegularExpressionMatch match_2 = i.next();
+    qDebug() << "memoria GPU ocupada / total ----> " << match_1.captured(1) << "/" << match_2.captured(1);
+
+    // ..se devuelve el valor en MiB
+    return match_2.captured(1).toInt() - match_1.captured(1).toInt();
+}
+
+// ************************************************************************************************
+QList<int> Dmr_engine::lista_cromosomas(const QString &texto)
+{
+    // genera la lista de cromosomas a analizar eliminando duplicados, números o nombres de contig
+    return Contigs::lista(texto);
+}
+
+// ************************************************************************************************
+int Dmr_engine::maximo_progreso() const
+{
+    int maximo = 0;
+    foreach (const dmr_config &t, trabajos)
+        maximo += (t.lista_casos.size() + t.lista_control.size()) * t.lista_chroms.size() +
+                  (t.lista_chroms.size() * (t.mc + t.hmc));
+
+    return maximo;
+}
+
+// ************************************************************************************************
+QString Dmr_engine::nombre_csv(const dmr_config &configx, int chrom, int mh)
+{
+    return "chromosome_" + Contigs::nombre(chrom) + "_" +
+           (mh ? "hmc_thr0" : "mc_thr0") + QString::number(configx.threshold) +
+           (configx.estacionaria ? "_swt" : configx.espacio_cpg ? "_cpg" : "_dwt") + QString::number(configx.dmr_dwt_level) +
+           (configx.nivel_grueso ? "from" + QString::number(configx.nivel_grueso) : QString()) +
+           "_cov" + QString::number(mh ? configx.hmc_min_coverage : configx.mc_min_coverage) + ".csv";
+}
+
+// ************************************************************************************************
+QString Dmr_engine::nombre_gff(const dmr_config &configx, int mh)
+{
+    return configx.ruta_salida.split("/").last() + "_" +
+           (mh ? "hmc_thr0" : "mc_thr0") + QString::number(configx.threshold) +
+           (configx.estacionaria ? "_swt" : configx.espacio_cpg ? "_cpg" : "_dwt") + QString::number(configx.dmr_dwt_level) +
+           (configx.nivel_grueso ? "from" + QString::number(configx.nivel_grueso) : QString()) +
+           "_cov" + QString::number(mh ? configx.hmc_min_coverage : configx.mc_min_coverage) + ".gff";
+}
+
+// ************************************************************************************************
+QString Dmr_engine::nombre_pares(const dmr_config &configx, int mh)
+{
+    QString gff = nombre_gff(configx, mh);
+    return gff.left(gff.size() - 4) + "_pairs.tsv";
+}
+
+// ************************************************************************************************
+QString Dmr_engine::nombre_lista_pares(const dmr_config &configx, int chrom, int mh)
+{
+    QString csv = nombre_csv(configx, chrom, mh);
+    return csv.left(csv.size() - 4) + "_pairs.tsv";
+}
+
+// ************************************************************************************************
+QList<int> Dmr_engine::orden_cromosomas(const QList<dmr_config> &trabajosx)
+{
+    // cromosomas de todos los trabajos, en el orden en que aparecen
+    QList<int> lista_chroms;
+    foreach (const dmr_config &c, trabajosx)
+        foreach (int chrom, c.lista_chroms)
+            if (!lista_chroms.contains(chrom))
+                lista_chroms << chrom;
+
+    return lista_chroms;
+}
+
+// ************************************************************************************************
+QString Dmr_engine::clave_muestra(const QString &directorio, int chrom, const dmr_config &configx)
+{
+    // con regiones objetivo sólo se leen los registros de las ventanas que las cubren, que dependen
+    // de las regiones, del nivel y de la ventana del cromosoma que fijan las muestras del trabajo
+    QString regiones;
+    if (!configx.fichero_regiones.isEmpty())
+        regiones = "|" + configx.fichero_regiones + "|" + QString::number(configx.dmr_dwt_level) +
+                   "|" + configx.lista_casos.join(",") + ";" + configx.lista_control.join(",");
+
+    return directorio + "|" + QString::number(chrom) + "|" +
+           QString::number(configx.forward) + QString::number(configx.reverse) + regiones;
+}
+
+// ************************************************************************************************
+QStringList Dmr_engine::claves_trabajo(int chrom, const dmr_config &configx)
+{
+    QStringList claves;
+    foreach (const QString &d, configx.lista_casos + configx.lista_control)
+        claves << clave_muestra(d, chrom, configx);
+
+    return claves;
+}
+
+
+// ************************************************************************************************
+// *************************************ZONA EJECUCION PROCESO*************************************
+// ************************************************************************************************
+void Dmr_engine::proceso()
+{
+    Telemetria::Medida medida_proceso("run");
+
+    // inicialización de variables del proceso
+    aborted       = false;
+    contador      = 0;
+    memoria_cache = 0;
+
+    memory_available = memoria_gpu_disponible();
+    emit progreso(contador, maximo_progreso());
+
+    // los resultados de cada cromosoma se guardan aparte con su marca de terminado, de forma que
+    // al repetir una ejecución interrumpida con la misma configuración sólo se procesa lo que falta
+    // ..los trabajos de un shard externo los fusiona quien lo ha repartido
+    QList<dmr_config> fusionar;
+    foreach (const dmr_config &t, trabajos)
+        if (t.ruta_shard.isEmpty())
+            fusionar << t;
+
+    QString texto_error;
+    if (!Shards::escribir_manifiesto(fusionar, texto_error))
+        emit error(texto_error);
+
+    // cromosomas de todos los trabajos, del más costoso al menos: el primero reserva de una vez la
+    // memoria de trabajo que necesitan todos los demás
+    QList<int> lista_chroms = Planificador::orden(trabajos);
+
+    for (int idx = 0; idx < lista_chroms.size() && !aborted; idx++)
+    {
+        int chrom = lista_chroms.at(idx);
+
+        // trabajos que analizan el cromosoma y trabajos que usan cada muestra
+        QList<int> trabajos_chrom;
+        bool       referencias = false;
+        usos.clear();
+        for (int t = 0; t < trabajos.size(); t++)
+        {
+            if (!trabajos[t].lista_chroms.contains(chrom))
+                continue;
+
+            // cromosoma terminado en una ejecución anterior
+            if (Shards::terminado(trabajos[t], chrom))
+            {
+                contador += trabajos[t].lista_casos.size() + trabajos[t].lista_control.size() +
+                            trabajos[t].mc + trabajos[t].hmc;
+                emit progreso(contador, maximo_progreso());
+                emit mensaje("chromosome " + Contigs::nombre(chrom) + " already finished, skipped");
+                continue;
+            }
+
+            foreach (const QString &clave, claves_trabajo(chrom, trabajos[t]))
+                if (usos[clave].isEmpty() || usos[clave].last() != trabajos_chrom.size())
+                    usos[clave] << trabajos_chrom.size();
+
+            // sólo los cromosomas numerados tienen referencias genómicas
+            referencias |= trabajos[t].genome_reference == 1 && Contigs::numerado(chrom);
+            trabajos_chrom << t;
+        }
+
+        // las referencias genómicas se leen una vez por cromosoma, mientras se leen las muestras
+        num_genes = 0;
+        if (referencias)
+            leer_referencias(chrom);
+
+        for (int n = 0; n < trabajos_chrom.size() && !aborted; n++)
+        {
+            Telemetria::Medida medida_cromosoma("chromosome", chrom);
+
+            trabajo_cromosoma = n;
+            if (!seleccionar_trabajo(trabajos_chrom.at(n), chrom))
+            {
+                contador += config.lista_casos.size() + config.lista_control.size() + config.mc + config.hmc;
+                emit progreso(contador, maximo_progreso());
+                continue;
+            }
+
+            // con regiones objetivo, un cromosoma sin regiones no se lee
+            if (!config.fichero_regiones.isEmpty() && regiones_cromosoma(chrom).empty())
+            {
+                emit mensaje("chromosome " + Contigs::nombre(chrom) + " has no target regions, skipped");
+                Shards::marcar(config, chrom, false);
+                contador += config.lista_casos.size() + config.lista_control.size() + config.mc + config.hmc;
+                emit progreso(contador, maximo_progreso());
+                continue;
+            }
+
+            emit mensaje(idx == 0 && n == 0 ? "loading files..." : "reading next chromosome...");
+
+            // lectura del cromosoma de las muestras del trabajo que no se han leído antes
+            bool leido = leer_cromosoma(chrom, n);
+
+            // las referencias deben estar cargadas antes de buscar los genes de los DMRs
+            if (hilo_refGen != nullptr)
+            {
+                hilo_refGen->wait();
+                delete hilo_refGen;
+                hilo_refGen = nullptr;
+            }
+
+            if (!leido)
+            {
+                if (!aborted)
+                    emit error("Chromosome " + Contigs::nombre(chrom) +
+                               " is missing or empty in some sample, it is skipped");
+
+                if (!aborted)
+                    Shards::marcar(config, chrom, false);
+
+                devolver_muestras();
+                ajustar_memoria(n);
+                contador += config.mc + config.hmc;
+                emit progreso(contador, maximo_progreso());
+                continue;
+            }
+
+            if (aborted)
+                break;
+
+            emit mensaje("identifying DMRs...");
+
+            // calcula wavelet de cada uno de los ficheros leídos
+            lectura_acabada();
+
+            // los resultados parciales del cromosoma quedan completos
+            if (!aborted)
+                Shards::marcar(config, chrom, true);
+
+            // las muestras vuelven a la memoria compartida para los trabajos siguientes
+            devolver_muestras();
+            ajustar_memoria(n);
+        }
+
+        if (hilo_refGen != nullptr)
+        {
+            hilo_refGen->wait();
+            delete hilo_refGen;
+            hilo_refGen = nullptr;
+        }
+
+        // ningún cromosoma posterior usa los datos de este
+        // ..las matrices de la transformada se quedan reservadas para el siguiente cromosoma
+        emit mensaje("freeing memory... it will takes a while");
+        devolver_muestras();
+        muestras.clear();
+        transformadas.clear();
+        sumas.clear();
+        memoria_cache = 0;
+    }
+
+    // lectura de ficheros acabada
+    qDebug() << "se han leído todos los ficheros de " << trabajos.size() << " trabajos";
+
+    // con todos los cromosomas terminados se generan los ficheros finales
+    if (!aborted && !fusionar.isEmpty())
+    {
+        emit mensaje("writing result files...");
+
+        QStringList avisos;
+        if (!Shards::fusionar(fusionar, avisos, texto_error))
+            emit error(texto_error);
+    }
+
+    // limpia las matrices de datos del último cromosoma y libera de una vez la memoria de la ejecución
+    vector<Registros_muestra>().swap(mc);
+    vector<int>().swap(grupo_muestra);
+    vector<int>().swap(orden_muestra);
+    h_haar_C = Vista_matriz();
+    vector<vector<uint>>().swap(posicion_metilada);
+    vector<uint>().swap(anclas);
+    dmr_diff = nullptr;
+    arena.liberar();
+
+    emit terminado(!aborted);
+    emit finished();
+}
+
+// ************************************************************************************************
+bool Dmr_engine::seleccionar_trabajo(int t, int chrom)
+{
+    config     = trabajos[t];
+    cromosoma  = chrom;
+    region_gff = 0;
+    _threshold = float(config.threshold * 0.01);
+
+    // resultados parciales del cromosoma, sin restos de un intento anterior interrumpido
+    QString texto_error;
+    if (config.ruta_shard.isEmpty())
+        config.ruta_shard = Shards::directorio(config, chrom);
+    if (!Shards::limpiar(config, chrom, texto_error))
+    {
+        emit error(texto_error);
+        return false;
+    }
+
+    // inicializa los parámetros a enviar a los hilos
+    parametros = (QStringList() << QString::number(config.forward) << // se informa forward reads 0/1
+                                QString::number(config.reverse) <<    // se informa reverse reads 0/1
+                                QString::number(chrom) <<             // se informa del número de cromosoma
+                                "0" <<                                // se informa del número de hilo asignado
+                                Arena::directorio_temporal() <<       // se informa del disco de trabajo fuera de memoria
+                                Contigs::nombre(chrom)                // se informa del nombre del cromosoma en los ficheros
+                 );
+
+    qDebug() << "trabajo" << t << ":" <<
+                config.lista_casos.front() << " - " <<
+                config.lista_control.value(0) << " - " <<
+                parametros << " - " <<
+                config.lista_chroms;
+
+    return true;
+}
+
+// HILO LECTURA DE DATOS DE FICHEROS
+// ************************************************************************************************
+bool Dmr_engine::leer_cromosoma(int chrom, int n)
+{
+    Telemetria::Medida medida("read", chrom);
+
+    QStringList claves = claves_trabajo(chrom, config);
+
+    limite_inferior = 500000000;
+    limite_superior = 0;
+    grupo_muestra.assign(uint(claves.size()), 0);
+    orden_muestra.assign(uint(claves.size()), 0);
+    claves_mc = claves;
+    ventanas_objetivo.clear();
+    tramos_lectura.clear();
+
+    // los trabajos de una hoja de muestras parten de la ventana de toda la cohorte, la misma en
+    // todos ellos, para compartir transformadas y sumas por grupo
+    // ..las muestras del trabajo están en la cohorte y no la amplían
+    foreach (const QString &d, config.cohorte)
+    {
+        uint inicio, final;
+        if (!Files_worker::limites(d, parametros, inicio, final))
+            continue;
+
+        if (limite_inferior > inicio)
+            limite_inferior = inicio;
+        if (limite_superior < final)
+            limite_superior = final;
+    }
+
+    // en el modo por muestra y con regiones objetivo la ventana del cromosoma se fija antes de leer
+    // las muestras, con los extremos de cada fichero
+    bool objetivo = !config.fichero_regiones.isEmpty();
+    if (por_muestra || objetivo)
+    {
+        bool completo = leer_limites(claves) && (!objetivo || preparar_ventanas(chrom));
+
+        // en el modo por muestra las muestras se leen de una en una al transformarlas y mc queda
+        // con las filas vacías
+        if (por_muestra || !completo)
+        {
+            mc.assign(uint(claves.size()), Registros_muestra());
+            contador += claves.size();
+            emit progreso(contador, maximo_progreso());
+            return completo;
+        }
+    }
+
+    // muestras del trabajo que ningún trabajo anterior ha dejado en memoria
+    QStringList pendientes;
+    foreach (const QString &clave, claves)
+        if (!muestras.contains(clave) && !pendientes.contains(clave))
+            pendientes << clave;
+
+    // cada muestra pendiente se lee en su hilo, en la posición reservada para ella
+    vector<Registros_muestra> leidas(uint(pendientes.size()));
+    QStringList directorios;
+    foreach (const QString &clave, pendientes)
+        directorios << clave.section('|', 0, 0);
+
+    mutex.lock();
+    for (int i = 0; i < pendientes.size(); i++)
+    {
+        hilo_files_worker.append(new QThread());
+        files_worker.append(new Files_worker());
+    }
+
+    for (int i = 0; i < hilo_files_worker.size(); i++)
+    {
+        files_worker[i]->moveToThread(hilo_files_worker[i]);
+        connect(hilo_files_worker[i], &QThread::finished, files_worker[i], &QObject::deleteLater);
+        files_worker[i]->connect(hilo_files_worker[i], SIGNAL(started()), SLOT(lectura()));
+        hilo_files_worker[i]->connect(files_worker[i],SIGNAL(lectura_solicitada()), SLOT(start()));
+        hilo_files_worker[i]->connect(files_worker[i], SIGNAL(finished()), SLOT(quit()), Qt::DirectConnection);
+
+        // se le asigna el número de cromosoma y la posición de la muestra
+        parametros[2] = QString::number(chrom);
+        parametros[3] = QString::number(i);
+        qDebug() << "cromosoma a leer:" << parametros[2] << parametros[3] << directorios.at(i);
+
+        // se lanza el hilo de lectura de ficheros por cromosoma
+        files_worker[i]->limitar_tramos(tramos_lectura);
+        files_worker[i]->solicitud_lectura(directorios, QStringList(), parametros, leidas, mutex);
+    }
+    mutex.unlock();
+
+    // espera a que terminen todos los hilos de lectura
+    foreach (QThread *h, hilo_files_worker)
+        h->wait();
+
+    // borra todos los hilos creados
+    mutex.lock();
+    foreach(QThread *i, hilo_files_worker)
+        delete i;
+
+    QVector<QThread*>().swap(hilo_files_worker);
+    QVector<Files_worker*>().swap(files_worker);
+    mutex.unlock();
+
+    // guarda las muestras leídas para este trabajo y los siguientes que las compartan
+    for (int i = 0; i < pendientes.size(); i++)
+    {
+        muestra_leida &m = muestras[pendientes.at(i)];
+        m.datos.swap(leidas[uint(i)]);
+        m.inicio = m.datos.empty() ? 0 : uint(m.datos.front()[0]);
+        m.final  = m.datos.empty() ? 0 : uint(m.datos.back()[0]);
+        memoria_cache += m.datos.memoria();
+        medida.sitios(qint64(m.datos.size()));
+    }
+
+    // coloca las muestras en mc en el orden del trabajo: casos y después controles
+    // ..los datos se intercambian sin copiarlos y vuelven a la memoria compartida al acabar
+    mc.assign(uint(claves.size()), Registros_muestra());
+
+    bool completo = true;
+    for (int i = 0; i < claves.size(); i++)
+    {
+        muestra_leida &m = muestras[claves.at(i)];
+
+        // una misma muestra repetida en el trabajo comparte los datos de su primera posición
+        int primera = claves.indexOf(claves.at(i));
+        if (primera < i)
+            mc[uint(i)] = mc[uint(primera)];
+        else
+            mc[uint(i)].swap(m.datos);
+
+        // contador de evolución de lectura y análisis
+        contador++;
+        emit progreso(contador, maximo_progreso());
+
+        if (mc[uint(i)].empty())
+        {
+            completo = false;
+            continue;
+        }
+
+        // posición de la muestra en su grupo y grupo caso (0) / control (1) según este trabajo, o
+        // el de la hoja de muestras
+        // ..los registros no se modifican, pueden estar volcados en el disco de trabajo
+        bool caso              = i < config.lista_casos.size();
+        orden_muestra[uint(i)] = caso ? i : i - config.lista_casos.size();
+        grupo_muestra[uint(i)] = config.grupos.isEmpty() ? (caso ? 0 : 1) : config.grupos.at(i);
+
+        // con regiones objetivo la ventana ya está fijada por los ficheros completos
+        if (objetivo)
+            continue;
+
+        if (limite_inferior > m.inicio)
+            limite_inferior = m.inicio;
+        if (limite_superior < m.final)
+            limite_superior = m.final;
+    }
+
+    qDebug() << "trabajo" << n << ": muestras leídas" << pendientes.size() << "de" << claves.size()
+             << "- memoria compartida" << memoria_cache / (1024 * 1024) << "MiB";
+
+    // todas las muestras deben tener datos del cromosoma para poder compararlas
+    return completo;
+}
+
+// ************************************************************************************************
+bool Dmr_engine::leer_limites(const QStringList &claves)
+{
+    bool completo = true;
+    for (int i = 0; i < claves.size() && !aborted; i++)
+    {
+        uint inicio, final;
+        if (!Files_worker::limites(claves.at(i).section('|', 0, 0), parametros, inicio, final))
+        {
+            completo = false;
+            continue;
+        }
+
+        bool caso              = i < config.lista_casos.size();
+        orden_muestra[uint(i)] = caso ? i : i - config.lista_casos.size();
+        grupo_muestra[uint(i)] = config.grupos.isEmpty() ? (caso ? 0 : 1) : config.grupos.at(i);
+
+        if (limite_inferior > inicio)
+            limite_inferior = inicio;
+        if (limite_superior < final)
+            limite_superior = final;
+    }
+
+    return completo && !aborted;
+}
+
+// ************************************************************************************************
+const vector<pair<uint, uint>> &Dmr_engine::regiones_cromosoma(int chrom)
+{
+    // el BED se lee una vez por ejecución, un error deja el trabajo sin regiones
+    if (!objetivos.contains(config.fichero_regiones))
+    {
+        QString texto_error;
+        if (!Regiones_objetivo::leer(config.fichero_regiones, objetivos[config.fichero_regiones], texto_error))
+            emit error(texto_error);
+    }
+
+    return objetivos[config.fichero_regiones].cromosoma(chrom);
+}
+
+// ************************************************************************************************
+bool Dmr_engine::preparar_ventanas(int chrom)
+{
+    uint paso   = uint(pow(2, config.dmr_dwt_level));
+    uint ultima = (limite_superior - limite_inferior) / paso;
+
+    // ventanas que tocan alguna región [inicio, fin) dentro de los datos del cromosoma
+    // ..las regiones están ordenadas y sin solapes, una ventana compartida se cuenta una vez
+    foreach (const auto &r, regiones_cromosoma(chrom))
+    {
+        if (r.second <= limite_inferior || r.first > limite_superior)
+            continue;
+
+        uint desde = (qMax(r.first, limite_inferior) - limite_inferior) / paso;
+        uint hasta = qMin((r.second - 1 - limite_inferior) / paso, ultima);
+        if (!ventanas_objetivo.empty() && desde <= ventanas_objetivo.back())
+            desde = ventanas_objetivo.back() + 1;
+
+        for (uint v = desde; v <= hasta; v++)
+            ventanas_objetivo.push_back(v);
+    }
+
+    return completar_ventanas();
+}
+
+// ************************************************************************************************
+bool Dmr_engine::completar_ventanas()
+{
+    uint ultima = ultima_ventana(config.dmr_dwt_level);
+
+    if (ventanas_objetivo.empty())
+        return false;
+
+    // la transformada necesita al menos dos ventanas para llegar al nivel pedido
+    if (ventanas_objetivo.size() == 1)
+    {
+        if (ventanas_objetivo.front() < ultima)
+            ventanas_objetivo.push_back(ventanas_objetivo.front() + 1);
+        else if (ventanas_objetivo.front() > 0)
+            ventanas_objetivo.insert(ventanas_objetivo.begin(), ventanas_objetivo.front() - 1);
+        else
+        {
+            ventanas_objetivo.clear();
+            return false;
+        }
+    }
+
+    // tramos de posiciones de las ventanas consecutivas
+    for (size_t i = 0; i < ventanas_objetivo.size(); i++)
+    {
+        uint v = ventanas_objetivo[i];
+        if (i > 0 && ventanas_objetivo[i - 1] + 1 == v)
+            tramos_lectura.back().second = fin_ventana(v) - 1;
+        else
+            tramos_lectura.push_back(make_pair(inicio_ventana(v), fin_ventana(v) - 1));
+    }
+
+    return true;
+}
+
+// ************************************************************************************************
+void Dmr_engine::compactar_ventanas(int mh)
+{
+    uint   paso      = uint(pow(2, config.dmr_dwt_level));
+    uint   ultima    = (limite_superior - limite_inferior) / paso;
+    double cobertura = mh == 0 ? config.mc_min_coverage : config.hmc_min_coverage;
+
+    // ventanas con alguna posición con cobertura de cada muestra, con los registros ordenados por
+    // posición, repartiendo las muestras entre hilos
+    vector<vector<uint>> ocupadas_muestra(mc.size());
+    en_paralelo(mc.size(), [&](size_t i) {
+        const Registros_muestra &r = mc[i];
+        vector<uint>            &v = ocupadas_muestra[i];
+        for (size_t k = 0; k < r.size(); k++)
+        {
+            if (r[k][mh == 0 ? 2 : 8] < cobertura)
+                continue;
+
+            uint ventana = uint(r[k][0] - limite_inferior) / paso;
+            if (v.empty() || v.back() != ventana)
+                v.push_back(ventana);
+        }
+        r.soltar();
+    });
+
+    // unión de todas las muestras en un bit por ventana del cromosoma
+    vector<quint64> bits(ultima / 64 + 1, 0);
+    for (const vector<uint> &v : ocupadas_muestra)
+        for (uint ventana : v)
+            bits[ventana >> 6] |= quint64(1) << (ventana & 63);
+
+    // sin ventanas objetivo se recorren las palabras ocupadas bit a bit, saltando las vacías
+    vector<uint> ocupadas;
+    size_t       total = ventanas_objetivo.empty() ? size_t(ultima) + 1 : ventanas_objetivo.size();
+    if (ventanas_objetivo.empty())
+    {
+        for (size_t w = 0; w < bits.size(); w++)
+            for (quint64 b = bits[w]; b != 0; b &= b - 1)
+                ocupadas.push_back(uint(w * 64 + qCountTrailingZeroBits(b)));
+    }
+    else
+    {
+        for (uint ventana : ventanas_objetivo)
+            if (bits[ventana >> 6] >> (ventana & 63) & 1)
+                ocupadas.push_back(ventana);
+    }
+
+    // la transformada necesita al menos dos ventanas; sin nada que quitar se deja como está
+    if (ocupadas.size() < 2 || ocupadas.size() == total)
+        return;
+
+    qDebug() << "ventanas ocupadas:" << ocupadas.size() << "de" << total;
+    ventanas_objetivo.swap(ocupadas);
+}
+
+// ************************************************************************************************
+void Dmr_engine::leer_referencias(int chrom)
+{
+    // se lanza el hilo de carga de referencias genéticas
+    hilo_refGen           = new QThread();
+    RefGen *refGen_worker = new RefGen();
+    refGen_worker->moveToThread(hilo_refGen);
+    connect(refGen_worker, SIGNAL(terminado(ulong)), this, SLOT(refGen_worker_acabado(ulong)), Qt::DirectConnection);
+    connect(hilo_refGen, &QThread::finished, refGen_worker, &QObject::deleteLater);
+    refGen_worker->connect(hilo_refGen, SIGNAL(started()), SLOT(lectura()));
+    hilo_refGen->connect(refGen_worker,SIGNAL(lectura_solicitada()), SLOT(start()));
+    hilo_refGen->connect(refGen_worker, SIGNAL(finished()), SLOT(quit()), Qt::DirectConnection);
+
+    refGen_worker->solicitud_lectura(cuda_data, chrom);
+}
+
+// ************************************************************************************************
+void Dmr_engine::devolver_muestras()
+{
+    for (int i = 0; i < claves_mc.size() && uint(i) < mc.size(); i++)
+        if (claves_mc.indexOf(claves_mc.at(i)) == i && muestras.contains(claves_mc.at(i)))
+            muestras[claves_mc.at(i)].datos.swap(mc[uint(i)]);
+
+    // las filas ya vacías se descartan, el vector de filas conserva su capacidad
+    claves_mc.clear();
+    mc.clear();
+}
+
+// ************************************************************************************************
+void Dmr_engine::ajustar_memoria(int n)
+{
+    // las muestras que no usa ningún trabajo posterior del cromosoma se liberan
+    foreach (const QString &clave, muestras.keys())
+        if (usos.value(clave).isEmpty() || usos.value(clave).last() <= n)
+            descartar_muestra(clave);
+
+    if (memoria_maxima <= 0)
+        return;
+
+    // por encima del límite se liberan primero las sumas de grupo, que se rehacen con las
+    // transformadas, y después las transformadas, que son más baratas de repetir que la lectura
+    foreach (const QString &clave, sumas.keys())
+        if (memoria_cache > memoria_maxima)
+            descartar_suma(clave);
+
+    foreach (const QString &clave, transformadas.keys())
+        if (memoria_cache > memoria_maxima)
+            descartar_transformada(clave);
+
+    // y después las muestras que más tarde se vuelven a necesitar, que se leerán de nuevo
+    while (memoria_cache > memoria_maxima && !muestras.isEmpty())
+    {
+        QString lejana;
+        int     siguiente_lejano = -1;
+        foreach (const QString &clave, muestras.keys())
+        {
+            int siguiente = n + 1;
+            foreach (int u, usos.value(clave))
+                if (u > n)
+                {
+                    siguiente = u;
+                    break;
+                }
+
+            if (siguiente > siguiente_lejano)
+            {
+                siguiente_lejano = siguiente;
+                lejana           = clave;
+            }
+        }
+        descartar_muestra(lejana);
+    }
+}
+
+// ************************************************************************************************
+void Dmr_engine::descartar_muestra(const QString &clave)
+{
+    memoria_cache -= muestras[clave].datos.memoria();
+    muestras.remove(clave);
+
+    // sus transformadas tampoco volverán a usarse
+    foreach (const QString &t, transformadas.keys())
+        if (t.startsWith(clave + "|"))
+            descartar_transformada(t);
+}
+
+// ************************************************************************************************
+void Dmr_engine::descartar_transformada(const QString &clave)
+{
+    const muestra_transformada &t = transformadas[clave];
+    memoria_cache -= qint64(t.coeficientes.size() * sizeof(float) + t.posiciones.size() * sizeof(uint));
+    transformadas.remove(clave);
+}
+
+// ************************************************************************************************
+void Dmr_engine::descartar_suma(const QString &clave)
+{
+    const suma_guardada &g = sumas[clave];
+    memoria_cache -= qint64(g.suma.size() * sizeof(float) + g.cuenta.size() * sizeof(uint));
+    sumas.remove(clave);
+}
+
+// ************************************************************************************************
+void Dmr_engine::refGen_worker_acabado(ulong num_genex)
+{
+    num_genes = num_genex;
+
+    emit mensaje(QString::number(num_genes) + " known genes in chromosome");
+}
+
+// ************************************************************************************************
+void Dmr_engine::liberar_memoria()
+{
+    // libera la memoria de la GPU y la memoria RAM
+    cuda_end(cuda_data);
+    cuda_data.d_haar = nullptr;
+    cuda_data.d_aux  = nullptr;
+
+    // las matrices contiguas son de arena, que las conserva para la siguiente señal o cromosoma
+    cuda_data.mc_full  = nullptr;
+    cuda_data.h_haar_C = nullptr;
+}
+
+// ************************************************************************************************
+// ************************************************************************************************
+// HILO DE PROCESAMIENTO DE DATOS LEIDOS
+// ************************************************************************************************
+// ************************************************************************************************
+void Dmr_engine::lectura_acabada()
+{
+    // procesar el análisis de GPU aqui,
+    //    pasar resultado para identificación de DMRs y guardado de fichero a otro hilo
+    //    devolver control a lectura de ficheros de siguiente cromosoma
+
+    // incialización de variables
+    // --------------------------------------------------------------------------------------------
+    cuda_data.h_haar_L.clear();     // vector con número de datos por nivel
+    cuda_data.pitch          = 0;   // ajuste óptimo de memoria GPU para datos de cada muestra
+    cuda_data.pitch_2        = 0;   // ajuste óptimo de memoria GPU para auxiliar
+    cuda_data.sample_num     = 0;   // número de datos por muestra
+    cuda_data.samples        = 0;   // número de muestras a trasnformar
+    cuda_data.levels         = 0;   // número de niveles a transformar
+    cuda_data.data_adjust    = 0;   // ajuste desfase en división por nivel para número impar de datos
+    cuda_data.rango_inferior = 0;   // límite inferior ventana de datos a transformar
+    cuda_data.rango_superior = 1;
+
+    // libera la memoria de la GPU
+    cuda_end(cuda_data);
+
+    // cálculo de la dimensión total del cromosoma leído
+    // la dimensión o número de posiciones totales que sea número par
+    uint dimension_cromosoma = limite_superior - limite_inferior + 1;
+    if ((dimension_cromosoma & 0x01) == 1)
+        dimension_cromosoma++;
+
+    // ventanas de las regiones objetivo, que cada señal reduce a las ocupadas
+    const vector<uint> ventanas_trabajo = ventanas_objetivo;
+
+    // cromosoma y directorio de cada muestra para la telemetría
+    int chrom = cromosoma;
+    QStringList directorios;
+    foreach (const QString &clave, claves_mc)
+        directorios << clave.section('|', 0, 0);
+
+    // realiza la operación de carga en GPU y de identificación de DMRs para mC y hmC seleccionadas
+    // mh = 0 -> analiza mC si está seleccionado este análisis
+    // mh = 1 -> analiza hmC si está seleccionado este análisis
+    for (int mh = 0; mh < 2; mh++)
+    {
+        if ((!mh && config.mc) || (mh && config.hmc))
+        {
+            // en el espacio de CpGs la transformada recorre el índice común de posiciones con
+            // cobertura de la señal en lugar de todas las posiciones del cromosoma
+            ventanas_objetivo = ventanas_trabajo;
+            indice_cpg.clear();
+            uint dimension_senyal = dimension_cromosoma;
+            if (config.espacio_cpg)
+            {
+                Telemetria::Medida medida("union", chrom, mh);
+                unir_posiciones(mh, indice_cpg);
+                if (indice_cpg.empty())
+                    indice_cpg.push_back(0);
+                dimension_senyal = uint(indice_cpg.size() + indice_cpg.size() % 2);
+                medida.sitios(qint64(indice_cpg.size()));
+            }
+
+            // en la búsqueda jerárquica los candidatos del nivel grueso fijan las ventanas que se
+            // transforman al nivel pedido; sin candidatos la señal queda sin DMRs
+            bool candidatos = true;
+            if (config.nivel_grueso > config.dmr_dwt_level)
+            {
+                Telemetria::Medida medida("coarse", chrom, mh);
+                candidatos = buscar_candidatos(mh, dimension_senyal, directorios);
+                medida.ventanas(qint64(ventanas_objetivo.size()));
+            }
+
+            // con las muestras en memoria sólo se transforman las ventanas con cobertura, que en el
+            // espacio de CpGs son todas
+            // ..los trabajos de una hoja de muestras transforman todas para compartir las columnas
+            if (candidatos && !por_muestra && !config.estacionaria && !config.espacio_cpg && config.cohorte.isEmpty())
+                compactar_ventanas(mh);
+
+            // con ventanas objetivo se transforman una tras otra
+            // ..cada coeficiente del nivel pedido depende sólo de las posiciones de su ventana
+            uint dimension = dimension_senyal;
+            if (!ventanas_objetivo.empty())
+                dimension = uint(ventanas_objetivo.size()) * uint(pow(2, config.dmr_dwt_level));
+
+            if (candidatos)
+                transformar_muestras(mh, dimension, directorios);
+
+            // comprueba la memoria disponible en la tarjeta gráfica para controlar los ficheros a cargar
+            memory_available = memoria_gpu_disponible();
+
+            // con los resultados completos en la matriz, pasa a la identificación de DMRs
+            if (candidatos)
+            {
+                Telemetria::Medida medida("search", chrom, mh);
+                medida.ventanas(qint64(mc.size()) * cuda_data.h_haar_L[0]);
+                find_dmrs();
+            }
+
+            // cada muestra con cada otra sobre las mismas transformadas; sin candidatos la matriz
+            // del cromosoma queda a cero
+            if (!config.pares.isEmpty() && !por_muestra)
+            {
+                Telemetria::Medida medida("pairs", chrom, mh);
+                medida.dmrs(comparar_pares(mh, candidatos ? size_t(cuda_data.h_haar_L[0]) : 0));
+            }
+
+            // une las ventanas en DMRs y los anota con el gen más cercano
+            {
+                Telemetria::Medida medida("annotate", chrom, mh);
+                if (candidatos)
+                    hallar_dmrs();
+                else
+                    dmrs.clear();
+                medida.dmrs(dmrs.size());
+            }
+
+            // extremos de los DMRs con la resolución de las posiciones
+            preparar_regiones();
+            if (config.refinar && !regiones.empty())
+            {
+                Telemetria::Medida medida("refine", chrom, mh);
+                refinar_dmrs(mh);
+                medida.dmrs(dmrs.size());
+            }
+
+            // p-valores de los DMRs con los reads de sus posiciones
+            if (config.beta_binomial && config.grupos.isEmpty() && !regiones.empty())
+            {
+                Telemetria::Medida medida("counts", chrom, mh);
+                probar_beta_binomial(mh);
+                medida.dmrs(dmrs.size());
+            }
+
+            // p-valores de los DMRs permutando las etiquetas de las muestras
+            if (config.permutaciones > 0 && config.grupos.isEmpty() && !por_muestra && !regiones.empty())
+            {
+                Telemetria::Medida medida("permute", chrom, mh);
+                permutar_etiquetas(mh);
+                medida.dmrs(dmrs.size());
+            }
+
+            // características de cada muestra en los DMRs hallados
+            // ..en el modo por muestra cada muestra se vuelve a leer y a transformar, leyendo sólo
+            // los tramos de los DMRs y los dos registros que siguen a cada uno, que medir_muestra
+            // mira tras el último del DMR; con regiones objetivo o candidatos se leen sus tramos,
+            // como en la primera lectura, para que las características no cambien
+            {
+                Telemetria::Medida medida("regions", chrom, mh);
+                if (!por_muestra)
+                {
+                    for (uint j = 0; j < mc.size(); j++)
+                        medir_muestra(j, h_haar_C[j], mh);
+                }
+                else if (!regiones.empty())
+                {
+                    bool por_dmrs = tramos_lectura.empty();
+                    if (por_dmrs)
+                    {
+                        tramos_lectura     = tramos_dmrs();
+                        siguientes_lectura = 2;
+                    }
+                    transformar_por_muestra(mh, dimension, directorios, true);
+                    if (por_dmrs)
+                    {
+                        tramos_lectura.clear();
+                        siguientes_lectura = 0;
+                    }
+                }
+                medida.dmrs(dmrs.size());
+            }
+
+            // con los DMRs identificados, salva el resultado en un fichero
+            {
+                Telemetria::Medida medida("write", chrom, mh);
+                save_dmr_list(mh);
+                medida.dmrs(dmrs.size());
+                if (Telemetria::activa())
+                    medida.bytes(QFileInfo(fichero).size() + QFileInfo(fichero_gff).size());
+            }
+
+            contador++;
+            emit progreso(contador, maximo_progreso());
+        }
+
+        // libera la memoria de la GPU y la memoria RAM
+        liberar_memoria();
+    }
+}
+
+// ************************************************************************************************
+void Dmr_engine::transformar_muestras(int mh, uint dimension, const QStringList &directorios)
+{
+    // limpia las posiciones metiladas de la señal anterior
+    // ..cada fila conserva la memoria reservada por las señales y cromosomas anteriores
+    posicion_metilada.resize(mc.size());
+    for (uint i = 0; i < mc.size(); i++)
+        posicion_metilada[i].clear();
+
+    // número de coeficientes por nivel, necesario aunque no haya nada que transformar
+    cuda_data.sample_num  = dimension;
+    cuda_data.levels      = config.dmr_dwt_level;
+    cuda_data.data_adjust = 0;
+    cuda_data.h_haar_L.clear();
+    cuda_calculo_haar_L(cuda_data);
+
+    // con la transformada estacionaria hay una ventana por ancla en lugar de una por 2^nivel
+    // posiciones
+    anclas.clear();
+    if (config.estacionaria)
+    {
+        preparar_anclas(mh);
+        cuda_data.h_haar_L.assign(1, int(anclas.size()));
+    }
+
+    if (por_muestra)
+    {
+        // cada muestra se suma a la media de su grupo según se transforma
+        transformar_por_muestra(mh, dimension, directorios, false);
+    }
+    else
+    {
+        // matriz contigua de coeficientes de todas las muestras, una fila por muestra, en la que
+        // escribe directamente la transformada y que leen la búsqueda y el guardado de DMRs
+        float **filas_C = arena.coeficientes(int(mc.size()), size_t(cuda_data.h_haar_L[0]));
+        h_haar_C        = Vista_matriz(filas_C[0], mc.size(), size_t(cuda_data.h_haar_L[0]));
+
+        // las muestras ya transformadas por un trabajo anterior con la misma señal, cobertura,
+        // nivel y ventana del cromosoma se recuperan, el resto se transforma en GPU
+        QStringList  claves_t;
+        vector<uint> pendientes;
+        QString      ventanas_clave = QCryptographicHash::hash(
+                         QByteArray(reinterpret_cast<const char *>(ventanas_objetivo.data()),
+                                    int(ventanas_objetivo.size() * sizeof(uint))),
+                         QCryptographicHash::Sha1).toHex();
+        for (uint i = 0; i < mc.size(); i++)
+        {
+            claves_t << claves_mc.at(int(i)) + "|" + QString::number(mh) +
+                        "|" + QString::number(mh ? config.hmc_min_coverage : config.mc_min_coverage) +
+                        "|" + QString::number(config.dmr_dwt_level) +
+                        "|" + QString::number(limite_inferior) + "|" + QString::number(dimension);
+
+            // las anclas de la transformada estacionaria dependen de todas las muestras del trabajo
+            if (config.estacionaria)
+                claves_t.last() += "|swt|" + config.lista_casos.join(",") + ";" + config.lista_control.join(",");
+
+            // igual que las columnas del índice de CpGs
+            if (config.espacio_cpg)
+                claves_t.last() += "|cpg|" + config.lista_casos.join(",") + ";" + config.lista_control.join(",");
+
+            // las ventanas objetivo de las regiones, los candidatos o la compactación dependen de
+            // todas las muestras del trabajo, las columnas sólo coinciden con las mismas ventanas
+            if (!ventanas_objetivo.empty())
+                claves_t.last() += "|" + ventanas_clave;
+
+            if (transformadas.contains(claves_t.last()))
+            {
+                const muestra_transformada &t = transformadas[claves_t.last()];
+                copy(t.coeficientes.begin(), t.coeficientes.end(), h_haar_C[i]);
+                posicion_metilada[i] = t.posiciones;
+            }
+            else
+                pendientes.push_back(i);
+        }
+
+        // realiza el cálculo de DWT en GPU
+        // selecciona bloques de filas pendientes para procesar en GPU hasta procesarlas todas
+        uint filas_procesadas = 0;
+        uint filas_a_GPU      = 1;
+
+        // filas de mc y de la matriz de coeficientes de las muestras de cada bloque
+        vector<uint>   bloque;
+        vector<float*> filas_bloque;
+        bloque.reserve(pendientes.size());
+        filas_bloque.reserve(pendientes.size());
+
+        while (filas_procesadas < pendientes.size())
+        {
+            // calcula el tamaño de la matriz de datos
+            filas_a_GPU  = 1;
+            uint tamanyo = dimension * filas_a_GPU * sizeof(float) / (1024 * 1024);  // tamaño en MiB
+
+            // calcula el número de filas de mc que puede procesar en GPU simultaneamente
+            // ..la transformada estacionaria se calcula en CPU con todas las filas a la vez
+            if (config.estacionaria)
+                filas_a_GPU = uint(pendientes.size()) - filas_procesadas;
+
+            while (!config.estacionaria && tamanyo < 0.5 * memory_available)
+            {
+                if (filas_a_GPU + filas_procesadas < pendientes.size())
+                    filas_a_GPU++;
+                else
+                    break;
+
+                tamanyo = dimension * filas_a_GPU * sizeof(float) / (1024 * 1024);  // tamaño en MiB
+            }
+
+            filas_procesadas += filas_a_GPU;
+
+            qDebug() << "-----  hola 3 " << "- filas procesadas / GPU" << filas_procesadas << "/" << filas_a_GPU;
+
+            bloque.assign(pendientes.begin() + (filas_procesadas - filas_a_GPU),
+                          pendientes.begin() + filas_procesadas);
+            filas_bloque.clear();
+            for (uint posicion : bloque)
+                filas_bloque.push_back(filas_C[posicion]);
+
+            transformar_bloque(bloque, filas_bloque.data(), mh, dimension, directorios);
+        }
+
+        // guarda las transformadas nuevas de las muestras que usa algún trabajo posterior
+        for (uint i : pendientes)
+        {
+            QList<int> u = usos.value(claves_mc.at(int(i)));
+            if (u.isEmpty() || u.last() <= trabajo_cromosoma || transformadas.contains(claves_t.at(int(i))))
+                continue;
+
+            muestra_transformada &t = transformadas[claves_t.at(int(i))];
+            t.coeficientes.assign(h_haar_C[i], h_haar_C[i] + h_haar_C.columnas());
+            t.posiciones   = posicion_metilada[i];
+            memoria_cache += qint64(t.coeficientes.size() * sizeof(float) + t.posiciones.size() * sizeof(uint));
+        }
+
+        claves_transformada = claves_t;
+
+        qDebug() << "tamaño final matriz de datos h_haar_C: " << h_haar_C.size() << "x" << h_haar_C.columnas()
+                 << " y pos_met:" << posicion_metilada.size() << posicion_metilada.at(0).size();
+    }
+}
+
+// ************************************************************************************************
+bool Dmr_engine::buscar_candidatos(int mh, uint dimension, const QStringList &directorios)
+{
+    ventanas_objetivo.clear();
+    tramos_lectura.clear();
+
+    // transformada y búsqueda de siempre en todo el cromosoma al nivel grueso, que el resto del
+    // motor toma de la configuración del trabajo
+    int nivel            = config.dmr_dwt_level;
+    config.dmr_dwt_level = config.nivel_grueso;
+    transformar_muestras(mh, dimension, directorios);
+    find_dmrs();
+    config.dmr_dwt_level = nivel;
+
+    // ventanas gruesas sobre el umbral y sus vecinas, para no perder los extremos de un DMR que
+    // asoma a la ventana de al lado
+    uint ultima_gruesa = ultima_ventana(config.nivel_grueso);
+    vector<bool> marcadas(ultima_gruesa + 1, false);
+    for (uint m = 0; m < dmr_diff_cols && m <= ultima_gruesa; m++)
+        if (dmr_diff[m] < -_threshold || dmr_diff[m] > _threshold)
+            for (uint v = (m > 0 ? m - 1 : 0); v <= qMin(m + 1, ultima_gruesa); v++)
+                marcadas[v] = true;
+
+    // cada ventana gruesa se divide en 2^(nivel grueso - nivel) ventanas del nivel pedido
+    uint factor = 1u << (config.nivel_grueso - nivel);
+    uint ultima = ultima_ventana(nivel);
+    for (uint c = 0; c <= ultima_gruesa; c++)
+        if (marcadas[c])
+            for (uint v = c * factor; v < (c + 1) * factor && v <= ultima; v++)
+                ventanas_objetivo.push_back(v);
+
+    return completar_ventanas();
+}
+
+// ************************************************************************************************
+void Dmr_engine::transformar_bloque(const vector<uint> &bloque, float **destino, int mh, uint dimension,
+                                    const QStringList &directorios)
+{
+    int chrom = cromosoma;
+
+    if (config.estacionaria)
+    {
+        transformar_estacionaria(bloque, destino, mh, directorios);
+        return;
+    }
+
+    // actualiza estructura de datos
+    cuda_data.samples        = int(bloque.size());                      // número de ficheros a analizar
+    cuda_data.sample_num     = dimension;                               // cantidad de datos por fichero
+    cuda_data.rango_inferior = 0;                                       // primer valor cromosoma
+    cuda_data.rango_superior = limite_superior - limite_inferior;       // último valor
+    cuda_data.levels         = config.dmr_dwt_level;                    // número de niveles a transformar
+    cuda_data.data_adjust    = 0;                                       // ajuste desfase en división por nivel para número impar de datos
+    cuda_data.h_haar_L.clear();                                         // vector con número de datos por nivel
+
+    // crea matriz ampliada -------------------------------------------------------------------
+    //      -> vectores con todas las posiciones contiguas
+    //      -> con ceros en las posiciones sin metilación
+    // TODA la memoria CONTIGUA con todos los datos de todas las muestras
+    // para trasvase de datos entre GPU y CPU con CUDA, la matriz debe ser contigua completa
+    // ..arena la entrega a cero y sólo la reserva si no cabe en la de bloques anteriores
+    cuda_data.mc_full = arena.datos(cuda_data.samples, cuda_data.sample_num);
+
+    // con regiones objetivo cada posición va a su columna dentro de las ventanas transformadas
+    uint paso = uint(pow(2, config.dmr_dwt_level));
+
+    // copia de todos los datos a la matriz ampliada
+    // --------------------------------------------------------------------------------------------
+    for (uint m = 0; m < uint(cuda_data.samples); m++)
+    {
+        // rellenar con datos las posiciones metiladas si la cobertura es mayor que el umbral
+        uint   posicion = bloque[m];
+        size_t ventana  = 0;
+        size_t rango    = 0;
+
+        Telemetria::Medida medida("scatter", chrom, mh, directorios.at(int(posicion)));
+        medida.bytes(qint64(mc[posicion].size() * Registros_muestra::CAMPOS * sizeof(double)));
+
+        posicion_metilada[posicion].reserve(mc[posicion].size());
+        for (uint k = 0; k < mc[posicion].size(); k++)
+        {
+            if(mc[posicion][k][(mh == 0 ? 2 : 8)] >= (mh == 0 ? config.mc_min_coverage : config.hmc_min_coverage))
+            {
+                uint columna = uint(mc[posicion][k][0] - limite_inferior);
+
+                // en el espacio de CpGs la columna es el orden de la posición en el índice, que
+                // contiene todas las posiciones con cobertura
+                if (!indice_cpg.empty())
+                {
+                    while (rango + 1 < indice_cpg.size() && indice_cpg[rango] < columna)
+                        rango++;
+                    columna = uint(rango);
+                }
+
+                // las posiciones fuera de las ventanas objetivo se descartan
+                if (!en_objetivo(columna, paso, ventana))
+                    continue;
+                if (!ventanas_objetivo.empty())
+                    columna = uint(ventana) * paso + columna % paso;
+
+                cuda_data.mc_full [m][columna] = float(mc[posicion][k][(mh == 0 ? 1 : 7)]);
+
+                posicion_metilada[posicion].push_back(columna);
+            }
+        }
+
+        medida.sitios(qint64(posicion_metilada[posicion].size()));
+
+        // fuera de memoria las páginas ya recorridas no ocupan RAM
+        mc[posicion].soltar();
+    }
+
+    // envía los datos a la memoria global de la GPU
+    // --------------------------------------------------------------------------------------------
+    {
+        Telemetria::Medida medida("transfer", chrom, mh);
+        medida.bytes(qint64(cuda_data.samples) * cuda_data.sample_num * qint64(sizeof(float)));
+
+        // libera la memoria de la GPU
+        cuda_end(cuda_data);
+
+        // envía el total de los datos a la GPU
+        cuda_send_data(cuda_data);
+    }
+
+    // con los datos en la GPU, la matriz vuelve a quedar a cero borrando sólo lo escrito
+    for (uint m = 0; m < uint(cuda_data.samples); m++)
+        arena.devolver_datos(int(m), posicion_metilada[bloque[m]]);
+
+    // procesado de los datos
+    // ..incluye la copia de los coeficientes de vuelta a la memoria del host, directamente
+    // en las filas de destino de sus muestras
+    Telemetria::Medida medida("transform", chrom, mh);
+
+    cuda_data.h_haar_C = destino;
+
+    cuda_calculo_haar_L(cuda_data);
+    cuda_main(cuda_data);
+
+    medida.ventanas(qint64(cuda_data.samples) * cuda_data.h_haar_L[0]);
+    medida.bytes(qint64(cuda_data.samples) * cuda_data.h_haar_L[0] * qint64(sizeof(float)));
+}
+
+// ************************************************************************************************
+bool Dmr_engine::en_objetivo(uint columna, uint paso, size_t &ventana) const
+{
+    if (ventanas_objetivo.empty())
+        return true;
+
+    while (ventana < ventanas_objetivo.size() && ventanas_objetivo[ventana] < columna / paso)
+        ventana++;
+
+    return ventana < ventanas_objetivo.size() && ventanas_objetivo[ventana] == columna / paso;
+}
+
+// ************************************************************************************************
+void Dmr_engine::preparar_anclas(int mh)
+{
+    unir_posiciones(mh, anclas);
+
+    // sin posiciones queda una sola ventana vacía, que no da ningún DMR
+    if (anclas.empty())
+        anclas.push_back(0);
+}
+
+// ************************************************************************************************
+void Dmr_engine::unir_posiciones(int mh, vector<uint> &posiciones)
+{
+    uint   paso      = uint(pow(2, config.dmr_dwt_level));
+    double cobertura = mh == 0 ? config.mc_min_coverage : config.hmc_min_coverage;
+
+    // posiciones con cobertura de una muestra en las ventanas objetivo, ordenadas como sus registros
+    auto recoger = [&](const Registros_muestra &r, vector<uint> &destino) {
+        size_t ventana = 0;
+        for (size_t k = 0; k < r.size(); k++)
+        {
+            uint columna = uint(r[k][0] - limite_inferior);
+            if (r[k][mh == 0 ? 2 : 8] >= cobertura && en_objetivo(columna, paso, ventana) &&
+                (destino.empty() || destino.back() != columna))
+                destino.push_back(columna);
+        }
+        r.soltar();
+    };
+
+    posiciones.clear();
+
+    // en el modo por muestra las filas de mc están vacías y cada muestra se lee para recorrerla
+    if (por_muestra)
+    {
+        vector<uint> muestra, unidas;
+        for (uint i = 0; i < mc.size() && !aborted; i++)
+        {
+            muestra.clear();
+            recoger(leer_muestra(i), muestra);
+
+            unidas.clear();
+            set_union(posiciones.begin(), posiciones.end(), muestra.begin(), muestra.end(), back_inserter(unidas));
+            posiciones.swap(unidas);
+        }
+        return;
+    }
+
+    vector<vector<uint>> listas(mc.size());
+    en_paralelo(mc.size(), [&](size_t i) { recoger(mc[i], listas[i]); });
+
+    // mezcla de todas las listas a la vez: el montículo da la menor cabeza pendiente
+    typedef pair<uint, size_t> cabeza;
+    priority_queue<cabeza, vector<cabeza>, greater<cabeza>> monticulo;
+    vector<size_t> siguiente(listas.size(), 1);
+    size_t         total = 0;
+    for (size_t i = 0; i < listas.size(); i++)
+    {
+        total = max(total, listas[i].size());
+        if (!listas[i].empty())
+            monticulo.push(make_pair(listas[i][0], i));
+    }
+
+    posiciones.reserve(total);
+    while (!monticulo.empty())
+    {
+        cabeza c = monticulo.top();
+        monticulo.pop();
+
+        if (posiciones.empty() || posiciones.back() != c.first)
+            posiciones.push_back(c.first);
+
+        if (siguiente[c.second] < listas[c.second].size())
+            monticulo.push(make_pair(listas[c.second][siguiente[c.second]++], c.second));
+    }
+}
+
+// ************************************************************************************************
+uint Dmr_engine::ultima_ventana(int nivel) const
+{
+    if (indice_cpg.empty())
+        return (limite_superior - limite_inferior) >> nivel;
+
+    return uint(indice_cpg.size() - 1) >> nivel;
+}
+
+// ************************************************************************************************
+uint Dmr_engine::inicio_ventana(uint v) const
+{
+    uint paso = uint(pow(2, config.dmr_dwt_level));
+    if (indice_cpg.empty())
+        return limite_inferior + v * paso;
+
+    return limite_inferior + indice_cpg[qMin(size_t(v) * paso, indice_cpg.size() - 1)];
+}
+
+// ************************************************************************************************
+uint Dmr_engine::fin_ventana(uint v) const
+{
+    uint paso = uint(pow(2, config.dmr_dwt_level));
+    if (indice_cpg.empty())
+        return limite_inferior + (v + 1) * paso;
+
+    return limite_inferior + indice_cpg[qMin(size_t(v + 1) * paso, indice_cpg.size()) - 1] + 1;
+}
+
+// ************************************************************************************************
+uint Dmr_engine::inicio_coeficiente(uint m) const
+{
+    if (!anclas.empty())
+        return anclas[m] + limite_inferior;
+
+    return inicio_ventana(ventanas_objetivo.empty() ? m : ventanas_objetivo[m]);
+}
+
+// ************************************************************************************************
+uint Dmr_engine::fin_coeficiente(uint m) const
+{
+    if (!anclas.empty())
+        return anclas[m] + limite_inferior + uint(pow(2, config.dmr_dwt_level));
+
+    return fin_ventana(ventanas_objetivo.empty() ? m : ventanas_objetivo[m]);
+}
+
+// ************************************************************************************************
+bool Dmr_engine::contigua(uint m) const
+{
+    // ventanas objetivo seguidas en el cromosoma, ventanas estacionarias que se solapan o se tocan
+    if (!anclas.empty())
+        return anclas[m + 1] <= anclas[m] + uint(pow(2, config.dmr_dwt_level));
+
+    return ventanas_objetivo.empty() || ventanas_objetivo[m + 1] == ventanas_objetivo[m] + 1;
+}
+
+// ************************************************************************************************
+void Dmr_engine::transformar_estacionaria(const vector<uint> &bloque, float **destino, int mh,
+                                          const QStringList &directorios)
+{
+    int    chrom     = cromosoma;
+    uint   paso      = uint(pow(2, config.dmr_dwt_level));
+    double escala    = pow(2.0, -config.dmr_dwt_level * 0.5);
+    double cobertura = mh == 0 ? config.mc_min_coverage : config.hmc_min_coverage;
+
+    Telemetria::Medida medida("transform", chrom, mh);
+
+    auto transformar = [&](size_t m) {
+        uint                     posicion   = bloque[m];
+        const Registros_muestra &r          = mc[posicion];
+        vector<uint>            &posiciones = posicion_metilada[posicion];
+
+        Telemetria::Medida medida_muestra("scatter", chrom, mh, directorios.at(int(posicion)));
+        medida_muestra.bytes(qint64(r.size() * Registros_muestra::CAMPOS * sizeof(double)));
+
+        // posiciones metiladas con cobertura y suma acumulada de sus valores
+        vector<double> acumulada(1, 0.0);
+        posiciones.reserve(r.size());
+        acumulada.reserve(r.size() + 1);
+
+        size_t ventana = 0;
+        for (size_t k = 0; k < r.size(); k++)
+        {
+            uint columna = uint(r[k][0] - limite_inferior);
+            if (r[k][mh == 0 ? 2 : 8] >= cobertura && en_objetivo(columna, paso, ventana))
+            {
+                posiciones.push_back(columna);
+                acumulada.push_back(acumulada.back() + r[k][mh == 0 ? 1 : 7]);
+            }
+        }
+
+        medida_muestra.sitios(qint64(posiciones.size()));
+        r.soltar();
+
+        // suma de cada ventana [ancla, ancla + paso) como diferencia de dos sumas acumuladas, con
+        // los extremos avanzando a la vez que las anclas
+        float *coeficientes = destino[m];
+        size_t desde        = 0;
+        size_t hasta        = 0;
+        for (size_t a = 0; a < anclas.size(); a++)
+        {
+            while (desde < posiciones.size() && posiciones[desde] < anclas[a])
+                desde++;
+            hasta = max(hasta, desde);
+            while (hasta < posiciones.size() && posiciones[hasta] < anclas[a] + paso)
+                hasta++;
+
+            coeficientes[a] = float((acumulada[hasta] - acumulada[desde]) * escala);
+        }
+    };
+
+    // las muestras se reparten entre hilos según van acabando, sus tamaños son distintos
+    en_paralelo(bloque.size(), transformar);
+
+    medida.ventanas(qint64(bloque.size()) * qint64(anclas.size()));
+    medida.bytes(qint64(bloque.size()) * qint64(anclas.size()) * qint64(sizeof(float)));
+}
+
+// ************************************************************************************************
+Registros_muestra Dmr_engine::leer_muestra(uint i)
+{
+    // la muestra se lee como la única de la lista y se descarta tras usarla, sin volcarla al disco
+    QStringList argumentos = parametros;
+    argumentos[3] = "0";
+    argumentos[4] = QString();
+
+    vector<Registros_muestra> leida(1);
+    Files_worker lector;
+    lector.limitar_tramos(tramos_lectura, siguientes_lectura);
+    lector.solicitud_lectura(QStringList(claves_mc.at(int(i)).section('|', 0, 0)), QStringList(),
+                             argumentos, leida, mutex);
+    lector.lectura();
+
+    return leida[0];
+}
+
+// ************************************************************************************************
+void Dmr_engine::transformar_por_muestra(int mh, uint dimension, const QStringList &directorios, bool medir)
+{
+    // una sola fila de coeficientes, reutilizada por todas las muestras
+    float **fila = arena.coeficientes(1, size_t(cuda_data.h_haar_L[0]));
+    h_haar_C     = Vista_matriz(fila[0], 1, size_t(cuda_data.h_haar_L[0]));
+
+    if (!medir)
+        iniciar_medias();
+
+    for (uint i = 0; i < mc.size() && !aborted; i++)
+    {
+        mc[i] = leer_muestra(i);
+        posicion_metilada[i].clear();
+
+        transformar_bloque(vector<uint>(1, i), fila, mh, dimension, directorios);
+
+        if (medir)
+            medir_muestra(i, fila[0], mh);
+        else
+            acumular_muestra(i, fila[0]);
+
+        // la muestra se descarta antes de leer la siguiente
+        mc[i] = Registros_muestra();
+        vector<uint>().swap(posicion_metilada[i]);
+    }
+}
+
+// ************************************************************************************************
+void Dmr_engine::iniciar_medias()
+{
+    suma_grupo.resize(size_t(numero_grupos()));
+    cuenta_grupo.resize(size_t(numero_grupos()));
+    for (int g = 0; g < numero_grupos(); g++)
+    {
+        suma_grupo[g].assign(size_t(cuda_data.h_haar_L[0]), 0.0);
+        cuenta_grupo[g].assign(size_t(cuda_data.h_haar_L[0]), 0);
+    }
+    ocupacion.assign(size_t(cuda_data.h_haar_L[0]) / 64 + 1, 0);
+}
+
+// ************************************************************************************************
+int Dmr_engine::numero_grupos() const
+{
+    int grupos = 2;
+    foreach (int g, config.grupos)
+        grupos = qMax(grupos, g + 1);
+
+    return grupos;
+}
+
+// ************************************************************************************************
+void Dmr_engine::ventanas_densas(uint i, vector<uint> &densas) const
+{
+    uint paso = uint(pow(2, config.dmr_dwt_level));
+
+    // umbral de densidad de posiciones metiladas por ventana
+    double min_cpg = paso * uint(config.min_cpg_x_region) * 0.01;
+
+    const vector<uint> &posiciones = posicion_metilada[i];
+    densas.clear();
+
+    // ventanas de la transformada estacionaria: posiciones de la muestra en [ancla, ancla + paso),
+    // con las anclas y las posiciones ordenadas
+    if (!anclas.empty())
+    {
+        size_t desde = 0;
+        size_t hasta = 0;
+        for (size_t m = 0; m < anclas.size(); m++)
+        {
+            while (desde < posiciones.size() && posiciones[desde] < anclas[m])
+                desde++;
+            hasta = max(hasta, desde);
+            while (hasta < posiciones.size() && posiciones[hasta] < anclas[m] + paso)
+                hasta++;
+
+            if (hasta - desde >= min_cpg)
+                densas.push_back(uint(m));
+        }
+        return;
+    }
+
+    // recorre sólo las posiciones metiladas de la muestra, ventana a ventana: las ventanas sin
+    // posiciones no llegan al umbral de densidad
+    // ..como siempre, la posición que abre una ventana y la última de la muestra no cuentan
+    size_t k = 0;
+    while (k + 1 < posiciones.size())
+    {
+        uint m          = posiciones[k] / paso;
+        uint en_ventana = 0;
+        for (; k + 1 < posiciones.size() && posiciones[k] / paso == m; k++)
+            if (posiciones[k] % paso != 0)
+                en_ventana++;
+
+        if (en_ventana >= min_cpg && m < uint(cuda_data.h_haar_L[0]))
+            densas.push_back(m);
+    }
+}
+
+// ************************************************************************************************
+void Dmr_engine::acumular_muestra(uint i, const float *coeficientes)
+{
+    vector<float> &suma   = suma_grupo[size_t(grupo_muestra[i])];
+    vector<uint>  &cuenta = cuenta_grupo[size_t(grupo_muestra[i])];
+
+    vector<uint> densas;
+    ventanas_densas(i, densas);
+    for (uint m : densas)
+    {
+        suma[m] += coeficientes[m];
+        cuenta[m]++;
+        ocupacion[m >> 6] |= quint64(1) << (m & 63);
+    }
+}
+
+// ************************************************************************************************
+void Dmr_engine::sumar_grupos()
+{
+    iniciar_medias();
+
+    size_t ventanas = size_t(cuda_data.h_haar_L[0]);
+    size_t grupos   = size_t(numero_grupos());
+
+    vector<vector<uint>> muestras_grupo(grupos);
+    for (uint i = 0; i < h_haar_C.size(); i++)
+        muestras_grupo[size_t(grupo_muestra[i])].push_back(i);
+
+    // en los trabajos de una hoja de muestras, las sumas de los grupos que ya ha sumado un trabajo
+    // anterior del cromosoma con las mismas transformadas, que marcan su ocupación
+    // ..la clave de un grupo son las claves de transformada de sus muestras, sin su orden
+    vector<QString> claves_grupo(grupos);
+    vector<bool>    sumado(grupos, false);
+    for (size_t g = 0; g < grupos && !config.cohorte.isEmpty(); g++)
+    {
+        QStringList claves;
+        foreach (uint i, muestras_grupo[g])
+            claves << claves_transformada.at(int(i));
+        claves.sort();
+        claves_grupo[g] = claves.join(";") + "|" + QString::number(config.min_cpg_x_region);
+
+        if (!sumas.contains(claves_grupo[g]))
+            continue;
+
+        const suma_guardada &guardada = sumas[claves_grupo[g]];
+        suma_grupo[g]   = guardada.suma;
+        cuenta_grupo[g] = guardada.cuenta;
+        sumado[g]       = true;
+        for (size_t m = 0; m < ventanas; m++)
+            if (guardada.cuenta[m] > 0)
+                ocupacion[m >> 6] |= quint64(1) << (m & 63);
+    }
+
+    // ventanas con densidad suficiente de cada muestra de los grupos por sumar, en paralelo
+    vector<vector<uint>> densas(h_haar_C.size());
+    en_paralelo(h_haar_C.size(), [&](size_t i) {
+        if (!sumado[size_t(grupo_muestra[i])])
+            ventanas_densas(uint(i), densas[i]);
+    });
+
+    // cada tarea recorre un tramo de bloques de 64 ventanas, una palabra del mapa de ocupación,
+    // buscando una sola vez por muestra el inicio del tramo en sus ventanas densas
+    size_t bloques = (ventanas + 63) / 64;
+    size_t tramos  = (bloques + BLOQUES_POR_TRAMO - 1) / BLOQUES_POR_TRAMO;
+    en_paralelo(tramos, [&](size_t t) {
+        vector<float>  coeficientes, marcas;
+        vector<size_t> cursor;
+
+        for (size_t g = 0; g < grupos; g++)
+        {
+            if (sumado[g])
+                continue;
+
+            const vector<uint> &muestras = muestras_grupo[g];
+            size_t              n        = muestras.size();
+
+            cursor.resize(n);
+            for (size_t s = 0; s < n; s++)
+            {
+                const vector<uint> &d = densas[muestras[s]];
+                cursor[s] = size_t(lower_bound(d.begin(), d.end(), uint(t * BLOQUES_POR_TRAMO * 64)) - d.begin());
+            }
+
+            for (size_t b = t * BLOQUES_POR_TRAMO; b < qMin(bloques, (t + 1) * BLOQUES_POR_TRAMO); b++)
+            {
+                size_t desde = b * 64;
+                size_t ancho = qMin(ventanas, desde + 64) - desde;
+
+                // un bloque sin ventanas densas en ninguna muestra del grupo se queda a cero, sin
+                // transponerlo
+                bool densa = false;
+                for (size_t s = 0; s < n && !densa; s++)
+                    densa = cursor[s] < densas[muestras[s]].size() && densas[muestras[s]][cursor[s]] < desde + ancho;
+                if (!densa)
+                    continue;
+
+                // transpuesta del bloque con una fila por ventana y una columna por muestra del
+                // grupo, sólo con los coeficientes de las ventanas densas de cada muestra
+                coeficientes.assign(ancho * n, 0.0f);
+                marcas.assign(ancho * n, 0.0f);
+                for (size_t s = 0; s < n; s++)
+                {
+                    const vector<uint> &d    = densas[muestras[s]];
+                    const float        *fila = h_haar_C[muestras[s]];
+                    for (; cursor[s] < d.size() && d[cursor[s]] < desde + ancho; cursor[s]++)
+                    {
+                        size_t m = d[cursor[s]];
+                        coeficientes[(m - desde) * n + s] = fila[m];
+                        marcas[(m - desde) * n + s]       = 1.0f;
+                    }
+                }
+
+                // sumas de cada ventana sobre memoria contigua, vectorizadas entre muestras
+                quint64 ocupadas = 0;
+                for (size_t w = 0; w < ancho; w++)
+                {
+                    const float *c      = coeficientes.data() + w * n;
+                    const float *k      = marcas.data() + w * n;
+                    float        suma   = 0.0f;
+                    float        cuenta = 0.0f;
+                    #pragma omp simd reduction(+:suma, cuenta)
+                    for (size_t s = 0; s < n; s++)
+                    {
+                        suma   += c[s];
+                        cuenta += k[s];
+                    }
+
+                    suma_grupo[g][desde + w]   = suma;
+                    cuenta_grupo[g][desde + w] = uint(cuenta);
+                    if (cuenta > 0.0f)
+                        ocupadas |= quint64(1) << w;
+                }
+
+                // cada bloque escribe sólo su palabra; las de todos los grupos se unen
+                ocupacion[b] |= ocupadas;
+            }
+        }
+    });
+
+    for (size_t g = 0; g < grupos && !config.cohorte.isEmpty(); g++)
+    {
+        if (sumado[g])
+            continue;
+
+        suma_guardada &guardada = sumas[claves_grupo[g]];
+        guardada.suma   = suma_grupo[g];
+        guardada.cuenta = cuenta_grupo[g];
+        memoria_cache  += qint64(ventanas * (sizeof(float) + sizeof(uint)));
+    }
+}
+
+// ************************************************************************************************
+int Dmr_engine::comparar_pares(int mh, size_t ventanas)
+{
+    size_t n       = h_haar_C.size();
+    bool   control = config.pares == "control";
+
+    // columnas de la matriz traspuesta: las muestras y, contra los controles, su media
+    size_t columnas = n + (control ? 1 : 0);
+    size_t filas    = control ? size_t(config.lista_casos.size()) : n;
+    uint   min_controles = uint(config.lista_control.length() * (config.min_samples_x_region * 0.01));
+
+    vector<vector<uint>> densas(n);
+    en_paralelo(n, [&](size_t i) { ventanas_densas(uint(i), densas[i]); });
+
+    // coeficientes de las ventanas densas de cada muestra y sus marcas, una fila por ventana y una
+    // columna por muestra, como al sumar los grupos; las ventanas sin densidad quedan a cero
+    vector<float> coeficientes(ventanas * columnas, 0.0f);
+    vector<float> marcas(ventanas * columnas, 0.0f);
+    size_t        tramo = BLOQUES_POR_TRAMO * 64;
+    en_paralelo((ventanas + tramo - 1) / tramo, [&](size_t t) {
+        size_t hasta = qMin(ventanas, (t + 1) * tramo);
+        for (size_t i = 0; i < n; i++)
+        {
+            const vector<uint> &d = densas[i];
+            for (auto m = lower_bound(d.begin(), d.end(), uint(t * tramo)); m != d.end() && *m < hasta; ++m)
+            {
+                coeficientes[*m * columnas + i] = h_haar_C[i][*m];
+                marcas[*m * columnas + i]       = 1.0f;
+            }
+        }
+
+        // media de los controles con el mismo mínimo de muestras que la búsqueda por grupos
+        for (size_t m = t * tramo; control && m < hasta; m++)
+        {
+            if (cuenta_grupo[1][m] == 0 || cuenta_grupo[1][m] < min_controles)
+                continue;
+
+            coeficientes[m * columnas + n] = suma_grupo[1][m] / cuenta_grupo[1][m];
+            marcas[m * columnas + n]       = 1.0f;
+        }
+    });
+
+    // ventanas que continúan la anterior en el cromosoma
+    vector<char> sigue(ventanas, 0);
+    for (size_t m = 1; m < ventanas; m++)
+        sigue[m] = contigua(uint(m - 1));
+
+    // bloques de MUESTRAS_POR_BLOQUE filas por MUESTRAS_POR_BLOQUE columnas del triángulo superior,
+    // o de casos contra la columna de la media de los controles
+    vector<pair<size_t, size_t>> bloques;
+    for (size_t f = 0; f < filas; f += MUESTRAS_POR_BLOQUE)
+    {
+        if (control)
+            bloques.push_back({f, n});
+        for (size_t c = f; !control && c < n; c += MUESTRAS_POR_BLOQUE)
+            bloques.push_back({f, c});
+    }
+
+    // cada bloque recorre todas las ventanas con sus filas y columnas de la traspuesta en caché
+    // y une en DMRs, como hallar_dmrs, las ventanas seguidas de cada par sobre el umbral
+    vector<uint>            cuenta_pares(filas * columnas, 0);
+    vector<vector<dmr_par>> listas(bloques.size());
+    en_paralelo(bloques.size(), [&](size_t b) {
+        size_t f0    = bloques[b].first;
+        size_t c0    = bloques[b].second;
+        size_t alto  = qMin(filas, f0 + MUESTRAS_POR_BLOQUE) - f0;
+        size_t ancho = control ? 1 : qMin(n, c0 + MUESTRAS_POR_BLOQUE) - c0;
+
+        // diferencia de cada par en la ventana en curso y DMR abierto de cada par
+        vector<float> diferencia(alto * ancho, 0.0f);
+        vector<uint>  desde(alto * ancho, 0);
+        vector<uint>  largo(alto * ancho, 0);
+        vector<float> suma(alto * ancho, 0.0f);
+
+        auto cerrar = [&](size_t p, size_t m) {
+            if (largo[p] == 0)
+                return;
+
+            uint a = uint(f0 + p / ancho);
+            uint c = uint(c0 + p % ancho);
+            cuenta_pares[a * columnas + c]++;
+            if (config.listas_pares)
+                listas[b].push_back({a, c, inicio_coeficiente(desde[p]), fin_coeficiente(uint(m - 1)),
+                                     suma[p] / largo[p]});
+            largo[p] = 0;
+            suma[p]  = 0.0f;
+        };
+
+        for (size_t m = 0; m < ventanas; m++)
+        {
+            const float *c = coeficientes.data() + m * columnas;
+            const float *k = marcas.data() + m * columnas;
+            for (size_t r = 0; r < alto; r++)
+            {
+                float  ca = c[f0 + r];
+                float  ka = k[f0 + r];
+                float *d  = diferencia.data() + r * ancho;
+                #pragma omp simd
+                for (size_t j = 0; j < ancho; j++)
+                    d[j] = (ca - c[c0 + j]) * ka * k[c0 + j];
+            }
+
+            for (size_t p = 0; p < alto * ancho; p++)
+            {
+                // cada par una vez, por encima de la diagonal
+                if (c0 + p % ancho <= f0 + p / ancho)
+                    continue;
+
+                if (diferencia[p] < -_threshold || diferencia[p] > _threshold)
+                {
+                    if (!sigue[m])
+                        cerrar(p, m);
+                    if (largo[p] == 0)
+                        desde[p] = uint(m);
+                    suma[p] += diferencia[p];
+                    largo[p]++;
+                }
+                else
+                    cerrar(p, m);
+            }
+        }
+
+        for (size_t p = 0; p < alto * ancho; p++)
+            cerrar(p, ventanas);
+    });
+
+    // matriz del cromosoma con el número de DMRs de cada par, simétrica con todas las muestras
+    QStringList nombres;
+    foreach (const QString &d, config.lista_casos + config.lista_control)
+        nombres << d.split("/").back();
+
+    int   total = 0;
+    QFile data(config.ruta_shard + "/" + nombre_pares(config, mh));
+    if (!data.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        emit error("An error occurred opening the file: " + data.fileName());
+        return 0;
+    }
+
+    QTextStream s(&data);
+    s << "sample\t" << (control ? QString("control_mean") : nombres.join("\t")) << "\n";
+    for (size_t a = 0; a < filas; a++)
+    {
+        s << nombres.at(int(a));
+        for (size_t c = control ? n : 0; c < columnas; c++)
+        {
+            uint numero = c >= a ? cuenta_pares[a * columnas + c] : cuenta_pares[c * columnas + a];
+            s << "\t" << numero;
+            total += c > a ? int(numero) : 0;
+        }
+        s << "\n";
+    }
+    s.flush();
+    data.close();
+
+    // DMRs de cada par, par a par y en orden de posición
+    if (config.listas_pares)
+    {
+        vector<dmr_par> lista;
+        for (const vector<dmr_par> &l : listas)
+            lista.insert(lista.end(), l.begin(), l.end());
+        stable_sort(lista.begin(), lista.end(), [](const dmr_par &x, const dmr_par &y) {
+            return x.a != y.a ? x.a < y.a : x.b < y.b;
+        });
+
+        QFile fichero_lista(config.ruta_shard + "/" + nombre_lista_pares(config, cromosoma, mh));
+        if (!fichero_lista.open(QIODevice::WriteOnly | QIODevice::Text))
+        {
+            emit error("An error occurred opening the file: " + fichero_lista.fileName());
+            return total;
+        }
+
+        QTextStream l(&fichero_lista);
+        l << "sample_a\tsample_b\tstart\tend\tmean_diff\n";
+        for (const dmr_par &p : lista)
+            l << nombres.at(int(p.a)) << "\t" << (control ? QString("control_mean") : nombres.at(int(p.b))) << "\t"
+              << p.inicio << "\t" << p.fin << "\t" << p.diferencia << "\n";
+        l.flush();
+    }
+
+    return total;
+}
+
+// ************************************************************************************************
+void Dmr_engine::find_dmrs()
+{
+    uint numero_casos;
+    uint numero_control;
+
+    // matriz de diferencias de medias por grupos de control y casos, llena de ceros
+    // ..arena sólo la reserva de nuevo si no cabe en la de señales y cromosomas anteriores
+    dmr_diff = arena.diferencias(size_t(cuda_data.h_haar_L[0]));
+
+    // umbrales de muestras con cobertura por grupo
+    uint min_casos     = uint(config.lista_casos.length()   * (config.min_samples_x_region * 0.01));
+    uint min_controles = uint(config.lista_control.length() * (config.min_samples_x_region * 0.01));
+
+    // y de cada grupo de una hoja de muestras, al menos una muestra
+    vector<uint> min_grupo(size_t(numero_grupos()), 0);
+    foreach (int g, config.grupos)
+        min_grupo[size_t(g)]++;
+    for (uint &minimo : min_grupo)
+        minimo = qMax(uint(minimo * (config.min_samples_x_region * 0.01)), 1u);
+
+    qDebug() << "----------- buscando DMRs por muestras individuales ----------";
+    uint contador = 0;
+    uint cont_diff = 0;
+
+    int ultimo_m = 0;
+
+    // medias de las muestras de control y de los casos con cobertura sobre umbral, por bloques de
+    // ventanas con todas las muestras a la vez
+    // ..en el modo por muestra ya se han sumado al transformar cada muestra
+    if (!por_muestra)
+    {
+        sumar_grupos();
+    }
+
+    // sólo las ventanas con alguna muestra sumada, palabra a palabra saltando las vacías; en el
+    // resto la diferencia queda a cero
+    uint ocupadas = 0;
+    for (size_t w = 0; w < ocupacion.size(); w++)
+        ocupadas += qPopulationCount(ocupacion[w]);
+
+    for (size_t w = 0; w < ocupacion.size(); w++)
+    {
+        for (quint64 b = ocupacion[w]; b != 0; b &= b - 1)
+        {
+            uint  m             = uint(w * 64 + qCountTrailingZeroBits(b));
+
+            // varios grupos: diferencia entre la mayor y la menor media de los grupos con cobertura
+            // suficiente, si hay al menos dos
+            if (!config.grupos.isEmpty())
+            {
+                float mayor   = 0.0f;
+                float menor   = 0.0f;
+                int   validos = 0;
+                for (size_t g = 0; g < min_grupo.size(); g++)
+                {
+                    if (cuenta_grupo[g][m] < min_grupo[g])
+                        continue;
+
+                    float media = suma_grupo[g][m] / cuenta_grupo[g][m];
+                    mayor       = validos == 0 ? media : qMax(mayor, media);
+                    menor       = validos == 0 ? media : qMin(menor, media);
+                    validos++;
+                }
+
+                if (validos >= 2)
+                {
+                    dmr_diff[m] = mayor - menor;
+                    ultimo_m    = int(m);
+                    contador++;
+                    if (dmr_diff[m] > _threshold)
+                        cont_diff++;
+                }
+                continue;
+            }
+
+            float media_casos   = suma_grupo[1][m];
+            float media_control = suma_grupo[0][m];
+            numero_casos        = cuenta_grupo[1][m];
+            numero_control      = cuenta_grupo[0][m];
+
+            //if (numero_casos > 0 && numero_control > 0)                                                                    // al menos una muestra por grupo tiene cobertura
+            if (numero_casos   >= min_casos &&
+                numero_control >= min_controles)             // al menos el XX% por grupo tienen cobertura
+            //if (numero_casos == uint(config.lista_casos.length()) && numero_control == uint(config.lista_control.length()))              // todas las muestras tienen cobertura
+            {
+                // guada diferencias solo si caso y control han resultado diferentes de cero -> hay cobertura mínima en, al menos, una muestra de caso y control
+                dmr_diff[m] = (media_casos / numero_casos) - (media_control / numero_control);
+
+                // para control de programa (a borrar)
+                ultimo_m = int(m);
+                contador++;
+
+
+            //    if (contador > 4000)
+            //        qDebug() << dmr_diff[m];
+
+
+                if (dmr_diff[m] < -_threshold || dmr_diff[m] > _threshold)
+                {
+                    cont_diff++;
+                }
+            }
+        }
+    }
+    qDebug() << "ventanas ocupadas: " << ocupadas
+             << " número de ventanas dwt con valor > 0 " << contador
+             << " número de ventanas con diff mayor que umbral: " << cont_diff
+             << " ultimo eme: " << ultimo_m
+             << " diferencia último: " << dmr_diff[ultimo_m];
+
+
+    dmr_diff_cols = uint(cuda_data.h_haar_L[0]);
+}
+
+// ************************************************************************************************
+void Dmr_engine::hallar_dmrs()
+{
+    QString linea = "";
+    // crea array con las posiciones iniciales de cada tramo en el cromosoma con DM superior al umbral
+    vector<uint> posicion_dmr (uint(cuda_data.h_haar_L[0]), 0);
+
+    // encuentra DMRs en función del threshold establecido -----------------------------
+    // rellena las posiciones con diferencias válidas
+    // si el valor de la difercia es menor que el umbral, la posición se queda con valor 0
+    // ..con regiones objetivo cada coeficiente es una de las ventanas objetivo
+    // ..con la transformada estacionaria cada coeficiente es la ventana que empieza en su ancla
+    // ..en el espacio de CpGs cada ventana son 2^nivel CpGs del índice
+    for (int m = 0; m < cuda_data.h_haar_L[0]; m++)
+        if (dmr_diff[m] < -_threshold || dmr_diff[m] > _threshold)
+            posicion_dmr[uint(m)] = inicio_coeficiente(uint(m));
+
+    // buscar y rellenar la lista de DMRs
+    dmrs.clear();
+
+
+    int inicio = 0;
+    int fin    = int(num_genes);
+    for (uint p = 0; p < uint(cuda_data.h_haar_L[0]); p++)
+    {
+        if (posicion_dmr[p] >= limite_inferior)
+        {
+            linea.clear();
+            uint q = p;     // para ayuda en la zona de detección de referencia de genoma
+
+            // busca las posiciones inicial y final de la DMR
+            //---------------------------------------------------------------------------
+            linea.append(QString::number(posicion_dmr[q]));
+
+            // un DMR no une ventanas objetivo que no son contiguas en el cromosoma, ni ventanas
+            // estacionarias que no se solapan o se tocan
+            while (p + 1 < dmr_diff_cols && posicion_dmr[p + 1] >= limite_inferior && contigua(p))
+               p++;
+
+            // en el espacio de CpGs la ventana acaba tras su último CpG
+            uint fin_dmr = fin_coeficiente(p);
+            linea.append("-" + QString::number(fin_dmr));
+
+
+            // búsqueda del nombre del GEN implicado o más cercano a los DMRs encontrados
+            //---------------------------------------------------------------------------
+            // se realiza sobre datos de la genome.ucsc.edu data base sobre genes conocidos
+            // ..previamente se han cargado los nombres y posiciones de los genes correspondientes
+            // al cromosoma que se está analizando
+            // ..por búsqueda binaria sobre este fichero se determina el nombre del gen.
+            switch (config.genome_reference)
+            {
+                case 0:
+                    break;
+
+                case 1:
+                    int mitad        = inicio;
+                    bool match       = false;
+                    uint gen_ini     = 0;
+                    uint gen_ant_fin = uint(stoul(cuda_data.refGen[0][4]));
+
+                    while (uint(stoul(cuda_data.refGen[mitad][3])) < posicion_dmr[q] && mitad < fin - 1)
+                        mitad++;
+
+                    gen_ini = uint(stoul(cuda_data.refGen[mitad][3]));
+                    if (mitad > 0)
+                        gen_ant_fin = uint(stoul(cuda_data.refGen[mitad - 1][4]));
+
+                    // el inicio dmr es igual que inicio del gen
+                    if (gen_ini == posicion_dmr[q])
+                    {
+                        match = true;
+                        linea.append(" " + QString::fromStdString(cuda_data.refGen[mitad][0]) +
+                                     " " + QString::fromStdString(cuda_data.refGen[mitad][1]) +
+                                     " 0");
+                    }
+                    // el inicio dmr es menor que inicio del gen pero el final dmr es mayor que el inicio del gen
+                    else if (gen_ini <= fin_dmr)
+                    {
+                        match = true;
+                        linea.append(" " + QString::fromStdString(cuda_data.refGen[mitad][0]) +
+                                     " " + QString::fromStdString(cuda_data.refGen[mitad][1]) +
+                                     " -" + QString::number(stoul(cuda_data.refGen[mitad][3]) > posicion_dmr[q] ?
+                                                            stoul(cuda_data.refGen[mitad][3]) - posicion_dmr[q] :
+                                                            posicion_dmr[q] - stoul(cuda_data.refGen[mitad][3])));
+                    }
+                    // el inicio dmr es mayor que inicio del gen anterior pero es menor que el fin del gen anterior
+                    else if (gen_ant_fin > posicion_dmr[q])
+                    {
+                        match = true;
+                        linea.append(" " + QString::fromStdString(cuda_data.refGen[mitad > 0? mitad - 1 : 0][0]) +
+                                     " " + QString::fromStdString(cuda_data.refGen[mitad > 0? mitad - 1 : 0][1]) +
+                                     " +" + ((posicion_dmr[q] > stoul(cuda_data.refGen[mitad > 0? mitad - 1 : 0][3])) ?
+                                            QString::number(posicion_dmr[q] - stoul(cuda_data.refGen[mitad > 0? mitad - 1 : 0][3])) :
+                                            QString::number(stoul(cuda_data.refGen[mitad > 0? mitad - 1 : 0][3]) - posicion_dmr[q])));
+                    }
+
+
+                    // si se encuentra entre genes, ver de qué gen está más cerca
+                    // se elige la distancia más pequeña entre:
+                    // ..distancia inicio dmr y fin gen anterior
+                    // ..distancia fin dmr e inicio gen posterior
+                    if (!match)
+                    {
+                        ulong dif1 = posicion_dmr[q] - gen_ant_fin;
+                        ulong dif2 = gen_ini - fin_dmr;
+
+                        if (dif1 >= dif2)
+                        {
+                            linea.append(" " + QString::fromStdString(cuda_data.refGen[mitad][0]) +
+                                         " " + QString::fromStdString(cuda_data.refGen[mitad][1]) +
+                                         " --" + QString::number(dif2));
+                        }
+                        else
+                        {
+                            linea.append(" " + QString::fromStdString(cuda_data.refGen[mitad > 0? mitad - 1 : 0][0]) +
+                                         " " + QString::fromStdString(cuda_data.refGen[mitad > 0? mitad - 1 : 0][1]) +
+                                         " ++" + QString::number(dif1));
+                        }
+                    }
+
+                    if (mitad > 0)
+                        inicio = mitad - 1;
+                    break;
+            }
+
+            // define si está hipermetilado o hipometilado el caso frente al control
+            //-----------------------------------------------------------------------
+            linea.append((dmr_diff[q] < 0)? " hipo":" hiper");
+
+            // añade resultado de análisis DWT
+            //-----------------------------------------------------------------------
+            linea.append(" " + QString::number(double(dmr_diff[q])));
+            linea.append("//" + QString::number(q) + " " + QString::number(p));
+
+            // añade la información a la lista de DMRs
+            //-----------------------------------------------------------------------
+            dmrs.append(linea);
+        }
+    }
+
+    // informa de proceso en barra inferior -----------------------------------------
+    emit mensaje(QString::number(dmrs.size()) + " DMRs found");
+
+    // pasa la lista de dmrs a la ventana de visualización
+    qDebug() << "tamaño del fichero que guarda los dmrs localizados: " << dmrs.size() << "x" << (dmrs.size() ? dmrs.at(0).size() : 0);
+}
+
+
+// ************************************************************************************************
+void Dmr_engine::preparar_regiones()
+{
+    // posiciones del DMR y posición inicial y final de la zona dwt correspondiente
+    regiones.resize(uint(dmrs.size()));
+    for (int i = 0; i < dmrs.size(); i++)
+    {
+        const QString &linea = dmrs.at(i);
+        region_dmr    &r     = regiones[uint(i)];
+
+        r.pos_inf = linea.split("-")[0].toUInt();
+        r.pos_sup = linea.split("-")[1].split(" ")[0].toUInt();
+        r.ancho   = r.pos_sup - r.pos_inf;
+        r.dwt_ini = linea.split("//")[1].split(" ")[0].toUInt();
+        r.dwt_fin = linea.split("//")[1].split(" ")[1].toUInt();
+    }
+
+    estadisticas.assign(mc.size() * regiones.size(), estadistica_muestra());
+    valores_p.clear();
+    valores_bb.clear();
+}
+
+// ************************************************************************************************
+void Dmr_engine::medir_muestra(uint j, const float *coeficientes, int mh)
+{
+    const Registros_muestra &r = mc[j];
+
+    // los DMRs están ordenados, la búsqueda de la posición inicial sigue desde el DMR anterior
+    uint posicion_muestra = 0;
+    for (uint i = 0; i < regiones.size(); i++)
+    {
+        const region_dmr    &region = regiones[i];
+        estadistica_muestra &e      = estadisticas[j * uint(regiones.size()) + i];
+
+        // busca la posición inical
+        while (posicion_muestra + 1 < r.size() && region.pos_inf > r[posicion_muestra][0])
+            posicion_muestra++;
+
+        e.cobertura_minima = 500000000;
+        e.cobertura_maxima = 0;
+        e.cobertura_media  = 0;
+        e.distancia_minima = 500000000;
+        e.distancia_maxima = 0;
+        e.distancia_media  = 0;
+        e.sites_C          = 0;
+        e.sites_nC         = 0;
+        e.sites_mC         = 0;
+        e.sites_hmC        = 0;
+        e.posiciones       = 0;
+        e.dwt_valor        = 0.0;
+        e.ratio_medio      = 0.0;
+
+        // búsqueda de valores a lo largo del DMR
+        uint posicion = posicion_muestra;
+        while (posicion + 2 < r.size() && region.pos_sup > r[posicion][0])
+        {
+            // cobertura
+            if (e.cobertura_minima >= r[posicion][mh ? 8 : 2])
+                e.cobertura_minima = int(r[posicion][mh ? 8 : 2]);
+            if (e.cobertura_maxima < r[posicion][mh ? 8 : 2])
+                e.cobertura_maxima = int(r[posicion][mh ? 8 : 2]);
+            e.cobertura_media += r[posicion][mh ? 8 : 2];
+            if (r[posicion][mh ? 8 : 2] > 0)
+                e.ratio_medio     += float(r[posicion][mh ? 6 : 5] / r[posicion][mh ? 8 : 2]);
+
+            // distancia
+            if (posicion + 2 < r.size() && region.ancho > r[posicion + 1][0] - r[posicion][0])
+            {
+                if (e.distancia_minima >= r[posicion + 1][0] - r[posicion][0])
+                    e.distancia_minima = int(r[posicion + 1][0] - r[posicion][0]);
+                if (e.distancia_maxima < r[posicion + 1][0] - r[posicion][0])
+                    e.distancia_maxima = int(r[posicion + 1][0] - r[posicion][0]);
+                e.distancia_media += r[posicion + 1][0] - r[posicion][0];
+            }
+
+            // número de posiciones detectadas por tipo de mononucleótico
+            e.sites_C   += (r[posicion][3] > 0) ? 1 : 0;
+            e.sites_nC  += (r[posicion][4] > 0) ? 1 : 0;
+            e.sites_mC  += (r[posicion][5] > 0) ? 1 : 0;
+            e.sites_hmC += (r[posicion][6] > 0) ? 1 : 0;
+
+            // número de posiciones detectadas con algún tipo de nucleótido sensible
+            if (r[posicion][mh ? 8 : 2] > 0)
+                e.posiciones++;
+
+            posicion++;
+        }
+
+        // valor medio dwt en la región identificada
+        for (uint k = region.dwt_ini; k <= region.dwt_fin; k++)
+            e.dwt_valor += coeficientes[k];
+        e.dwt_valor = region.dwt_fin - region.dwt_ini + 1 != 0 ? e.dwt_valor / (region.dwt_fin - region.dwt_ini + 1) : e.dwt_valor;
+    }
+
+    // fuera de memoria las páginas ya recorridas no ocupan RAM
+    r.soltar();
+}
+
+// ************************************************************************************************
+vector<pair<uint, uint>> Dmr_engine::tramos_dmrs() const
+{
+    // los coeficientes del DMR sólo dependen de las posiciones de sus ventanas
+    vector<pair<uint, uint>> tramos;
+    for (const region_dmr &region : regiones)
+        tramos.push_back(make_pair(qMin(region.pos_inf, inicio_coeficiente(region.dwt_ini)),
+                                   qMax(region.pos_sup, fin_coeficiente(region.dwt_fin)) - 1));
+    sort(tramos.begin(), tramos.end());
+
+    vector<pair<uint, uint>> unidos;
+    for (const auto &t : tramos)
+    {
+        if (!unidos.empty() && t.first <= unidos.back().second + 1)
+            unidos.back().second = max(unidos.back().second, t.second);
+        else
+            unidos.push_back(t);
+    }
+
+    return unidos;
+}
+
+// ************************************************************************************************
+void Dmr_engine::permutar_etiquetas(int mh)
+{
+    size_t n = h_haar_C.size();
+
+    // etiquetas de grupo 1 de cada permutación, una fila por muestra y una columna por permutación:
+    // la columna 0 son las del trabajo y el resto, permutaciones suyas
+    // ..la semilla fija hace repetibles los p-valores de una ejecución a otra
+    size_t        permutaciones = size_t(config.permutaciones) + 1;
+    vector<float> etiquetas(n * permutaciones);
+    vector<float> permutada(n);
+    for (size_t i = 0; i < n; i++)
+        permutada[i] = grupo_muestra[i] == 1 ? 1.0f : 0.0f;
+
+    mt19937 generador(uint(cromosoma) * 2 + uint(mh));
+    for (size_t p = 0; p < permutaciones; p++)
+    {
+        if (p > 0)
+            shuffle(permutada.begin(), permutada.end(), generador);
+        for (size_t i = 0; i < n; i++)
+            etiquetas[i * permutaciones + p] = permutada[i];
+    }
+
+    vector<vector<uint>> densas(n);
+    en_paralelo(n, [&](size_t i) { ventanas_densas(uint(i), densas[i]); });
+
+    // mismos mínimos de muestras con cobertura por grupo que find_dmrs, al menos una
+    float min_1 = qMax(float(uint(config.lista_casos.length()   * (config.min_samples_x_region * 0.01))), 1.0f);
+    float min_0 = qMax(float(uint(config.lista_control.length() * (config.min_samples_x_region * 0.01))), 1.0f);
+
+    valores_p.assign(regiones.size(), 1.0f);
+    en_paralelo(regiones.size(), [&](size_t d) {
+        uint   ini   = regiones[d].dwt_ini;
+        size_t ancho = regiones[d].dwt_fin - ini + 1;
+
+        // ventanas del DMR traspuestas, una fila por ventana y una columna por muestra, con ceros en
+        // las ventanas que una muestra no llega a sumar, y totales de cada ventana
+        vector<float> coeficientes(ancho * n, 0.0f);
+        vector<float> marcas(ancho * n, 0.0f);
+        vector<float> suma_total(ancho, 0.0f);
+        vector<float> cuenta_total(ancho, 0.0f);
+        for (size_t i = 0; i < n; i++)
+        {
+            const vector<uint> &v = densas[i];
+            for (auto m = lower_bound(v.begin(), v.end(), ini); m != v.end() && *m - ini < ancho; ++m)
+            {
+                coeficientes[(*m - ini) * n + i] = h_haar_C[i][*m];
+                marcas[(*m - ini) * n + i]       = 1.0f;
+                suma_total[*m - ini]            += h_haar_C[i][*m];
+                cuenta_total[*m - ini]          += 1.0f;
+            }
+        }
+
+        float  suma_1[PERMUTACIONES_POR_LOTE];
+        float  cuenta_1[PERMUTACIONES_POR_LOTE];
+        float  estadistico[PERMUTACIONES_POR_LOTE];
+        float  observado = 0.0f;
+        int    excesos   = 0;
+        size_t hechas    = 0;
+        for (size_t p0 = 0; p0 < permutaciones && excesos < EXCESOS_PARADA; p0 += PERMUTACIONES_POR_LOTE)
+        {
+            size_t lote = qMin(PERMUTACIONES_POR_LOTE, permutaciones - p0);
+            fill(estadistico, estadistico + lote, 0.0f);
+
+            for (size_t w = 0; w < ancho; w++)
+            {
+                // suma y cuenta del grupo 1 de cada permutación del lote; el grupo 0 es el resto
+                fill(suma_1, suma_1 + lote, 0.0f);
+                fill(cuenta_1, cuenta_1 + lote, 0.0f);
+                for (size_t i = 0; i < n; i++)
+                {
+                    if (marcas[w * n + i] == 0.0f)
+                        continue;
+
+                    float        x = coeficientes[w * n + i];
+                    const float *e = etiquetas.data() + i * permutaciones + p0;
+                    #pragma omp simd
+                    for (size_t j = 0; j < lote; j++)
+                    {
+                        suma_1[j]   += x * e[j];
+                        cuenta_1[j] += e[j];
+                    }
+                }
+
+                float total    = suma_total[w];
+                float muestras = cuenta_total[w];
+                #pragma omp simd
+                for (size_t j = 0; j < lote; j++)
+                {
+                    float cuenta_0 = muestras - cuenta_1[j];
+                    float media_1  = suma_1[j] / max(cuenta_1[j], 1.0f);
+                    float media_0  = (total - suma_1[j]) / max(cuenta_0, 1.0f);
+                    estadistico[j] += (cuenta_1[j] >= min_1 && cuenta_0 >= min_0) ? media_1 - media_0 : 0.0f;
+                }
+            }
+
+            for (size_t j = 0; j < lote; j++)
+            {
+                float t = fabs(estadistico[j]) / ancho;
+                if (p0 + j == 0)
+                {
+                    observado = t;
+                    continue;
+                }
+
+                hechas++;
+                if (t >= observado * (1.0f - 1e-6f))
+                    excesos++;
+            }
+        }
+
+        // con parada temprana el p-valor es la proporción de excesos en las permutaciones hechas
+        valores_p[d] = excesos >= EXCESOS_PARADA ? float(excesos) / hechas : float(excesos + 1) / (hechas + 1);
+    });
+}
+
+// ************************************************************************************************
+void Dmr_engine::sumar_sitios(const Registros_muestra &r, uint j, int mh, vector<vector<sitio_dmr>> &sitios) const
+{
+    double cobertura = mh == 0 ? config.mc_min_coverage : config.hmc_min_coverage;
+    int    grupo     = grupo_muestra[j];
+
+    // cada DMR recibe las posiciones de la muestra entre sus extremos, buscando la primera en los
+    // registros ordenados por posición
+    en_paralelo(regiones.size(), [&](size_t i) {
+        const region_dmr &region = regiones[i];
+
+        size_t desde = 0;
+        size_t hasta = r.size();
+        while (desde < hasta)
+        {
+            size_t mitad = (desde + hasta) / 2;
+            if (r[mitad][0] < region.pos_inf)
+                desde = mitad + 1;
+            else
+                hasta = mitad;
+        }
+
+        for (size_t k = desde; k < r.size() && r[k][0] < region.pos_sup; k++)
+            if (r[k][mh == 0 ? 2 : 8] >= cobertura)
+                sitios[i].push_back({uint(r[k][0]), grupo, float(r[k][mh == 0 ? 1 : 7]),
+                                     float(r[k][mh == 0 ? 5 : 6]), float(r[k][mh == 0 ? 2 : 8])});
+    });
+}
+
+// ************************************************************************************************
+void Dmr_engine::refinar_dmrs(int mh)
+{
+    vector<vector<sitio_dmr>> sitios(regiones.size());
+
+    // en el modo por muestra las filas de mc están vacías y cada muestra se lee para recorrerla
+    for (uint j = 0; j < mc.size() && !aborted; j++)
+    {
+        Registros_muestra        leida = por_muestra ? leer_muestra(j) : Registros_muestra();
+        const Registros_muestra &r     = por_muestra ? leida : mc[j];
+
+        sumar_sitios(r, j, mh, sitios);
+        r.soltar();
+    }
+
+    if (aborted)
+        return;
+
+    // mismos mínimos de muestras con cobertura por grupo que las ventanas, al menos una por grupo
+    uint min_casos     = qMax(uint(config.lista_casos.length()   * (config.min_samples_x_region * 0.01)), 1u);
+    uint min_controles = qMax(uint(config.lista_control.length() * (config.min_samples_x_region * 0.01)), 1u);
+
+    en_paralelo(regiones.size(), [&](size_t i) {
+        region_dmr        &region = regiones[i];
+        vector<sitio_dmr> &s      = sitios[i];
+        float              signo  = dmr_diff[region.dwt_ini] < 0 ? -1.0f : 1.0f;
+
+        sort(s.begin(), s.end(), [](const sitio_dmr &a, const sitio_dmr &b) { return a.posicion < b.posicion; });
+
+        // diferencia de medias por posición con la misma convención que find_dmrs
+        bool hallada = false;
+        uint primera = 0;
+        uint ultima  = 0;
+        for (size_t k = 0; k < s.size();)
+        {
+            float suma[2]   = {0.0f, 0.0f};
+            uint  cuenta[2] = {0, 0};
+            size_t fin = k;
+            for (; fin < s.size() && s[fin].posicion == s[k].posicion; fin++)
+            {
+                suma[s[fin].grupo == 0 ? 0 : 1] += s[fin].ratio;
+                cuenta[s[fin].grupo == 0 ? 0 : 1]++;
+            }
+
+            if (cuenta[1] >= min_casos && cuenta[0] >= min_controles &&
+                signo * (suma[1] / cuenta[1] - suma[0] / cuenta[0]) > _threshold)
+            {
+                if (!hallada)
+                    primera = s[k].posicion;
+                hallada = true;
+                ultima  = s[k].posicion;
+            }
+            k = fin;
+        }
+
+        vector<sitio_dmr>().swap(s);
+        if (!hallada)
+            return;
+
+        region.pos_inf = primera;
+        region.pos_sup = ultima + 1;
+        region.ancho   = region.pos_sup - region.pos_inf;
+    });
+
+    // las líneas de los DMRs llevan los extremos nuevos
+    for (int i = 0; i < dmrs.size(); i++)
+    {
+        const region_dmr &region = regiones[uint(i)];
+        dmrs[i] = QString::number(region.pos_inf) + "-" + QString::number(region.pos_sup) +
+                  dmrs.at(i).mid(dmrs.at(i).indexOf(' '));
+    }
+}
+
+// ************************************************************************************************
+void Dmr_engine::probar_beta_binomial(int mh)
+{
+    vector<vector<sitio_dmr>> sitios(regiones.size());
+
+    // en el modo por muestra las filas de mc están vacías y cada muestra se lee para recorrerla
+    for (uint j = 0; j < mc.size() && !aborted; j++)
+    {
+        Registros_muestra        leida = por_muestra ? leer_muestra(j) : Registros_muestra();
+        const Registros_muestra &r     = por_muestra ? leida : mc[j];
+
+        sumar_sitios(r, j, mh, sitios);
+        r.soltar();
+    }
+
+    if (aborted)
+        return;
+
+    // mismos mínimos de muestras con cobertura por grupo que refinar_dmrs
+    uint min_casos     = qMax(uint(config.lista_casos.length()   * (config.min_samples_x_region * 0.01)), 1u);
+    uint min_controles = qMax(uint(config.lista_control.length() * (config.min_samples_x_region * 0.01)), 1u);
+
+    valores_bb.assign(regiones.size(), 1.0);
+    en_paralelo(regiones.size(), [&](size_t i) {
+        vector<sitio_dmr> &s = sitios[i];
+        sort(s.begin(), s.end(), [](const sitio_dmr &a, const sitio_dmr &b) { return a.posicion < b.posicion; });
+
+        // observaciones de las posiciones con los mínimos de muestras, un array por campo
+        vector<double> k;
+        vector<double> n;
+        vector<double> g;
+        for (size_t p = 0; p < s.size();)
+        {
+            uint   cuenta[2] = {0, 0};
+            size_t fin = p;
+            for (; fin < s.size() && s[fin].posicion == s[p].posicion; fin++)
+                cuenta[s[fin].grupo == 0 ? 0 : 1]++;
+
+            for (; cuenta[1] >= min_casos && cuenta[0] >= min_controles && p < fin; p++)
+            {
+                k.push_back(s[p].metilados);
+                n.push_back(s[p].cobertura);
+                g.push_back(s[p].grupo == 0 ? 0.0 : 1.0);
+            }
+            p = fin;
+        }
+
+        vector<sitio_dmr>().swap(s);
+        size_t        observaciones = k.size();
+        const double *pk            = k.data();
+        const double *pn            = n.data();
+        const double *pg            = g.data();
+
+        // proporción de reads con la señal de cada grupo y de los dos juntos
+        double suma_k[2] = {0.0, 0.0};
+        double suma_n[2] = {0.0, 0.0};
+        double cuenta[2] = {0.0, 0.0};
+        for (size_t o = 0; o < observaciones; o++)
+        {
+            int x = g[o] == 0.0 ? 0 : 1;
+            suma_k[x] += k[o];
+            suma_n[x] += n[o];
+            cuenta[x] += 1.0;
+        }
+        if (suma_n[0] <= 0.0 || suma_n[1] <= 0.0)
+            return;
+
+        double media[2] = {qBound(1e-6, suma_k[0] / suma_n[0], 1.0 - 1e-6),
+                           qBound(1e-6, suma_k[1] / suma_n[1], 1.0 - 1e-6)};
+        double comun    = qBound(1e-6, (suma_k[0] + suma_k[1]) / (suma_n[0] + suma_n[1]), 1.0 - 1e-6);
+
+        // correlación entre reads de una observación por momentos: con la varianza beta-binomial,
+        // n (k / n - media)^2 / (media (1 - media)) tiene esperanza 1 + (n - 1) rho
+        double residuo = 0.0;
+        double exceso  = 0.0;
+        #pragma omp simd reduction(+:residuo, exceso)
+        for (size_t o = 0; o < observaciones; o++)
+        {
+            double mu = pg[o] == 0.0 ? media[0] : media[1];
+            double d  = pk[o] / pn[o] - mu;
+            residuo  += pn[o] * d * d / (mu * (1.0 - mu));
+            exceso   += pn[o] - 1.0;
+        }
+        double rho = exceso > 0.0 ? qBound(1e-4, (residuo - (observaciones - 2.0)) / exceso, 0.9) : 1e-4;
+
+        // parámetros beta de cada grupo y comunes, con la misma precisión
+        double precision  = (1.0 - rho) / rho;
+        double a[2]       = {media[0] * precision, media[1] * precision};
+        double b[2]       = {(1.0 - media[0]) * precision, (1.0 - media[1]) * precision};
+        double a_comun    = comun * precision;
+        double b_comun    = (1.0 - comun) * precision;
+
+        // diferencia de log-verosimilitudes sin los términos iguales en los dos modelos: el
+        // coeficiente binomial y lgamma(n + precisión)
+        double diferencia = 0.0;
+        #pragma omp simd reduction(+:diferencia)
+        for (size_t o = 0; o < observaciones; o++)
+        {
+            double a_g = pg[o] == 0.0 ? a[0] : a[1];
+            double b_g = pg[o] == 0.0 ? b[0] : b[1];
+            diferencia += log_gamma(pk[o] + a_g) + log_gamma(pn[o] - pk[o] + b_g) -
+                          log_gamma(pk[o] + a_comun) - log_gamma(pn[o] - pk[o] + b_comun);
+        }
+        for (int x = 0; x < 2; x++)
+            diferencia += cuenta[x] * (lgamma(a_comun) + lgamma(b_comun) - lgamma(a[x]) - lgamma(b[x]));
+
+        // razón de verosimilitudes frente a una chi-cuadrado de 1 grado de libertad
+        double estadistico = qMax(2.0 * diferencia, 0.0);
+        valores_bb[i]      = erfc(sqrt(estadistico / 2.0));
+    });
+}
+
+// ************************************************************************************************
+void Dmr_engine::save_dmr_list(int mh)
+{
+    // prepara nombre de fichero y directorio para guardar la lista de dmrs
+    // ..los resultados de cada cromosoma se guardan aparte y se fusionan al terminar la ejecución
+    QString ruta = config.ruta_shard;
+    fichero = ruta + "/" + nombre_csv(config, cromosoma, mh);
+
+    QFile data;
+    data.setFileName(fichero);
+
+    // prepara nombre de fichero para guardar los datos con formato GFF
+    fichero_gff = ruta + "/" + nombre_gff(config, mh);
+
+    QFile data_gff;
+    data_gff.setFileName(fichero_gff);
+    bool gff_open;
+
+
+    // comprueba que el fichero se ha abierto correctamente
+    if (!data.open(QIODevice::WriteOnly))
+    {
+        emit error("An error occurred opening the file: " + fichero +
+                   "\nPlease, check the file for corrupted");
+        qDebug() << "ERROR opening file: " << fichero;
+        return;
+    }
+    else
+    {
+        QTextStream s(&data);
+        if (dmrs.size() > 0)
+        {
+            uint pos_inf;
+            uint pos_sup;
+
+            // comprueba que el fichero para guardar información en formato GFF se abre correctamente
+            if (!data_gff.open(QIODevice::WriteOnly | QIODevice::Append))
+            {
+                gff_open = false;
+                qDebug() << "ERROR al abrir el fichero con formato GFF";
+            }
+            else
+                gff_open = true;
+
+            // encabezado de la información del dmr
+            switch (config.genome_reference)
+            {
+            case 0:
+                s << "pos_init-pos_end methylation dwt_diff";
+                break;
+            case 1:
+                s << "pos_init-pos_end name_1 name_2 distance methylation dwt_diff";
+                break;
+            }
+            s << (valores_bb.empty() ? "" : " bb_p_value") << (valores_p.empty() ? "\n" : " p_value\n");
+
+            qDebug() << "guardando datos en ficheros";
+
+            // añade una línea por dmr detectaado y línea de características por muestra en cada dmr
+            for (int i = 0; i < dmrs.size(); i++)
+            {
+//                qDebug() << "empieza escritura en fichero dmr" << i;
+                // información del dmr para obtener las características de cada muestra
+                pos_inf   = regiones[uint(i)].pos_inf;
+                pos_sup   = regiones[uint(i)].pos_sup;
+
+                //**************************************************************************************************************
+                // escribe información del DMR en el fichero GFF
+                if (gff_open)
+                {
+                    QString registro_gff;
+                    QTextStream gff(&registro_gff);
+
+                    // columna 1 y 2 (sequence , source)
+                //    gff << "chr" << (mc[0][0][9] < 10 ? "0" : "") << QString::number(int(mc[0][0][9])) << "\t" << "HPG-Dhunter\t";
+                    gff << Contigs::secuencia(cromosoma) << "\t" << "HPG-Dhunter\t";
+
+                    region_gff++;
+
+                    // columna 3 (feature)
+                    switch (config.genome_reference)
+                    {
+                    case 0:
+                        gff << dmrs.at(i).split(" ")[1] << "\t";
+                        break;
+                    case 1:
+                        gff << dmrs.at(i).split(" ")[4] << "\t";
+                        break;
+                    }
+
+                    // columna 4 y 5 (start , end)
+                    gff << QString::number(pos_inf) << "\t" <<
+                           QString::number(pos_sup) << "\t";
+
+                    // columna 6 (score)
+                    switch (config.genome_reference)
+                    {
+                    case 0:
+                        gff << dmrs.at(i).split("//")[0].split(" ")[2] << "\t";
+                        break;
+                    case 1:
+                        gff << dmrs.at(i).split("//")[0].split(" ")[5] << "\t";
+                        break;
+                    }
+
+                    // columna 7 y 8 (strand , phase)
+                    gff << ".\t" << ".\t";
+
+                    // columna 9 (#samples coverage threshold dwt_level)
+                    switch (config.genome_reference)
+                    {
+                    case 0:
+                        gff << "Note=DMR_Region:" << QString::number(region_gff) << ",";
+                        break;
+                    case 1:
+                        gff << "Name=" << dmrs.at(i).split("//")[0].split(" ")[2] << ";" <<
+                               "Note=Distance:" << dmrs.at(i).split("//")[0].split(" ")[3] << ",";
+                        break;
+                    }
+                    gff << "Samples:" << QString::number(mc.size()) << "," <<
+                           "Coverage:" << QString::number(mh ? config.hmc_min_coverage : config.mc_min_coverage) << "," <<
+                           "Threshold:" << QString::number(double(_threshold), 'f', 2) << "," <<
+                           "DWT_level:" << QString::number(config.dmr_dwt_level) << "," <<
+                           "Density:" << QString::number(config.min_cpg_x_region) << "%,"
+                           "Samples/region w/cov:" << QString::number(config.min_samples_x_region) << "%";
+
+                    // p-valor de la prueba beta-binomial
+                    if (!valores_bb.empty())
+                        gff << ";Beta_binomial_P=" << QString::number(valores_bb[uint(i)], 'g', 4);
+
+                    // p-valor empírico, el FDR se añade al fusionar con los de todos los cromosomas
+                    if (!valores_p.empty())
+                        gff << ";P_value=" << QString::number(double(valores_p[uint(i)]), 'g', 4);
+                    gff << "\n";
+                    gff.flush();
+
+                    // la copia BGZF indexada con tabix se genera al fusionar los cromosomas
+                    QTextStream(&data_gff) << registro_gff;
+                }
+
+
+
+                //**************************************************************************************************************
+
+                // escribe zona dmr detectada en fichero particular
+                s << dmrs.at(i).split("//")[0];
+                if (!valores_bb.empty())
+                    s << " " << QString::number(valores_bb[uint(i)], 'g', 4);
+                if (!valores_p.empty())
+                    s << " " << QString::number(double(valores_p[uint(i)]), 'g', 4);
+                s << '\n';
+
+                // encabezado de las características por fichero dentro de la zona dmr
+                s << " sample dwt_value ratio C_positions cov_min cov_mid cov_max sites_Cnm sites_Cnh sites_mC sites_hmC dist_min dist_mid dist_max\n";
+
+                // rellena el fichero
+                // guarda información de cada muestra de la zona dmr detectada, casos y después controles
+                //***************************************************************************************
+                // ..con una hoja de muestras, grupo a grupo
+                int minimo = mh ? config.hmc_min_coverage : config.mc_min_coverage;
+                for (int grupo = 0; grupo < numero_grupos(); grupo++)
+                {
+                    for (uint j = 0; j < uint(mc.size()); j++)
+                    {
+                        if (grupo_muestra[j] != grupo)
+                            continue;
+
+                        s << " " << (grupo == 1 && config.grupos.isEmpty() ? config.lista_control : config.lista_casos).at(orden_muestra[j]).split("/").back() << " ";
+                        escribir_estadistica(s, estadisticas[j * uint(regiones.size()) + uint(i)], minimo);
+                    }
+                }
+
+                s << "\n";
+                //qDebug() << "fin escritura en fichero dmr: " << i;
+            }
+        }
+        else
+            s << "no DMRs were found\n";
+
+        data.close();
+        data_gff.close();
+        qDebug() << "cerrando ficheros";
+    }
+
+
+    qDebug() << fichero;
+}
+
+// ************************************************************************************************
+void Dmr_engine::escribir_estadistica(QTextStream &s, const estadistica_muestra &e, int minimo)
+{
+    // carga de resultado en línea de texto para mostrar
+    //if ((posiciones > 1 ? cobertura_media / posiciones : cobertura_media) >= minimo)
+    if (e.cobertura_maxima >= minimo)
+    {
+        s << QString("%1").arg(double(e.dwt_valor)) << " " <<
+             QString("%1").arg(e.posiciones > 1 ? double(e.ratio_medio / e.posiciones) : double(e.ratio_medio)) << " " <<
+             QString::number(e.posiciones) << " " <<
+             QString::number(e.cobertura_minima >= 500000000 ? 0 : e.cobertura_minima) << " " <<
+             QString::number((e.posiciones > 1) ? e.cobertura_media / e.posiciones : e.cobertura_media) << " " <<
+             QString::number(e.cobertura_maxima) << " " <<
+             QString::number(e.sites_C) << " " <<
+             QString::number(e.sites_nC) << " " <<
+             QString::number(e.sites_mC) << " " <<
+             QString::number(e.sites_hmC) << " " <<
+             QString::number(e.distancia_minima >= 500000000 ? 0 : e.distancia_minima) << " " <<
+             QString::number((e.posiciones > 1) ? e.distancia_media / e.posiciones : e.distancia_media) << " " <<
+             QString::number(e.distancia_maxima) << "\n";
+    }
+    else
+    {
+        s << QString("%1").arg(double(e.dwt_valor)) << " " <<
+             QString("%1").arg(e.posiciones > 1 ? double(e.ratio_medio / e.posiciones) : double(e.ratio_medio)) << " " <<
+             "0 0 0 0 0 0 0 0 0 0 0\n";
+    }
+}
@@ -0,0 +1,943 @@
+/*
+*  Dmr_engine is the GUI independent DMR identification pipeline
+*  Copyright (C) 2018 Lisardo Fernández Cordeiro <lisardo.fernandez@uv.es>
+*
+*  This program is free software; you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation; either version 3, or (at your option)
+*  any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*  or see <https://www.gnu.org/licenses/>.
+*
+*/
+
+/** \file
+*  \brief Motor de identificación de DMRs sin dependencias de la interfaz gráfica.
+*
+*  Este archivo contiene la definición de las funciones para:
+*         ..lectura de los ficheros de cada cromosoma de todas las muestras
+*         ..reparto de muestras leídas y transformadas entre varios trabajos
+*         ..transformación wavelet en GPU
+*         ..identificación de DMRs y guardado de resultados en csv, gff y gff.gz
+*  Lo utilizan tanto la interfaz gráfica como el ejecutable de línea de comandos.
+*/
+
+#ifndef DMR_ENGINE_H
+#define DMR_ENGINE_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QStringList>
+#include <QVector>
+#include <QMap>
+#include <vector>
+#include "arena.h"
+#include "data_pack.h"
+#include "dmr_config.h"
+#include "files_worker.h"
+#include "refgen.h"
+#include "regiones_objetivo.h"
+#include "registros_muestra.h"
+#include "vista_matriz.h"
+
+
+using namespace std;
+
+class QTextStream;
+
+
+/** ***********************************************************************************************
+  *  \brief declaración de funciones externas para compilación con nvcc
+  *  \fn    void cuda_send_data(datos_cuda &)
+  *  \fn    void cuda_main(datos_cuda &)
+  *         ..cuda_main deja los coeficientes en las filas cuda_data.h_haar_C, que reserva quien la llama
+  * ***********************************************************************************************
+  */
+//extern
+void cuda_send_data(datos_cuda &);
+//extern
+void cuda_main(datos_cuda &);
+//extern
+void cuda_calculo_haar_L(datos_cuda &);
+//extern
+void cuda_init();
+//extern
+void cuda_end(datos_cuda &);
+
+
+class Dmr_engine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Dmr_engine(QObject *parent = nullptr);
+    ~Dmr_engine();
+
+    /** ***********************************************************************************************
+      * \fn void solicitud_proceso(const dmr_config &)
+      *  \brief Guarda la configuración del análisis y solicita que se lance el proceso
+      *  \param &configx    parámetros del análisis
+      * ***********************************************************************************************
+      */
+    void solicitud_proceso(const dmr_config &configx);
+
+    /** ***********************************************************************************************
+      * \fn void solicitud_proceso(const QList<dmr_config> &, int)
+      *  \brief Guarda varios trabajos que se procesan juntos y solicita que se lance el proceso
+      *         cada muestra de un cromosoma se lee y se transforma una sola vez para todos los
+      *         trabajos que la comparten
+      *  \param &trabajosx     parámetros de cada análisis
+      *  \param memoria_mbx    límite de memoria en MiB para las muestras compartidas (0 sin límite)
+      * ***********************************************************************************************
+      */
+    void solicitud_proceso(const QList<dmr_config> &trabajosx, int memoria_mbx = 0);
+
+    /** ***********************************************************************************************
+      * \fn void modo_por_muestra(bool)
+      *  \brief Activa el modo por muestra: cada muestra se lee, se transforma y se suma a las medias
+      *         de su grupo antes de leer la siguiente, de forma que la memoria depende del número de
+      *         ventanas del cromosoma y no del número de muestras. Las muestras se leen dos veces, la
+      *         segunda para las estadísticas de cada muestra en los DMRs hallados, y no se comparten
+      *         entre trabajos
+      * ***********************************************************************************************
+      */
+    void modo_por_muestra(bool activo);
+
+    /** ***********************************************************************************************
+      * \fn void abort()
+      *  \brief Solicita que el proceso se detenga tras la tarea en curso
+      * ***********************************************************************************************
+      */
+    void abort();
+
+    /** ***********************************************************************************************
+      * \fn static int memoria_gpu_disponible()
+      *  \brief Memoria libre en la tarjeta gráfica en MiB según la información de "nvidia-smi"
+      * ***********************************************************************************************
+      */
+    static int memoria_gpu_disponible();
+
+    /** ***********************************************************************************************
+      * \fn static QList<int> lista_cromosomas(const QString &)
+      *  \brief Filtra un texto con cromosomas eliminando duplicados: números 1..24 (con o sin chr)
+      *         o nombres de contig, que se registran en Contigs
+      *  \param texto   lista de cromosomas separados por espacios o comas
+      * ***********************************************************************************************
+      */
+    static QList<int> lista_cromosomas(const QString &texto);
+
+    /** ***********************************************************************************************
+      * \fn static QString nombre_csv(const dmr_config &, int, int) and one more
+      *  \brief Nombres de los ficheros de resultados csv (por cromosoma) y gff (por ejecución)
+      *  \param configx     parámetros del análisis
+      *  \param chrom       cromosoma analizado
+      *  \param mh          señal analizada: 0 mC, 1 hmC
+      * ***********************************************************************************************
+      */
+    static QString nombre_csv(const dmr_config &configx, int chrom, int mh);
+    static QString nombre_gff(const dmr_config &configx, int mh);
+
+    /** ***********************************************************************************************
+      * \fn static QString nombre_pares(const dmr_config &, int) and one more
+      *  \brief Nombres de los ficheros de la comparación muestra a muestra: matriz con el número de
+      *         DMRs de cada par (por ejecución) y DMRs de cada par (por cromosoma)
+      * ***********************************************************************************************
+      */
+    static QString nombre_pares(const dmr_config &configx, int mh);
+    static QString nombre_lista_pares(const dmr_config &configx, int chrom, int mh);
+
+    /** ***********************************************************************************************
+      * \fn static QList<int> orden_cromosomas(const QList<dmr_config> &)
+      *  \brief Cromosomas de todos los trabajos en el orden en que aparecen, que es el de los
+      *         resultados fusionados; el orden de proceso lo decide Planificador::orden
+      * ***********************************************************************************************
+      */
+    static QList<int> orden_cromosomas(const QList<dmr_config> &trabajosx);
+
+    /** ***********************************************************************************************
+      * \fn int maximo_progreso() const
+      *  \brief Número total de pasos del proceso: ficheros leídos y señales analizadas por cromosoma
+      *         sumados para todos los trabajos
+      * ***********************************************************************************************
+      */
+    int maximo_progreso() const;
+
+signals:
+    /** ***********************************************************************************************
+      * \fn void proceso_solicitado()
+      *  \brief Esta señal se emite cuando se le solicita al motor que se active
+      * ***********************************************************************************************
+      */
+    void proceso_solicitado();
+
+    /** ***********************************************************************************************
+      * \fn void progreso(int, int)
+      *  \brief Esta señal se emite cada vez que se lee un fichero o se analiza una señal
+      *  \param valor   pasos completados
+      *  \param maximo  pasos totales del proceso
+      * ***********************************************************************************************
+      */
+    void progreso(int valor, int maximo);
+
+    /** ***********************************************************************************************
+      * \fn void mensaje(QString)
+      *  \brief Esta señal informa del estado del proceso
+      * ***********************************************************************************************
+      */
+    void mensaje(QString texto);
+
+    /** ***********************************************************************************************
+      * \fn void error(QString)
+      *  \brief Esta señal informa de un error que no detiene el proceso completo
+      * ***********************************************************************************************
+      */
+    void error(QString texto);
+
+    /** ***********************************************************************************************
+      * \fn void terminado(bool)
+      *  \brief Esta señal se emite al acabar el proceso
+      *  \param completo    false si el proceso ha sido abortado
+      * ***********************************************************************************************
+      */
+    void terminado(bool completo);
+
+    /** ***********************************************************************************************
+      * \fn void finished()
+      *  \brief Esta señal se emite cuando el proceso termina o se aborta, para liberar el hilo
+      * ***********************************************************************************************
+      */
+    void finished();
+
+public slots:
+    /** ***********************************************************************************************
+      * \fn void proceso()
+      *  \brief Ejecuta el análisis completo de todos los cromosomas de la configuración
+      * ***********************************************************************************************
+      */
+    void proceso();
+
+private slots:
+    /** ***********************************************************************************************
+      * \fn void refGen_worker_acabado(ulong)
+      *  \brief Función responsable de recibir el número de genes definidos para un cromosoma dato
+      *  \param ref_genes   número de genes
+      * ***********************************************************************************************
+      */
+    void refGen_worker_acabado(ulong);
+
+private:
+    /** ***********************************************************************************************
+      *  \brief muestra leída de un cromosoma, compartida por los trabajos que la utilizan
+      *  \param datos       registros del cromosoma con el formato de mc
+      *  \param inicio      posición menor de la muestra
+      *  \param final       posición mayor de la muestra
+      * ***********************************************************************************************
+      */
+    struct muestra_leida
+    {
+        Registros_muestra datos;
+        uint inicio;
+        uint final;
+    };
+
+    /** ***********************************************************************************************
+      *  \brief transformada de una muestra para una señal, cobertura, nivel y ventana del cromosoma
+      *  \param coeficientes        copia de la fila de h_haar_C
+      *  \param posiciones          fila de posicion_metilada
+      * ***********************************************************************************************
+      */
+    struct muestra_transformada
+    {
+        vector<float> coeficientes;
+        vector<uint>  posiciones;
+    };
+
+    /** ***********************************************************************************************
+      *  \brief suma y cuenta por ventana de un grupo de muestras, como en suma_grupo y cuenta_grupo
+      * ***********************************************************************************************
+      */
+    struct suma_guardada
+    {
+        vector<float> suma;
+        vector<uint>  cuenta;
+    };
+
+    /** ***********************************************************************************************
+      *  \brief variables para compartir datos entre trabajos
+      *  \param trabajos        trabajos del proceso, en el orden de la solicitud
+      *  \param muestras        muestras leídas del cromosoma en curso por clave de muestra
+      *  \param transformadas   transformadas del cromosoma en curso por clave de transformada
+      *  \param sumas           sumas por grupo del cromosoma en curso de los trabajos de una hoja de
+      *                         muestras, por las claves de transformada de las muestras del grupo
+      *  \param claves_transformada clave de transformada de cada fila de h_haar_C
+      *  \param usos            posiciones en la lista de trabajos del cromosoma que usan cada muestra
+      *  \param claves_mc       clave de la muestra colocada en cada fila de mc
+      *  \param trabajo_cromosoma   posición del trabajo en curso en la lista de trabajos del cromosoma
+      *  \param memoria_cache   bytes ocupados por muestras, transformadas y sumas guardadas
+      *  \param memoria_maxima  límite de bytes para muestras, transformadas y sumas guardadas (0 sin
+      *                         límite)
+      * ***********************************************************************************************
+      */
+    QList<dmr_config>                   trabajos;
+    QMap<QString, muestra_leida>        muestras;
+    QMap<QString, muestra_transformada> transformadas;
+    QMap<QString, suma_guardada>        sumas;
+    QStringList                         claves_transformada;
+    QMap<QString, QList<int>>           usos;
+    QStringList                         claves_mc;
+    int                                 trabajo_cromosoma;
+    qint64                              memoria_cache;
+    qint64                              memoria_maxima;
+
+    /** ***********************************************************************************************
+      *  \brief parámetros del análisis en curso
+      *  \param config      configuración del trabajo en curso
+      *  \param aborted     señal de control de proceso activo
+      *  \param parametros  listado de los parámetros con los que realizar la lectura de ficheros
+      *  \param _threshold  valor de umbral para identificación de DMRs
+      * ***********************************************************************************************
+      */
+    dmr_config  config;
+    bool        aborted;
+    QStringList parametros;
+    float       _threshold;
+
+    /** ***********************************************************************************************
+      *  \brief variable de tipo estructura con variables para control de datos a analizar
+      *  \param cuda_data   estrutura con variables de control y datos
+      * ***********************************************************************************************
+      */
+    datos_cuda cuda_data;
+
+    /** ***********************************************************************************************
+      *  \brief variables responsables de los ficheros de resultados
+      *  \param fichero             string con nombre del fichero csv en curso
+      *  \param fichero_gff         string con nombre de fichero en formato gff
+      *  \param region_gff          contador de DMRs del trabajo y cromosoma en curso para numerar en
+      *                             fichero gff, la fusión de los cromosomas lo convierte en correlativo
+      * ***********************************************************************************************
+      */
+    QString      fichero;
+    QString      fichero_gff;
+    uint         region_gff;
+
+    /** ***********************************************************************************************
+      *  \brief variables para control de datos de cromosoma y hardware
+      *  \param memory_available    cantidad de memoria GPU disponible en el PC para controlar capacidad
+      *  \param contador            pasos completados del proceso
+      * ***********************************************************************************************
+      */
+    int memory_available;
+    int contador;
+
+    /** ***********************************************************************************************
+      *  \brief variables para control de posiciones extremas de fichero a analizar
+      *  \param limite_inferior posición menor metilada en fichero de datos
+      *  \param limite_superior posición mayor metilada en fichero de datos
+      * ***********************************************************************************************
+      */
+    uint limite_inferior;
+    uint limite_superior;
+
+    /** ***********************************************************************************************
+      *  \brief memoria de las matrices contiguas y de las diferencias, reutilizada por todos los
+      *         cromosomas y señales de la ejecución
+      *  \param arena       búferes que sólo crecen hasta el tamaño del cromosoma más largo
+      * ***********************************************************************************************
+      */
+    Arena arena;
+
+    /** ***********************************************************************************************
+      *  \brief variables para búsqueda y muestra de DMRs
+      *  \param **dmr_diff      datos de diferencias, en la memoria de arena
+      *  \param dmr_diff_cols   número de valores por vector con los que buscar DMRs por columna
+      *  \param num_genes       número de genes conocidos en el cromosoma analizado
+      *  \param dmrs            lista de todas las posiciones DMRs encontradas
+      * ***********************************************************************************************
+      */
+    float       *dmr_diff;
+    uint        dmr_diff_cols;
+    ulong       num_genes;
+    QStringList dmrs;
+
+    /** ***********************************************************************************************
+      *  \brief variables para control de datos por muestras y resultados de transformación en GPU
+      *  \param mc          registros con datos de metilación, cobertura y conteo por muestra y posición
+      *  \param grupo_muestra       grupo de cada fila de mc en el trabajo: caso (0) / control (1),
+      *                             o su grupo en config.grupos
+      *  \param orden_muestra       posición de cada fila de mc en la lista de su grupo
+      *  \param h_haar_C    vista de la matriz contigua de arena en la que la GPU deja los resultados
+      *                     de la transformación wavelet, una fila por muestra
+      *  \param posicion_metilada   acumulación de posiciones metiladas para validar DMR
+      * ***********************************************************************************************
+      */
+    vector<Registros_muestra>     mc;
+    vector<int>                   grupo_muestra;
+    vector<int>                   orden_muestra;
+    Vista_matriz                  h_haar_C;
+    vector<vector<uint>>          posicion_metilada;
+
+    /** ***********************************************************************************************
+      *  \brief medias de los grupos por ventana, acumuladas muestra a muestra
+      *  \param por_muestra     modo por muestra activo
+      *  \param cromosoma       cromosoma en curso
+      *  \param suma_grupo      suma por grupo y ventana de los coeficientes de las muestras con
+      *                         suficientes posiciones metiladas en la ventana: caso y control, o
+      *                         los grupos de config.grupos
+      *  \param cuenta_grupo    número de esas muestras por grupo y ventana
+      *  \param ocupacion       un bit por ventana, en palabras de 64, con al menos una muestra
+      *                         sumada; la búsqueda sólo recorre las ventanas ocupadas
+      * ***********************************************************************************************
+      */
+    bool            por_muestra;
+    int             cromosoma;
+    vector<vector<float>> suma_grupo;
+    vector<vector<uint>>  cuenta_grupo;
+    vector<quint64> ocupacion;
+
+    /** ***********************************************************************************************
+      *  \brief regiones objetivo de los trabajos con fichero BED
+      *  \param objetivos           regiones leídas, por fichero BED
+      *  \param ventanas_objetivo   ventanas de la transformada, contadas desde limite_inferior, que
+      *                             cubren las regiones del cromosoma en curso, o los candidatos de
+      *                             la búsqueda jerárquica; sólo se transforman éstas, una tras otra,
+      *                             vacío sin regiones objetivo ni búsqueda jerárquica
+      *  \param tramos_lectura      primera y última posición de cada tramo de ventanas consecutivas,
+      *                             los únicos registros que se leen de cada muestra
+      *  \param siguientes_lectura  registros que leer_muestra lee además tras cada tramo
+      * ***********************************************************************************************
+      */
+    QMap<QString, Regiones_objetivo> objetivos;
+    vector<uint>                     ventanas_objetivo;
+    vector<pair<uint, uint>>         tramos_lectura;
+    int                              siguientes_lectura;
+
+    /** ***********************************************************************************************
+      *  \brief inicio de cada ventana de la transformada estacionaria, contado desde limite_inferior:
+      *         las posiciones metiladas con cobertura de alguna muestra del trabajo, ordenadas y sin
+      *         repetir; vacío con la transformada decimada
+      * ***********************************************************************************************
+      */
+    vector<uint>                     anclas;
+
+    /** ***********************************************************************************************
+      *  \brief índice de CpGs de la señal en curso en el espacio de CpGs: posiciones con cobertura de
+      *         alguna muestra del trabajo, contadas desde limite_inferior, ordenadas y sin repetir. La
+      *         columna de una posición en la transformada es su orden en el índice; vacío en el
+      *         espacio de posiciones
+      * ***********************************************************************************************
+      */
+    vector<uint>                     indice_cpg;
+
+    /** ***********************************************************************************************
+      *  \brief región de un DMR hallado, en posiciones del cromosoma y en ventanas de la transformada
+      * ***********************************************************************************************
+      */
+    struct region_dmr
+    {
+        uint pos_inf;
+        uint pos_sup;
+        uint ancho;
+        uint dwt_ini;
+        uint dwt_fin;
+    };
+
+    /** ***********************************************************************************************
+      *  \brief características de una muestra en un DMR que se guardan en el fichero de resultados
+      * ***********************************************************************************************
+      */
+    struct estadistica_muestra
+    {
+        int   cobertura_minima;
+        int   cobertura_maxima;
+        int   cobertura_media;
+        int   distancia_minima;
+        int   distancia_maxima;
+        int   distancia_media;
+        int   sites_C;
+        int   sites_nC;
+        int   sites_mC;
+        int   sites_hmC;
+        int   posiciones;
+        float dwt_valor;
+        float ratio_medio;
+    };
+
+    /** ***********************************************************************************************
+      *  \brief DMRs de la señal en curso y características de cada muestra en cada uno
+      *  \param regiones        regiones de los DMRs de dmrs, en el mismo orden
+      *  \param estadisticas    características de la muestra j en el DMR i en j * regiones + i
+      *  \param valores_p       p-valor empírico de cada DMR por permutaciones, vacío sin ellas
+      *  \param valores_bb      p-valor de la prueba beta-binomial de cada DMR, vacío sin ella
+      *                         ..en double porque el p-valor asintótico de DMRs con mucha cobertura
+      *                         baja de 1e-38 y en float saldría como 0; el empírico nunca baja de
+      *                         1 / (permutaciones + 1) y le basta float
+      * ***********************************************************************************************
+      */
+    vector<region_dmr>          regiones;
+    vector<estadistica_muestra> estadisticas;
+    vector<float>               valores_p;
+    vector<double>              valores_bb;
+
+    /** ***********************************************************************************************
+      *  \brief proporción de una muestra en una posición de un DMR, para refinar sus extremos
+      *  \param posicion    posición en el cromosoma
+      *  \param grupo       grupo de la muestra, como en grupo_muestra
+      *  \param ratio       proporción de la señal en la posición
+      *  \param metilados   reads con la señal en la posición
+      *  \param cobertura   cobertura de la señal en la posición
+      * ***********************************************************************************************
+      */
+    struct sitio_dmr
+    {
+        uint  posicion;
+        int   grupo;
+        float ratio;
+        float metilados;
+        float cobertura;
+    };
+
+    /** ***********************************************************************************************
+      *  \brief variables para control de procesos en hilos
+      *  \param hilo_files_worker   vector de hilos que albergan la función de lectura y procesamiento previo
+      *  \param files_worker        vector de funciones de lectura y procesamiento previo de ficheros
+      *  \param *hilo_refGen        hilo que alberga la función de lectura de genes por cromosoma
+      *  \param mutex               control de acceso a memoria compartida por los hilos
+      * ***********************************************************************************************
+      */
+    QVector<QThread*>      hilo_files_worker;
+    QVector<Files_worker*> files_worker;
+    QThread               *hilo_refGen;
+    QMutex                 mutex;
+
+    /** ***********************************************************************************************
+      * \fn static QString clave_muestra(const QString &, int, const dmr_config &)
+      *  \brief Identifica el fichero de una muestra: directorio, cromosoma y cadenas leídas
+      * ***********************************************************************************************
+      */
+    static QString clave_muestra(const QString &directorio, int chrom, const dmr_config &configx);
+
+    /** ***********************************************************************************************
+      * \fn QStringList claves_trabajo(int, const dmr_config &)
+      *  \brief Claves de las muestras de un trabajo, casos y después controles
+      * ***********************************************************************************************
+      */
+    static QStringList claves_trabajo(int chrom, const dmr_config &configx);
+
+    /** ***********************************************************************************************
+      * \fn bool seleccionar_trabajo(int, int)
+      *  \brief Activa la configuración de un trabajo y prepara el directorio de resultados parciales
+      *         del cromosoma, sin restos de un intento anterior
+      *  \param t       posición del trabajo en la lista de trabajos
+      *  \param chrom   cromosoma a analizar
+      *  \return        false si no se puede preparar el directorio de resultados parciales
+      * ***********************************************************************************************
+      */
+    bool seleccionar_trabajo(int t, int chrom);
+
+    /** ***********************************************************************************************
+      * \fn void leer_referencias(int)
+      *  \brief lanza en su hilo la lectura de las referencias genómicas de un cromosoma
+      * ***********************************************************************************************
+      */
+    void leer_referencias(int chrom);
+
+    /** ***********************************************************************************************
+      * \fn bool leer_cromosoma(int, int)
+      *  \brief lee en paralelo las muestras del trabajo en curso que aún no se han leído y las
+      *         coloca en mc en el orden del trabajo
+      *  \param chrom   cromosoma a leer
+      *  \param n       posición del trabajo en la lista de trabajos del cromosoma
+      *  \return        false si alguna muestra no tiene datos del cromosoma
+      * ***********************************************************************************************
+      */
+    bool leer_cromosoma(int chrom, int n);
+
+    /** ***********************************************************************************************
+      * \fn bool leer_limites(const QStringList &)
+      *  \brief Fija la ventana del cromosoma y el grupo de cada muestra a partir de la primera y la
+      *         última posición de cada fichero, sin leerlos enteros
+      *  \return        false si alguna muestra no tiene datos del cromosoma
+      * ***********************************************************************************************
+      */
+    bool leer_limites(const QStringList &claves);
+
+    /** ***********************************************************************************************
+      * \fn const vector<pair<uint, uint>> &regiones_cromosoma(int)
+      *  \brief Regiones objetivo del trabajo en curso en un cromosoma, leyendo el BED la primera vez
+      * ***********************************************************************************************
+      */
+    const vector<pair<uint, uint>> &regiones_cromosoma(int chrom);
+
+    /** ***********************************************************************************************
+      * \fn bool preparar_ventanas(int)
+      *  \brief Calcula las ventanas que cubren las regiones objetivo de un cromosoma y los tramos de
+      *         posiciones a leer, con la ventana del cromosoma ya fijada
+      *  \return        false si ninguna región cae dentro de los datos del cromosoma
+      * ***********************************************************************************************
+      */
+    bool preparar_ventanas(int chrom);
+
+    /** ***********************************************************************************************
+      * \fn bool completar_ventanas()
+      *  \brief Asegura al menos dos ventanas objetivo y calcula los tramos de posiciones a leer
+      *  \return        false si no hay ventanas o el cromosoma no tiene dos
+      * ***********************************************************************************************
+      */
+    bool completar_ventanas();
+
+    /** ***********************************************************************************************
+      * \fn void compactar_ventanas(int)
+      *  \brief Reduce las ventanas a transformar a las que tienen alguna posición con cobertura en
+      *         alguna muestra del trabajo, con las muestras en memoria
+      *
+      *         Sin ventanas objetivo parte de todas las del cromosoma. Las ventanas vacías dan
+      *         coeficientes nulos que ninguna muestra suma a su grupo, así que quitarlas no cambia los
+      *         DMRs: centrómeros, huecos y regiones sin cobertura no llegan a la GPU.
+      * ***********************************************************************************************
+      */
+    void compactar_ventanas(int mh);
+
+    /** ***********************************************************************************************
+      * \fn void devolver_muestras()
+      *  \brief Devuelve las muestras de mc a las muestras compartidas al acabar un trabajo
+      * ***********************************************************************************************
+      */
+    void devolver_muestras();
+
+    /** ***********************************************************************************************
+      * \fn void ajustar_memoria(int)
+      *  \brief Descarta las muestras que no usa ningún trabajo posterior y, si se supera el límite
+      *         de memoria, las sumas de grupo, las transformadas y las muestras cuyo siguiente uso
+      *         es más lejano
+      *  \param n       posición del último trabajo terminado en la lista de trabajos del cromosoma
+      * ***********************************************************************************************
+      */
+    void ajustar_memoria(int n);
+
+    /** ***********************************************************************************************
+      * \fn void descartar_muestra(const QString &) and two more
+      *  \brief Funciones responsables de liberar una muestra, una transformada o una suma de grupo
+      *         guardadas
+      * ***********************************************************************************************
+      */
+    void descartar_muestra(const QString &clave);
+    void descartar_transformada(const QString &clave);
+    void descartar_suma(const QString &clave);
+
+    /** ***********************************************************************************************
+      * \fn void lectura_acabada()
+      *  \brief función responsable de la identificación de DMRs y guardado en disco de los resultados
+      * ***********************************************************************************************
+      */
+    void lectura_acabada();
+
+    /** ***********************************************************************************************
+      * \fn void transformar_bloque(const vector<uint> &, float **, int, uint, const QStringList &)
+      *  \brief Transforma en GPU un bloque de filas de mc y deja sus posiciones metiladas en
+      *         posicion_metilada
+      *  \param bloque          filas de mc a transformar
+      *  \param destino         filas de coeficientes en las que la GPU deja cada muestra del bloque
+      *  \param mh              señal analizada: 0 mC, 1 hmC
+      *  \param dimension       posiciones de la ventana del cromosoma
+      *  \param directorios     directorio de cada fila de mc, para la telemetría
+      * ***********************************************************************************************
+      */
+    void transformar_bloque(const vector<uint> &bloque, float **destino, int mh, uint dimension,
+                            const QStringList &directorios);
+
+    /** ***********************************************************************************************
+      * \fn void preparar_anclas(int)
+      *  \brief Inicio de las ventanas de la transformada estacionaria de una señal, con las posiciones
+      *         de todas las muestras, que en el modo por muestra se leen una vez más
+      * ***********************************************************************************************
+      */
+    void preparar_anclas(int mh);
+
+    /** ***********************************************************************************************
+      * \fn void unir_posiciones(int, vector<uint> &)
+      *  \brief Unión ordenada y sin repetir de las posiciones con cobertura de todas las muestras del
+      *         trabajo en las ventanas objetivo, contadas desde limite_inferior
+      *
+      *         Con las muestras en memoria, las posiciones de cada muestra se recogen en paralelo y se
+      *         mezclan a la vez con un montículo de una cabeza por muestra (k-way merge). En el modo
+      *         por muestra cada muestra se lee una vez más y se mezcla con la unión de las anteriores.
+      * ***********************************************************************************************
+      */
+    void unir_posiciones(int mh, vector<uint> &posiciones);
+
+    /** ***********************************************************************************************
+      * \fn uint ultima_ventana(int) const and two more
+      *  \brief Última ventana de la transformada del cromosoma a un nivel, y primera posición y
+      *         posición siguiente a la última de una ventana, en el espacio de posiciones o de CpGs
+      *  \param v       ventana del cromosoma, sin compactar en las ventanas objetivo
+      * ***********************************************************************************************
+      */
+    uint ultima_ventana(int nivel) const;
+    uint inicio_ventana(uint v) const;
+    uint fin_ventana(uint v) const;
+
+    /** ***********************************************************************************************
+      * \fn uint inicio_coeficiente(uint) const and two more
+      *  \brief Primera posición y posición siguiente a la última de la ventana de un coeficiente de
+      *         la transformada, con ventanas objetivo, anclas o índice de CpGs, y si la ventana del
+      *         coeficiente siguiente continúa la suya en el cromosoma, para unirlas en un DMR
+      *  \param m       coeficiente, columna de h_haar_C
+      * ***********************************************************************************************
+      */
+    uint inicio_coeficiente(uint m) const;
+    uint fin_coeficiente(uint m) const;
+    bool contigua(uint m) const;
+
+    /** ***********************************************************************************************
+      * \fn bool en_objetivo(uint, uint, size_t &) const
+      *  \brief Informa si una posición, contada desde limite_inferior, está en las ventanas objetivo,
+      *         siempre sin regiones objetivo
+      *  \param paso        posiciones por ventana
+      *  \param ventana     ventana objetivo desde la que se busca, avanza con posiciones crecientes
+      * ***********************************************************************************************
+      */
+    bool en_objetivo(uint columna, uint paso, size_t &ventana) const;
+
+    /** ***********************************************************************************************
+      * \fn void transformar_muestras(int, uint, const QStringList &)
+      *  \brief Transforma todas las muestras del trabajo para una señal, recuperando las que ya ha
+      *         transformado un trabajo anterior, o las suma a las medias en el modo por muestra
+      * ***********************************************************************************************
+      */
+    void transformar_muestras(int mh, uint dimension, const QStringList &directorios);
+
+    /** ***********************************************************************************************
+      * \fn bool buscar_candidatos(int, uint, const QStringList &)
+      *  \brief Primera pasada de la búsqueda jerárquica: transforma y busca en todo el cromosoma al
+      *         nivel grueso y deja como ventanas objetivo las del nivel pedido que cubren cada ventana
+      *         gruesa sobre el umbral y sus dos vecinas
+      *  \param dimension   posiciones del cromosoma completo
+      *  \return            false si no hay candidatos
+      * ***********************************************************************************************
+      */
+    bool buscar_candidatos(int mh, uint dimension, const QStringList &directorios);
+
+    /** ***********************************************************************************************
+      * \fn void transformar_estacionaria(const vector<uint> &, float **, int, const QStringList &)
+      *  \brief Transformada estacionaria de un bloque de filas de mc en CPU, repartiendo las muestras
+      *         entre hilos, con los mismos parámetros que transformar_bloque
+      *
+      *         Cada coeficiente es la aproximación Haar del nivel pedido de la ventana de 2^nivel
+      *         posiciones que empieza en una ancla, suma de sus valores por 2^(-nivel/2) como en la
+      *         GPU, y se obtiene de las sumas acumuladas de las posiciones metiladas de la muestra
+      *         recorriendo a la vez posiciones y anclas, en tiempo lineal.
+      * ***********************************************************************************************
+      */
+    void transformar_estacionaria(const vector<uint> &bloque, float **destino, int mh,
+                                  const QStringList &directorios);
+
+    /** ***********************************************************************************************
+      * \fn Registros_muestra leer_muestra(uint)
+      *  \brief Lee en el hilo actual el cromosoma en curso de la muestra de una fila de mc, en el
+      *         modo por muestra
+      * ***********************************************************************************************
+      */
+    Registros_muestra leer_muestra(uint i);
+
+    /** ***********************************************************************************************
+      * \fn void transformar_por_muestra(int, uint, const QStringList &, bool)
+      *  \brief Lee y transforma las muestras de una en una en el modo por muestra, descartando cada
+      *         una antes de leer la siguiente
+      *  \param medir   false: suma cada muestra a las medias de su grupo
+      *                 true: guarda las características de cada muestra en los DMRs hallados
+      * ***********************************************************************************************
+      */
+    void transformar_por_muestra(int mh, uint dimension, const QStringList &directorios, bool medir);
+
+    /** ***********************************************************************************************
+      * \fn void iniciar_medias() and one more
+      *  \brief Suma de los coeficientes de una fila de mc a la media de su grupo en las ventanas con
+      *         suficientes posiciones metiladas
+      *  \param i               fila de mc, con sus posiciones en posicion_metilada
+      *  \param coeficientes    coeficientes transformados de la muestra
+      * ***********************************************************************************************
+      */
+    void iniciar_medias();
+    void acumular_muestra(uint i, const float *coeficientes);
+
+    /** ***********************************************************************************************
+      * \fn int numero_grupos() const
+      *  \brief Grupos del trabajo en curso: caso y control, o los de su hoja de muestras
+      * ***********************************************************************************************
+      */
+    int numero_grupos() const;
+
+    /** ***********************************************************************************************
+      * \fn void ventanas_densas(uint, vector<uint> &) const
+      *  \brief Ventanas, en orden, en las que una fila de mc tiene suficientes posiciones metiladas
+      *         para sumarse a la media de su grupo
+      * ***********************************************************************************************
+      */
+    void ventanas_densas(uint i, vector<uint> &densas) const;
+
+    /** ***********************************************************************************************
+      * \fn void sumar_grupos()
+      *  \brief Medias de los grupos con todas las filas de h_haar_C a la vez
+      *
+      *         Cada bloque de 64 ventanas se traspone a una matriz con una fila por ventana y una
+      *         columna por muestra, aparte casos y controles, con ceros en las ventanas que una
+      *         muestra no llega a sumar. Así la suma y la cuenta de cada ventana recorren memoria
+      *         contigua, vectorizadas entre muestras, y los bloques se reparten entre hilos.
+      *
+      *         En los trabajos de una hoja de muestras la suma de un grupo se guarda en sumas y los
+      *         trabajos siguientes del cromosoma con el mismo grupo la recuperan sin sumarla.
+      * ***********************************************************************************************
+      */
+    void sumar_grupos();
+
+    /** ***********************************************************************************************
+      *  \brief DMR de un par de muestras en la comparación muestra a muestra
+      *  \param a, b            filas de mc del par; b es mc.size() para la media de los controles
+      *  \param inicio, fin     primera posición y posición siguiente a la última
+      *  \param diferencia      media de las diferencias de a menos b en sus ventanas
+      * ***********************************************************************************************
+      */
+    struct dmr_par
+    {
+        uint  a;
+        uint  b;
+        uint  inicio;
+        uint  fin;
+        float diferencia;
+    };
+
+    /** ***********************************************************************************************
+      * \fn int comparar_pares(int, size_t)
+      *  \brief Comparación muestra a muestra sobre las transformadas de h_haar_C: cada muestra con
+      *         cada otra, o cada caso con la media de los controles
+      *
+      *         Las ventanas densas de todas las muestras se trasponen a una matriz con una fila por
+      *         ventana. Los pares se reparten entre hilos en bloques de MUESTRAS_POR_BLOQUE por
+      *         MUESTRAS_POR_BLOQUE muestras que recorren las ventanas con sus columnas en caché y
+      *         calculan las diferencias de cada fila del bloque vectorizadas entre columnas. Las
+      *         ventanas seguidas de un par sobre el umbral forman un DMR, como en hallar_dmrs.
+      *  \param ventanas    coeficientes a comparar, 0 si la señal no tiene candidatos
+      *  \return            número de DMRs de todos los pares
+      * ***********************************************************************************************
+      */
+    int comparar_pares(int mh, size_t ventanas);
+
+    /** ***********************************************************************************************
+      * \fn void find_dmrs() and two more
+      *  \brief Funciones responsables de encontrar DMRs y guardar los resultados
+      * ***********************************************************************************************
+      */
+    void find_dmrs();
+    void hallar_dmrs();
+    void save_dmr_list(int);
+
+    /** ***********************************************************************************************
+      * \fn void preparar_regiones() and one more
+      *  \brief Características de cada muestra en los DMRs hallados, muestra a muestra, que guarda
+      *         save_dmr_list
+      *  \param j               fila de mc
+      *  \param coeficientes    coeficientes transformados de la muestra
+      *  \param mh              señal analizada: 0 mC, 1 hmC
+      * ***********************************************************************************************
+      */
+    void preparar_regiones();
+    void medir_muestra(uint j, const float *coeficientes, int mh);
+
+    /** ***********************************************************************************************
+      * \fn vector<pair<uint, uint>> tramos_dmrs() const
+      *  \brief Tramos de posiciones de los DMRs hallados para la segunda lectura del modo por
+      *         muestra: de cada DMR, sus extremos y los de las ventanas de sus coeficientes, unidos
+      *         los que se solapan o se tocan
+      * ***********************************************************************************************
+      */
+    vector<pair<uint, uint>> tramos_dmrs() const;
+
+    /** ***********************************************************************************************
+      * \fn void refinar_dmrs(int)
+      *  \brief Recorta los extremos de cada DMR a la primera y la última posición diferencial, con
+      *         la diferencia de medias de las proporciones por grupo por encima del umbral y del mismo
+      *         signo que el DMR; un DMR sin ninguna conserva sus extremos
+      *
+      *         Sólo se recorren los registros dentro de cada DMR, buscando su inicio en los registros
+      *         ordenados de cada muestra, y los DMRs se reparten entre hilos. En el modo por muestra
+      *         cada muestra se vuelve a leer.
+      * ***********************************************************************************************
+      */
+    void refinar_dmrs(int mh);
+
+    /** ***********************************************************************************************
+      * \fn void permutar_etiquetas(int)
+      *  \brief P-valor empírico de cada DMR con config.permutaciones permutaciones de las etiquetas
+      *         caso / control, con el mismo número de muestras por grupo
+      *
+      *         El estadístico de un DMR es el valor absoluto de la media en sus ventanas de la
+      *         diferencia de medias de los grupos, con los mínimos de muestras de find_dmrs. Una
+      *         permutación sólo cambia qué muestras suman a cada grupo, de forma que la suma de un
+      *         grupo es el producto de la fila de coeficientes de la ventana por un vector de
+      *         etiquetas 0 / 1. Cada DMR traspone sus ventanas y recorre las permutaciones en lotes,
+      *         vectorizado entre las permutaciones del lote, y los DMRs se reparten entre hilos. Las
+      *         permutaciones son las mismas para todos los DMRs de la señal y el cromosoma.
+      *
+      *         Un DMR deja de permutarse al superar su estadístico EXCESOS_PARADA veces (Besag y
+      *         Clifford), de forma que sólo los DMRs con p-valores pequeños recorren todas.
+      * ***********************************************************************************************
+      */
+    void permutar_etiquetas(int mh);
+
+    /** ***********************************************************************************************
+      * \fn void sumar_sitios(const Registros_muestra &, uint, int, vector<vector<sitio_dmr>> &) const
+      *  \brief Añade los sitios de una muestra dentro de cada DMR a las sumas de refinar_dmrs y de
+      *         probar_beta_binomial
+      *  \param r           registros de la fila j de mc
+      *  \param sitios      proporciones y reads de cada DMR, en el orden de regiones
+      * ***********************************************************************************************
+      */
+    void sumar_sitios(const Registros_muestra &r, uint j, int mh, vector<vector<sitio_dmr>> &sitios) const;
+
+    /** ***********************************************************************************************
+      * \fn void probar_beta_binomial(int)
+      *  \brief P-valor de cada DMR con una prueba de razón de verosimilitudes beta-binomial sobre los
+      *         reads de todas sus posiciones y muestras, casos frente a controles
+      *
+      *         Cada posición de cada muestra con la cobertura mínima es una observación de k reads con
+      *         la señal entre n, en las posiciones con los mínimos de muestras por grupo de
+      *         refinar_dmrs. La media de cada grupo es su proporción de reads y la dispersión, común
+      *         a los dos modelos, se estima por momentos con los residuos de cada grupo. El
+      *         estadístico compara una media por grupo con una media común y se contrasta con una
+      *         chi-cuadrado de 1 grado de libertad.
+      *
+      *         Los términos de la verosimilitud se calculan en un bucle vectorizado sobre las
+      *         observaciones, en arrays por campo, con log_gamma y log_simd, y los DMRs se reparten
+      *         entre hilos. En el modo por muestra cada muestra se vuelve a leer.
+      * ***********************************************************************************************
+      */
+    void probar_beta_binomial(int mh);
+
+    /** ***********************************************************************************************
+      * \fn static void escribir_estadistica(QTextStream &, const estadistica_muestra &, int)
+      *  \brief Escribe las características de una muestra en un DMR, a cero salvo el valor dwt y la
+      *         proporción si ninguna posición llega a la cobertura mínima
+      * ***********************************************************************************************
+      */
+    static void escribir_estadistica(QTextStream &s, const estadistica_muestra &e, int minimo);
+
+    /** ***********************************************************************************************
+      * \fn void liberar_memoria()
+      *  \brief Función responsable de liberar la memoria de GPU y de soltar las matrices contiguas,
+      *         que siguen reservadas en arena para la siguiente señal o cromosoma
+      * ***********************************************************************************************
+      */
+    void liberar_memoria();
+};
+
+#endif // DMR_ENGINE_H
@@ -1,4 +1,6 @@
 #include "files_worker.h"
+#include "indice_posiciones.h"
+#include "telemetria.h"
 #include <QDebug>
 #include <sstream>
 #include <iostream>
@@ -14,7 +16,7 @@ Files_worker::Files_worker(QObject *parent)
 void Files_worker::solicitud_lectura(QStringList cases_files,
                                      QStringList control_files,
                                      QStringList parametros,
-                                     vector<vector<vector<double>>> &mcx,
+                                     vector<Registros_muestra> &mcx,
                                      QMutex &mutexx)
 {
     lista_casos     = cases_files;
@@ -24,6 +26,8 @@ void Files_worker::solicitud_lectura(QStringList cases_files,
     //  1   reverse bool
     //  2   cromosoma
     //  3   número de fichero asignado (hilo)
+    //  4   directorio de trabajo para volcar los registros leídos, vacío para dejarlos en memoria
+    //  5   nombre del cromosoma o contig en los ficheros
     argumentos      = parametros;
     mc              = &mcx;
     mutex           = &mutexx;
@@ -41,6 +45,80 @@ void Files_worker::abort()
         aborted = true;
 }
 
+// ************************************************************************************************
+QString Files_worker::fichero_muestra(const QString &directorio, bool forward, bool reverse, const QString &contig)
+{
+    QStringList leer = {"forward_", "reverse_", "mix_"};
+    int que_leo = (forward && reverse) ? 2 : (forward ? 0 : 1);
+
+    return directorio + "/methylation_map_" + leer[que_leo] + contig + ".csv";
+}
+
+// ************************************************************************************************
+QString Files_worker::fichero_muestra(const QString &directorio, const QStringList &parametros)
+{
+    return fichero_muestra(directorio, parametros[0].toInt(), parametros[1].toInt(), parametros.at(5));
+}
+
+// ************************************************************************************************
+bool Files_worker::limites(const QString &directorio, const QStringList &parametros, uint &inicio, uint &final)
+{
+    // con el índice de posiciones guardado no hace falta abrir el fichero
+    Indice_posiciones indice;
+    if (Indice_posiciones::cargar(fichero_muestra(directorio, parametros), indice))
+    {
+        inicio = indice.primera();
+        final  = indice.ultima();
+        return inicio > 0;
+    }
+
+    QFile data(fichero_muestra(directorio, parametros));
+    if (!data.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    // primera posición válida desde el principio
+    inicio = 0;
+    while (!data.atEnd() && inicio == 0)
+        inicio = Indice_posiciones::posicion(data.readLine());
+    if (inicio == 0)
+        return false;
+
+    // última posición válida en el final del fichero, ordenado por posición
+    // ..si el último tramo no tiene ninguna se recorre el fichero completo
+    final = inicio;
+    for (qint64 tramo = 64 * 1024; ; tramo = data.size())
+    {
+        if (data.size() > tramo)
+        {
+            data.seek(data.size() - tramo);
+            data.readLine();                            // línea incompleta
+        }
+        else
+            data.seek(0);
+
+        uint ultima = 0;
+        while (!data.atEnd())
+        {
+            uint posicion = Indice_posiciones::posicion(data.readLine());
+            if (posicion > 0)
+                ultima = posicion;
+        }
+
+        if (ultima > 0 || tramo >= data.size())
+        {
+            final = qMax(final, ultima);
+            return true;
+        }
+    }
+}
+
+// ************************************************************************************************
+void Files_worker::limitar_tramos(const vector<pair<uint, uint>> &tramosx, int siguientesx)
+{
+    tramos     = tramosx;
+    siguientes = siguientesx;
+}
+
 // ************************************************************************************************
 void Files_worker::lectura()
 {
@@ -48,7 +126,6 @@ void Files_worker::lectura()
     int final  = 0;
 
     int que_leo;
-    QStringList leer = {"forward_", "reverse_", "mix_"};
     if (argumentos[0].toInt() && argumentos[1].toInt())
         que_leo = 2;
     else if (argumentos[0].toInt())
@@ -57,7 +134,7 @@ void Files_worker::lectura()
         que_leo = 1;
     }
 
-    vector<vector<double>> aux3;        // vector auxiliar para montar fichero de proporción de metilación para forward
+    vector<double> aux3;                // registros contiguos de proporción de metilación, Registros_muestra::CAMPOS por posición
 
     // inicializa la posición inferior y superior
     QString fichero       = "";
@@ -71,23 +148,18 @@ void Files_worker::lectura()
     double h_metilado     = 0.0;
     double proporcion_mC  = 0.0;
     double proporcion_hmC = 0.0;
+    qint64 leidos         = 0;          // bytes leídos del fichero
 
     // abre el fichero correspondiente para leer y almacenar
     if (argumentos[3].toInt() - lista_casos.size() < 0)
-        fichero = lista_casos[argumentos[3].toInt()] +
-                  "/methylation_map_" +
-                  leer[que_leo] +
-                  argumentos.at(2) +
-                  ".csv";
+        fichero = fichero_muestra(lista_casos[argumentos[3].toInt()], argumentos);
     else
-        fichero = lista_controles[argumentos[3].toInt() - lista_casos.size()] +
-                  "/methylation_map_" +
-                  leer[que_leo] +
-                  argumentos.at(2) +
-                  ".csv";
+        fichero = fichero_muestra(lista_controles[argumentos[3].toInt() - lista_casos.size()], argumentos);
 
     data.setFileName(fichero);
 
+    Telemetria::Medida medida("parse", argumentos.at(2).toInt(), -1, fichero.section("/methylation_map_", 0, 0));
+
     // comprueba que el fichero se ha abierto correctamente
     if (!data.open(QIODevice::ReadOnly | QIODevice::Text))
     {
@@ -95,19 +167,56 @@ void Files_worker::lectura()
     }
     else
     {
+        // con tramos de posiciones sólo se guardan sus registros, y el índice de posiciones permite
+        // saltar sin leerlos los bytes que quedan antes de cada tramo
+        // ..los registros siguientes a un tramo se leen antes de saltar al próximo
+        Indice_posiciones indice;
+        bool   saltar = !tramos.empty() && Indice_posiciones::abrir(fichero, indice);
+        size_t tramo  = 0;
+        int    extra  = 0;
+
         // lee y guarda todos los datos
         while (!data.atEnd())
         {
             if (aborted)
                 break;
 
+            // ..tras el último tramo no hay a dónde saltar, sólo quedan sus registros siguientes
+            if (saltar && extra == 0 && tramo < tramos.size())
+            {
+                qint64 desplazamiento = indice.desplazamiento(tramos[tramo].first);
+                if (desplazamiento > data.pos())
+                    data.seek(desplazamiento);
+            }
+
             linea = data.readLine();
+            leidos += linea.size();
             stringstream posicion (linea.toStdString());
 
             while (getline (posicion, numero, ' '))
                 if (isdigit(numero[0]))
                     aux1.push_back(stoi(numero));
 
+            if (!tramos.empty())
+            {
+                while (tramo < tramos.size() && uint(aux1[0]) > tramos[tramo].second)
+                {
+                    tramo++;
+                    extra = siguientes;
+                }
+
+                bool fuera = tramo == tramos.size() || uint(aux1[0]) < tramos[tramo].first;
+                if (fuera && extra > 0)
+                    extra--;
+                else if (tramo == tramos.size())
+                    break;
+                else if (fuera)
+                {
+                    aux1.clear();
+                    continue;
+                }
+            }
+
             // procesamiento de los datos de la línea
             // como cobertura se suma en número de C y mC o hmC
             // se descarta el número de nC
@@ -167,25 +276,34 @@ void Files_worker::lectura()
             // si la primera posición es cero no se contempla para preservar la integridad de
             // la identificación de DMRs tal y como está definido
             if (aux1[0] > 0)
-                aux3.push_back(aux2);
+                aux3.insert(aux3.end(), aux2.begin(), aux2.end());
 
             aux1.clear();
             aux2.clear();
         }
 
         // actualiza la posición mínima y máxima
-        if (inicio >= int(aux3.front().front()))
-            inicio = int(aux3.front().front());
-        if (final < int(aux3.back().front()))
-            final = int(aux3.back().front());
+        if (!aux3.empty() && inicio >= int(aux3.front()))
+            inicio = int(aux3.front());
+        if (!aux3.empty() && final < int(aux3[aux3.size() - Registros_muestra::CAMPOS]))
+            final = int(aux3[aux3.size() - Registros_muestra::CAMPOS]);
     }
 
     // cierra el fichero de datos
+    medida.bytes(leidos);
+    medida.sitios(qint64(aux3.size() / Registros_muestra::CAMPOS));
     data.close();
 
-    // carga los datos en la matriz principal
+    // fuera de memoria los registros pasan al disco de trabajo, escrito de forma secuencial
+    Registros_muestra registros(std::move(aux3));
+    QString texto_error;
+    if (argumentos.size() > 4 && !argumentos.at(4).isEmpty() && !registros.volcar(argumentos.at(4), texto_error))
+        qDebug() << "ERROR:" << texto_error << "- the sample stays in memory";
+
+    // carga los datos en la matriz principal, en la posición reservada para la muestra
+    // para que el orden de las muestras no dependa del orden en que acaban los hilos
     mutex->lock();
-    mc->push_back(aux3);
+    (*mc)[uint(argumentos[3].toInt())].swap(registros);
     mutex->unlock();
 
     // envía señal de lectura de fichero para su procesado en otro hilo
@@ -5,6 +5,8 @@
 #include <QFile>
 #include <QVector>
 #include <QMutex>
+#include <utility>
+#include "registros_muestra.h"
 
 using namespace std;
 
@@ -16,18 +18,18 @@ public:
     Files_worker(QObject *parent = nullptr);
 
     /**
-     * \fn void solicitud_lectura(QStringList, QStringList, QStringList, vector<vector<vector<float>>> &, QMutex &)
+     * \fn void solicitud_lectura(QStringList, QStringList, QStringList, vector<Registros_muestra> &, QMutex &)
      * @brief Solicita al worker que comience
      * @param cases_files   ruta del ejecutable
      * @param control_files opciones para la ejecución
      * @param parameters    ruta para guardas los ficheros mapeados
-     * @param &mcx          matriz de datos por posición y muestra
+     * @param &mcx          matriz de datos por posición y muestra, con una posición ya reservada por muestra
      * @param &mutexx       control de acceso a memoria compartida
      */
     void solicitud_lectura(QStringList cases_files,
                            QStringList control_files,
                            QStringList parameters,
-                           vector<vector<vector<double>>> &mcx,
+                           vector<Registros_muestra> &mcx,
                            QMutex &mutexx);
 
     /**
@@ -35,6 +37,32 @@ public:
      */
     void abort();
 
+    /**
+     * @fn void limitar_tramos(const vector<pair<uint, uint>> &, int)
+     * @brief Limita la siguiente lectura a los registros de unos tramos de posiciones, ordenados y
+     *        sin solapes, leyendo sólo sus bytes con el índice de posiciones del fichero
+     * @param tramosx       primera y última posición de cada tramo, vacío para leer el fichero entero
+     * @param siguientesx   registros que se leen además tras el final de cada tramo
+     */
+    void limitar_tramos(const vector<pair<uint, uint>> &tramosx, int siguientesx = 0);
+
+    /**
+     * @fn static bool limites(const QString &, const QStringList &, uint &, uint &)
+     * @brief Primera y última posición de un cromosoma de una muestra sin leer el fichero entero,
+     *        que está ordenado por posición
+     * @param directorio    directorio de la muestra
+     * @param parametros    parámetros de lectura, como en solicitud_lectura
+     * @return              false si el fichero no existe o no tiene registros
+     */
+    static bool limites(const QString &directorio, const QStringList &parametros, uint &inicio, uint &final);
+
+    /**
+     * @fn static QString fichero_muestra(const QString &, bool, bool, const QString &)
+     * @brief Fichero de un cromosoma o contig de una muestra con las cadenas que se leen
+     * @param contig        nombre del cromosoma o contig en los ficheros
+     */
+    static QString fichero_muestra(const QString &directorio, bool forward, bool reverse, const QString &contig);
+
 signals:
     /**
      * @fn void lectura_solicitada()
@@ -67,6 +95,12 @@ public slots:
     void lectura();
 
 private:
+    /**
+     * @fn static QString fichero_muestra(const QString &, const QStringList &)
+     * @brief Fichero de un cromosoma de una muestra con las cadenas indicadas en los parámetros
+     */
+    static QString fichero_muestra(const QString &directorio, const QStringList &parametros);
+
     /**
      * @brief variables internas para control de operaciones y almacenamiento de datos en local
      * @param aborted           señal de control de hilo activo
@@ -74,6 +108,8 @@ private:
      * @param lista_casos       listado de muestras etiquetadas como caso
      * @param lista_controles   listado de muestras etiquetadas como control
      * @param argumentos        lista de argumentos desde hilo primcipal para carga de ficheros
+     * @param tramos            tramos de posiciones a leer, vacío para leer todas
+     * @param siguientes        registros que se leen tras el final de cada tramo
      * @param data              acceso a fichero en disco para lectura
      */
     bool aborted;
@@ -81,12 +117,14 @@ private:
     QStringList lista_casos;
     QStringList lista_controles;
     QStringList argumentos;
+    vector<pair<uint, uint>> tramos;
+    int siguientes = 0;
     QFile data;
 
     /**
      * @brief matriz donde se almacenan los datos leídos por cromosoma
      */
-    vector<vector<vector<double>>> *mc;
+    vector<Registros_muestra> *mc;
 
     /**
      * @brief variable de control de acceso a memoria compartida para todos los hilos
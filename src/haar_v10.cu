@@ -279,13 +279,9 @@ void cuda_send_data(datos_cuda &cuda_data)
   */
 void cuda_main(datos_cuda &cuda_data)
 {
-    // reserva TODA la memoria CONTIGUA para la matriz de muestras tranformadas -------------------
-    // para trasvase de datos entre GPU y CPU con CUDA, la matriz debe ser contigua completa
-    cuda_data.h_haar_C = new float*[cuda_data.samples];                             // reservar punteros a filas
-    cuda_data.h_haar_C[0] = new float[cuda_data.samples * (cuda_data.h_haar_L[0])];	// reservar toodos los datos (rows * cols)
-    for (int i = 1; i < cuda_data.samples; i++)                                     // asignar valor a punteros de fila
-        cuda_data.h_haar_C[i] = cuda_data.h_haar_C[i - 1] + cuda_data.h_haar_L[0];
-
+    // las filas de la matriz de muestras transformadas las reserva quien llama -------------------
+    // (samples filas de h_haar_L[0] datos), de forma que se reutilizan entre llamadas sin reservarlas
+    // de nuevo y los coeficientes llegan directamente a su destino final
 
     // reserva memoria para cálculos temporales en GPU --------------------------------------------
     float *d_temp;
@@ -326,13 +322,30 @@ void cuda_main(datos_cuda &cuda_data)
     //          desplazamiento óptimo de datos por fila en GPU,
     //          cantidad de bytes en GPU a copiar por muestra,
     //          número de muestras (filas)
-    gpuErrchk(cudaMemcpy2D(	cuda_data.h_haar_C[0],
-                            cuda_data.h_haar_L[0] * sizeof(float),
-                            cuda_data.d_haar,
-                            cuda_data.pitch,
-                            cuda_data.h_haar_L[0] * sizeof(float),
-                            cuda_data.samples,
-                            cudaMemcpyDeviceToHost));
+    // ..con las filas contiguas se copian todas a la vez, si no fila a fila
+    bool contiguas = true;
+    for (int i = 1; i < cuda_data.samples; i++)
+        if (cuda_data.h_haar_C[i] != cuda_data.h_haar_C[i - 1] + cuda_data.h_haar_L[0])
+            contiguas = false;
+
+    if (contiguas)
+    {
+        gpuErrchk(cudaMemcpy2D(	cuda_data.h_haar_C[0],
+                                cuda_data.h_haar_L[0] * sizeof(float),
+                                cuda_data.d_haar,
+                                cuda_data.pitch,
+                                cuda_data.h_haar_L[0] * sizeof(float),
+                                cuda_data.samples,
+                                cudaMemcpyDeviceToHost));
+    }
+    else
+    {
+        for (int i = 0; i < cuda_data.samples; i++)
+            gpuErrchk(cudaMemcpy(   cuda_data.h_haar_C[i],
+                                    (char *)cuda_data.d_haar + i * cuda_data.pitch,
+                                    cuda_data.h_haar_L[0] * sizeof(float),
+                                    cudaMemcpyDeviceToHost));
+    }
 
 
     //libera la memoria temporal utilizada para cálculos intemedios
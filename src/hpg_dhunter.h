@@ -36,68 +36,11 @@
 #include <QTextCursor>
 #include <QThread>
 #include <QMutex>
-#include <cuda_runtime.h>
-#include <cuda.h>
-#include <chrono>
-#include "data_pack.h"
-#include "files_worker.h"
-#include "refgen.h"
-
-#define TIMING
-
-#ifdef TIMING
-#define INIT_TIMER_1        auto start_1 = std::chrono::high_resolution_clock::now();
-#define INIT_TIMER_2        auto start_2 = std::chrono::high_resolution_clock::now();
-#define INIT_TIMER_3        auto start_3 = std::chrono::high_resolution_clock::now();
-#define START_TIMER_1       start_1 = std::chrono::high_resolution_clock::now();
-#define START_TIMER_2       start_2 = std::chrono::high_resolution_clock::now();
-#define START_TIMER_3       start_3 = std::chrono::high_resolution_clock::now();
-#define STOP_TIMER_1(name)  qDebug() << "DURACION de " << name << ": " << \
-                          std::chrono::duration_cast<std::chrono::milliseconds>( \
-                          std::chrono::high_resolution_clock::now()-start_1 \
-                          ).count() << " ms ";
-#define STOP_TIMER_2(name)  qDebug() << "DURACION de " << name << ": " << \
-                          std::chrono::duration_cast<std::chrono::milliseconds>( \
-                          std::chrono::high_resolution_clock::now()-start_2 \
-                          ).count() << " ms ";
-#define STOP_TIMER_3(name)  qDebug() << "DURACION de " << name << ": " << \
-                          std::chrono::duration_cast<std::chrono::milliseconds>( \
-                          std::chrono::high_resolution_clock::now()-start_3 \
-                          ).count() << " ms ";
-
-#else
-#define INIT_TIMER_1
-#define START_TIMER_1
-#define STOP_TIMER_1(name)
-#define INIT_TIMER_2
-#define START_TIMER_2
-#define STOP_TIMER_2(name)
-#define INIT_TIMER_3
-#define START_TIMER_3
-#define STOP_TIMER_3(name)
-#endif
-
+#include "dmr_config.h"
+#include "dmr_engine.h"
 
 using namespace std;
 
-
-/** ***********************************************************************************************
-  *  \brief declaración de funciones externas para compilación con nvcc
-  *  \fn    void cuda_send_data(datos_cuda &)
-  *  \fn    void cuda_main(datos_cuda &)
-  * ***********************************************************************************************
-  */
-//extern
-void cuda_send_data(datos_cuda &);
-//extern
-void cuda_main(datos_cuda &);
-//extern
-void cuda_calculo_haar_L(datos_cuda &);
-//extern
-void cuda_init();
-//extern
-void cuda_end(datos_cuda &);
-
 namespace Ui {
 class HPG_Dhunter;
 }
@@ -110,13 +53,6 @@ public:
     explicit HPG_Dhunter(QWidget *parent = nullptr);
     ~HPG_Dhunter();
 
-    /** ***********************************************************************************************
-      *  \brief variable de tipo estructura con variables para control de datos a analizar
-      *  \param cuda_data   estrutura con variables de control y datos
-      * ***********************************************************************************************
-      */
-    datos_cuda cuda_data;
-
 private slots:
     /** ***********************************************************************************************
       * \fn void on_case_file_clicked() and four more
@@ -182,31 +118,29 @@ private slots:
     void on_stop_clicked();
 
     /** ***********************************************************************************************
-      * \fn void fichero_leido(int, int, int, int)
-      *  \brief Función responsable de capturar los datos de los hilos de lectura
-      *  \param sample   muestra que se ha leído
-      *  \param chrom    cromosoma que se ha leído
-      *  \param inicio   posición inicial de la muestra leída
-      *  \param final    posición final de la muestra leída
+      * \fn void engine_progreso(int, int)
+      *  \brief Función responsable de actualizar la barra de progreso con el avance del motor
+      *  \param valor    pasos completados
+      *  \param maximo   pasos totales
       * ***********************************************************************************************
       */
-    void fichero_leido(int, int, int, int);
+    void engine_progreso(int, int);
 
     /** ***********************************************************************************************
-      * \fn void cromosoma_leido(int)
-      *  \brief Función responsable de controlar la elctura e identificación de DMRs por cromosoma
-      *  \param chrom    cromosoma que se ha leído
+      * \fn void engine_error(QString)
+      *  \brief Función responsable de mostrar los errores informados por el motor
+      *  \param texto    descripción del error
       * ***********************************************************************************************
       */
-    void cromosoma_leido(int);
+    void engine_error(QString);
 
     /** ***********************************************************************************************
-      * \fn void refGen_worker_acabado(ulong)
-      *  \brief Función responsable de recibir el número de genes definidos para un cromosoma dato
-      *  \param ref_genes   número de genes
+      * \fn void engine_terminado(bool)
+      *  \brief Función responsable de informar del final del proceso y habilitar los controles
+      *  \param completo false si el proceso ha sido abortado
       * ***********************************************************************************************
       */
-    void refGen_worker_acabado(ulong);
+    void engine_terminado(bool);
 
     /** ***********************************************************************************************
       * \fn void on_genome_reference_currentIndexChanged(int index)
@@ -220,25 +154,16 @@ private slots:
 private:
     Ui::HPG_Dhunter *ui;
 
-    // control de tiempos de ejecución por bloques
-    chrono::system_clock::time_point start_1;
-    chrono::system_clock::time_point start_2;
-    chrono::system_clock::time_point start_3;
-
     /** ***********************************************************************************************
       *  \brief variables responsables de capturar nombre del ficheros a analizar
       *  \param fichero             string con nombre directorio seleccionado
       *  \param ficheros_case       stringlist con nombre de todos los directorios seleccionados como casos
       *  \param ficheros_control    stringlist con nombre de los directorios seleccionados como control
-      *  \param fichero_gff         string con nombre de fichero en formato gff
-      *  \param region_gff          contador de DMRs para numerar en fichero gff
       * ***********************************************************************************************
       */
     QString     fichero;
     QStringList ficheros_case;
     QStringList ficheros_control;
-    QString     fichero_gff;
-    uint        region_gff;
 
     /** ***********************************************************************************************
       *  \brief variables para control de datos de cromosoma y hardware
@@ -290,30 +215,6 @@ private:
     int   _dmr_dwt_level;
 
 
-    /** ***********************************************************************************************
-      *  \brief variables para control de posiciones extremas de fichero a analizar
-      *  \param limite_inferior posición menor metilada en fichero de datos
-      *  \param limite_superior posición mayor metilada en fichero de datos
-      * ***********************************************************************************************
-      */
-    uint limite_inferior;
-    uint limite_superior;
-
-
-    /** ***********************************************************************************************
-      *  \brief variables para búsqueda y muestra de DMRs
-      *  \param **dmr_diff      datos de diferencias
-      *  \param dmr_diff_cols   número de valores por vector con los que buscar DMRs por columna
-      *  \param num_genes       número de genes conocidos en el cromosoma analizado
-      *  \param dmrs            lista de todas las posiciones DMRs encontradas
-      * ***********************************************************************************************
-      */
-    float       *dmr_diff;
-    uint        dmr_diff_cols;
-    ulong       num_genes;
-    QStringList dmrs;
-
-
     /** ***********************************************************************************************
       *  \brief variables para control ventana de visualización de ficheros a analizar
       *  \param directorio  controla si se ha seleccionado el primer fichero para guardar path
@@ -324,73 +225,39 @@ private:
     QString path;
 
 
-    /** ***********************************************************************************************
-      *  \brief variables para control de datos por muestras y resultados de transformación en GPU
-      *  \param mc          matriz con datos de metilación, cobertura y conteo por muestra y posición
-      *  \param h_haar_C    matriz de recepción de resultados de transformación wavelet
-      *  \param posicion_metilada   acumulación de posiciones metiladas para validar DMR
-      * ***********************************************************************************************
-      */
-    vector<vector<vector<double>>> mc;
-    vector<vector<float>>         h_haar_C;
-    vector<vector<uint>>          posicion_metilada;
-
     /** ***********************************************************************************************
       *  \brief variables para control de directorios y parámetros a analizar
       *  \param lista_casos     listado de los directorios correspondientes a los casos a analizar
       *  \param lista_control   listado de los directorios correspondientes a los controles a analizar
-      *  \param parametros      listado de los parámetros con los que realizar el análisis
       *  \param lista_chroms    lista de los cromosomas a analizar por muestra
       * ***********************************************************************************************
       */
     QStringList lista_casos;
     QStringList lista_control;
-    QStringList parametros;
     QList<int>  lista_chroms;
 
     /** ***********************************************************************************************
-      *  \brief variables para control de procesos en hilos
-      *  \param hilo_files_worker   vector de hilos que albergan la función de lectura y procesamiento previo
-      *  \param files_worker        vector de funciones de lectura y procesamiento previo de ficheros
-      *  \param *hilo_refGen        hilo que alberga la función de lectura de genes por cromosoma
-      *  \param *refgen_worker      función de lectura de genes por cromosoma
+      *  \brief variables para control del motor de identificación de DMRs
+      *  \param *hilo_engine    hilo que alberga el motor mientras dura el proceso
+      *  \param *engine         motor de lectura, transformación e identificación de DMRs
       * ***********************************************************************************************
       */
-    QVector<QThread*>      hilo_files_worker;
-    QVector<Files_worker*> files_worker;
-    QThread               *hilo_refGen;
-    RefGen                *refGen_worker;
-
-    /** ***********************************************************************************************
-      * \fn void lectura_acabada()
-      *  \brief función responsable de la identificación de DMRs y guardado en disco de los resultados
-      * ***********************************************************************************************
-      */
-    void lectura_acabada();
-
-    /** ***********************************************************************************************
-      *  \brief variable de control de acceso a memoria compartida
-      *  \param mutex   control de acceso a memoria compartida por los hilos
-      * ***********************************************************************************************
-      */
-    QMutex mutex;
-
+    QThread    *hilo_engine;
+    Dmr_engine *engine;
 
     /** ***********************************************************************************************
-      * \fn void find_dmrs() and two more
-      *  \brief Funciones responsables de encontrar DMRs y guardar los resultados
+      * \fn dmr_config configuracion() const
+      *  \brief Función responsable de recoger en una configuración los parámetros de la interfaz
       * ***********************************************************************************************
       */
-    void find_dmrs();
-    void hallar_dmrs();
-    void save_dmr_list(int);
+    dmr_config configuracion() const;
 
     /** ***********************************************************************************************
-      *  \brief variable para control de evolución del programa por barra de progreso
-      *  \param contador    aumenta su valor conforme avanza la lectura y procesamiento.
+      * \fn void liberar_engine()
+      *  \brief Función responsable de esperar y borrar el motor y su hilo de un proceso anterior
       * ***********************************************************************************************
       */
-    int contador;
+    void liberar_engine();
 
     /** ***********************************************************************************************
       * \fn void enabling_wodgets (bool arg)
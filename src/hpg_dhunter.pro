@@ -28,15 +28,10 @@ DEFINES     += QT_DEPRECATED_WARNINGS
 
 
 SOURCES     += main.cpp \
-               hpg_dhunter.cpp \
-               files_worker.cpp \
-               refgen.cpp
+               hpg_dhunter.cpp
 
 HEADERS     += \
-               data_pack.h \
-               hpg_dhunter.h \
-               files_worker.h \
-               refgen.h
+               hpg_dhunter.h
 
 FORMS       += \
                hpg_dhunter.ui
@@ -48,94 +43,5 @@ CONFIG      += C++11
 DESTDIR      = $$system(pwd)
 OBJECTS_DIR  = $$DESTDIR/Obj
 
-#----------------------------------------------------------------------
-#-----------------------------cuda settings----------------------------
-#----------------------------------------------------------------------
-# cuda sources
-CUDA_SOURCES += haar_v10.cu
-
-# path to cuda sdk installation
-CUDA_DIR      = /usr/local/cuda
-
-# path to header and libs files
-INCLUDEPATH  += $$CUDA_DIR/include
-QMAKE_LIBDIR += $$CUDA_DIR/lib64
-
-# cuda architecture
-#CUDA_ARCH    = sm_35       # minimum compute capability (version) for dynamic parallelism feature support
-CUDA_ARCH     = sm_61       # compute capability of GTX 1080
-#CUDA_ARCH    = sm_50
-#CUDA_ARCH    = sm_52
-
-# libs used in the code
-LIBS         += -lcudart -lcuda -lcudadevrt
-
-# some nvcc compiler flags
-NVCCFLAGS     = --compiler-options \
-                -fno-strict-aliasing \
-                -std=c++11 \
-                -use_fast_math \
-                --ptxas-options=-v
-
-# prepare the extra compiler configuration
-CUDA_INC      = $$join(INCLUDEPATH,' -I','-I',' ')
-
-# prepare intermediate CUDA compiler  - - - - - - - - - - - - - - - - - - - - - - - -
-# this is neccesary because there are more than one __global__ functions
-# then it must be compiled with dynamic parallelism
-cudaIntr.input  = CUDA_SOURCES
-cudaIntr.output = ${OBJECTS_DIR}${QMAKE_FILE_BASE}.o
-
-# tweak arch according to your hws compute capability
-cudaIntr.commands = $$CUDA_DIR/bin/nvcc \
-                    -m64 \                  # type of machine
-                    -g \                    # debug mode for host code
-                    -G \                    # debug mode for device code
-                    -arch=$$CUDA_ARCH \     # device architecture for files of data
-                    -dc \                   # dynamic parallelism compiler
-                    $$NVCCFLAGS \
-                    $$CUDA_INC \
-                    $$LIBS \
-                    ${QMAKE_FILE_NAME} -o ${QMAKE_FILE_OUT}
-
-# set our variable out.
-# these obj files need to be used to create the link obj file
-# and used in our final gcc compilation
-cudaIntr.variable_out  = CUDA_OBJ
-cudaIntr.variable_out += OBJECTS
-cudaIntr.clean         = cudaIntrObj/*.o
-
-# tell Qt that we want add more stuff to the Makefile
-QMAKE_EXTRA_COMPILERS += cudaIntr
-
-# prepare the linking compiler step - - - - - - - - - - - - - - - - - - - - - - - - -
-cuda.input    = CUDA_OBJ
-cuda.output   = ${QMAKE_FILE_BASE}_link.o
-
-# Tweak arch according to your hws compute capability
-cuda.commands        = $$CUDA_DIR/bin/nvcc \
-                       -m64 \
-                       -g \
-                       -G \
-                       -arch=$$CUDA_ARCH \
-                       -dlink ${QMAKE_FILE_NAME} \
-                       -o ${QMAKE_FILE_OUT}
-
-cuda.dependency_type = TYPE_C
-
-cuda.depend_command  = $$CUDA_DIR/bin/nvcc \
-                       -g \
-                       -G \
-                       -M \                     # link the previous object with main exec
-                       $$CUDA_INC \
-                       $$NVCCFLAGS \
-                       ${QMAKE_FILE_NAME}
-
-# tell Qt that we want add more stuff to the Makefile
-QMAKE_EXTRA_COMPILERS += cuda
-
-DISTFILES += \
-    haar_v10.cu
-
-RESOURCES += \
-    recursos.qrc
+# motor de identificación de DMRs (lectura, transformada en GPU y salida csv / gff)
+include(engine.pri)
@@ -0,0 +1,163 @@
+#include "indice_posiciones.h"
+#include "telemetria.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <sstream>
+
+// cabecera del fichero de índice: identificador y versión del formato
+static const quint32 IDENTIFICADOR = 0x48504749;    // "HPGI"
+static const quint32 VERSION       = 1;
+
+// ************************************************************************************************
+Indice_posiciones::Indice_posiciones()
+{
+    inicio     = 0;
+    final      = 0;
+    tamanyo    = 0;
+    modificado = 0;
+}
+
+// ************************************************************************************************
+uint Indice_posiciones::posicion(const QByteArray &linea)
+{
+    stringstream campos(linea.toStdString());
+    string       numero;
+    while (getline(campos, numero, ' '))
+        if (isdigit(numero[0]))
+            return uint(stoul(numero));
+
+    return 0;
+}
+
+// ************************************************************************************************
+bool Indice_posiciones::cargar(const QString &fichero, Indice_posiciones &indice)
+{
+    QFileInfo info(fichero);
+    QFile     data(fichero + ".idx");
+    if (!info.exists() || !data.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream s(&data);
+    quint32 identificador, version, n;
+    qint64  tamanyo, modificado;
+    s >> identificador >> version >> tamanyo >> modificado;
+
+    // un índice de otra versión o de un fichero modificado después se vuelve a construir
+    if (s.status() != QDataStream::Ok || identificador != IDENTIFICADOR || version != VERSION ||
+        tamanyo != info.size() || modificado != info.lastModified().toMSecsSinceEpoch())
+        return false;
+
+    Indice_posiciones leido;
+    leido.tamanyo    = tamanyo;
+    leido.modificado = modificado;
+    s >> leido.inicio >> leido.final >> n;
+    leido.marcas.resize(n);
+    for (marca &m : leido.marcas)
+        s >> m.posicion >> m.desplazamiento;
+
+    if (s.status() != QDataStream::Ok)
+        return false;
+
+    indice = leido;
+    return true;
+}
+
+// ************************************************************************************************
+bool Indice_posiciones::abrir(const QString &fichero, Indice_posiciones &indice)
+{
+    if (cargar(fichero, indice))
+        return true;
+
+    if (!indice.construir(fichero))
+        return false;
+
+    // sin permiso de escritura en el directorio de la muestra se vuelve a construir en cada ejecución
+    if (!indice.guardar(fichero))
+        qDebug() << "index of" << fichero << "not saved, it stays in memory";
+
+    return true;
+}
+
+// ************************************************************************************************
+bool Indice_posiciones::construir(const QString &fichero)
+{
+    QFile data(fichero);
+    if (!data.open(QIODevice::ReadOnly))
+        return false;
+
+    Telemetria::Medida medida("index", -1, -1, fichero.section("/methylation_map_", 0, 0));
+
+    QFileInfo info(fichero);
+    tamanyo    = info.size();
+    modificado = info.lastModified().toMSecsSinceEpoch();
+    inicio     = 0;
+    final      = 0;
+    marcas.clear();
+
+    // cada marca se abre al principio de la primera línea tras BYTES_POR_MARCA bytes y toma la
+    // posición del primer registro válido desde ese punto
+    qint64 siguiente = 0;
+    qint64 desde     = 0;
+    bool   abierta   = false;
+    while (!data.atEnd())
+    {
+        qint64     d     = data.pos();
+        QByteArray linea = data.readLine();
+
+        if (!abierta && d >= siguiente)
+        {
+            abierta   = true;
+            desde     = d;
+            siguiente = d + BYTES_POR_MARCA;
+        }
+
+        uint p = posicion(linea);
+        if (p == 0)
+            continue;
+
+        if (abierta)
+        {
+            marcas.push_back({p, desde});
+            abierta = false;
+        }
+        if (inicio == 0)
+            inicio = p;
+        final = p;
+    }
+
+    medida.bytes(tamanyo);
+    medida.sitios(qint64(marcas.size()));
+
+    return true;
+}
+
+// ************************************************************************************************
+bool Indice_posiciones::guardar(const QString &fichero) const
+{
+    QSaveFile data(fichero + ".idx");
+    if (!data.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream s(&data);
+    s << IDENTIFICADOR << VERSION << tamanyo << modificado << inicio << final << quint32(marcas.size());
+    for (const marca &m : marcas)
+        s << m.posicion << m.desplazamiento;
+
+    return s.status() == QDataStream::Ok && data.commit();
+}
+
+// ************************************************************************************************
+qint64 Indice_posiciones::desplazamiento(uint posicion) const
+{
+    // última marca con posición menor: todos los registros anteriores a ella tienen posiciones
+    // menores o iguales que la suya, el fichero está ordenado
+    auto m = lower_bound(marcas.begin(), marcas.end(), posicion,
+                         [](const marca &a, uint p) { return a.posicion < p; });
+
+    return m == marcas.begin() ? 0 : (m - 1)->desplazamiento;
+}
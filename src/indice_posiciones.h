@@ -0,0 +1,103 @@
+#ifndef INDICE_POSICIONES_H
+#define INDICE_POSICIONES_H
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Índice de posiciones de un fichero de metilación de un cromosoma, ordenado por posición,
+ *        para leer sólo los bytes de unos tramos de posiciones.
+ *
+ *        Guarda una marca cada BYTES_POR_MARCA bytes del fichero con la posición del primer
+ *        registro desde ese punto y su desplazamiento en bytes, además de la primera y la última
+ *        posición del fichero. Ocupa unos KiB por GB de fichero.
+ *
+ *        Se construye recorriendo el fichero una vez y se guarda al lado, como <fichero>.idx, junto
+ *        con el tamaño y la fecha del fichero para descartarlo si el fichero cambia. Si no se puede
+ *        escribir en el directorio de la muestra el índice sólo vive en memoria.
+ */
+class Indice_posiciones
+{
+public:
+    /**
+     * @brief bytes del fichero entre dos marcas
+     */
+    static const qint64 BYTES_POR_MARCA = 64 * 1024;
+
+    Indice_posiciones();
+
+    /**
+     * @fn static bool cargar(const QString &, Indice_posiciones &)
+     * @brief Lee el índice guardado de un fichero, sin construirlo
+     * @return          false si no hay índice o no corresponde al fichero actual
+     */
+    static bool cargar(const QString &fichero, Indice_posiciones &indice);
+
+    /**
+     * @fn static bool abrir(const QString &, Indice_posiciones &)
+     * @brief Lee el índice guardado de un fichero o, si no lo hay, lo construye y lo guarda
+     * @return          false si no se puede leer el fichero
+     */
+    static bool abrir(const QString &fichero, Indice_posiciones &indice);
+
+    /**
+     * @fn static uint posicion(const QByteArray &)
+     * @brief Posición del registro de una línea del fichero, 0 si la línea no tiene registro válido
+     */
+    static uint posicion(const QByteArray &linea);
+
+    /**
+     * @fn qint64 desplazamiento(uint) const
+     * @brief Byte desde el que se leen todos los registros con posición igual o mayor que una dada,
+     *        siempre al principio de una línea
+     */
+    qint64 desplazamiento(uint posicion) const;
+
+    /**
+     * @fn uint primera() const
+     * @brief Primera posición con registro del fichero, 0 si no tiene registros
+     */
+    uint primera() const { return inicio; }
+
+    /**
+     * @fn uint ultima() const
+     * @brief Última posición con registro del fichero, 0 si no tiene registros
+     */
+    uint ultima() const  { return final; }
+
+private:
+    /**
+     * @brief marca del índice
+     * @param posicion          posición del primer registro a partir del desplazamiento
+     * @param desplazamiento    principio de línea en el fichero
+     */
+    struct marca
+    {
+        uint   posicion;
+        qint64 desplazamiento;
+    };
+
+    /**
+     * @fn bool construir(const QString &)
+     * @brief Recorre el fichero para crear las marcas
+     */
+    bool construir(const QString &fichero);
+
+    /**
+     * @fn bool guardar(const QString &) const
+     * @brief Guarda el índice al lado del fichero
+     */
+    bool guardar(const QString &fichero) const;
+
+    vector<marca> marcas;
+    uint          inicio;
+    uint          final;
+    qint64        tamanyo;
+    qint64        modificado;
+};
+
+#endif // INDICE_POSICIONES_H
@@ -0,0 +1,115 @@
+#include "planificador.h"
+#include "contigs.h"
+#include "dmr_engine.h"
+#include "files_worker.h"
+#include <QFileInfo>
+#include <QSet>
+#include <algorithm>
+
+// ************************************************************************************************
+qint64 Planificador::coste(const QList<dmr_config> &trabajos, int chrom)
+{
+    // cada fichero cuenta una vez aunque lo compartan varios trabajos
+    QSet<QString> ficheros;
+    foreach (const dmr_config &config, trabajos)
+    {
+        if (!config.lista_chroms.contains(chrom))
+            continue;
+
+        foreach (const QString &d, config.lista_casos + config.lista_control)
+            ficheros << Files_worker::fichero_muestra(d, config.forward, config.reverse, Contigs::nombre(chrom));
+    }
+
+    qint64 bytes = 0;
+    foreach (const QString &f, ficheros)
+        bytes += QFileInfo(f).size();
+
+    return bytes;
+}
+
+// ************************************************************************************************
+QList<int> Planificador::orden(const QList<dmr_config> &trabajos)
+{
+    QList<int>        chroms = Dmr_engine::orden_cromosomas(trabajos);
+    QMap<int, qint64> costes;
+    foreach (int chrom, chroms)
+        costes[chrom] = coste(trabajos, chrom);
+
+    std::stable_sort(chroms.begin(), chroms.end(), [&costes](int a, int b) {
+        return costes[a] > costes[b];
+    });
+
+    return chroms;
+}
+
+// ************************************************************************************************
+QList<QList<int>> Planificador::lotes(const QList<dmr_config> &trabajos, int procesos)
+{
+    QList<int>        chroms = orden(trabajos);
+    QMap<int, qint64> costes;
+    qint64            total  = 0;
+    foreach (int chrom, chroms)
+    {
+        costes[chrom] = coste(trabajos, chrom);
+        total        += costes[chrom];
+    }
+
+    // coste por debajo del cual un cromosoma se agrupa con otros
+    qint64 umbral = total / (qMax(procesos, 1) * LOTES_POR_PROCESO);
+
+    QList<QList<int>> lista;
+    QList<qint64>     costes_lote;
+    QList<bool>       agrupable;
+    foreach (int chrom, chroms)
+    {
+        int l = lista.size();
+        if (costes[chrom] < umbral)
+            for (l = 0; l < lista.size(); l++)
+                if (agrupable.at(l) && costes_lote.at(l) + costes[chrom] <= umbral)
+                    break;
+
+        if (l == lista.size())
+        {
+            lista << QList<int>();
+            costes_lote << 0;
+            agrupable << (costes[chrom] < umbral);
+        }
+        lista[l] << chrom;
+        costes_lote[l] += costes[chrom];
+    }
+
+    // del lote más costoso al menos, los cromosomas solos ya vienen ordenados
+    QList<int> indices;
+    for (int l = 0; l < lista.size(); l++)
+        indices << l;
+    std::stable_sort(indices.begin(), indices.end(), [&costes_lote](int a, int b) {
+        return costes_lote.at(a) > costes_lote.at(b);
+    });
+
+    QList<QList<int>> ordenados;
+    foreach (int l, indices)
+        ordenados << lista.at(l);
+
+    return ordenados;
+}
+
+// ************************************************************************************************
+qint64 Planificador::memoria(const QList<dmr_config> &trabajos, const QList<int> &lote)
+{
+    // los cromosomas de un lote se analizan uno tras otro y liberan sus registros al acabar
+    // ..las matrices de datos y de coeficientes tienen una fila por muestra del trabajo con más
+    // muestras del cromosoma
+    qint64 maximo = 0;
+    foreach (int chrom, lote)
+    {
+        qint64 muestras = 0;
+        foreach (const dmr_config &config, trabajos)
+            if (config.lista_chroms.contains(chrom))
+                muestras = qMax(muestras, qint64(config.lista_casos.size() + config.lista_control.size()));
+
+        maximo = qMax(maximo, FACTOR_MEMORIA * coste(trabajos, chrom) +
+                              2 * muestras * Contigs::longitud(chrom) * qint64(sizeof(float)));
+    }
+
+    return maximo;
+}
@@ -0,0 +1,76 @@
+#ifndef PLANIFICADOR_H
+#define PLANIFICADOR_H
+
+#include <QList>
+#include <QtGlobal>
+#include "dmr_config.h"
+#include "registros_muestra.h"
+
+/**
+ * @brief Orden y reparto de los cromosomas de una ejecución según su coste estimado.
+ *
+ *        El coste de un cromosoma son los bytes de los ficheros de las muestras que hay que leer
+ *        para él, contando una vez cada fichero aunque lo usen varios trabajos: la lectura, la
+ *        transformada y la búsqueda crecen con el número de registros. Se obtiene del tamaño de los
+ *        ficheros, sin leerlos.
+ *
+ *        Los cromosomas se procesan del más costoso al menos. Al repartirlos entre procesos, los
+ *        contigs pequeños se agrupan en lotes que se procesan seguidos en un mismo proceso, para que
+ *        cientos de scaffolds no lancen cientos de procesos, y los lotes se lanzan del mayor al menor
+ *        (LPT), lo que deja los trabajos cortos para el final y acorta el tiempo total.
+ */
+class Planificador
+{
+public:
+    /**
+     * @brief lotes por proceso que se buscan al agrupar contigs pequeños
+     */
+    static const int LOTES_POR_PROCESO = 4;
+
+    /**
+     * @brief bytes de una línea de un fichero de muestra, de media: posición y seis cuentas
+     *        separadas por espacios
+     */
+    static const int BYTES_POR_LINEA = 22;
+
+    /**
+     * @brief bytes de registros en memoria por byte de fichero de texto leído, redondeado hacia
+     *        arriba: cada línea pasa a un registro de Registros_muestra::CAMPOS doubles, 104 bytes
+     *        por unos 22 de texto, 5
+     */
+    static const int FACTOR_MEMORIA = (Registros_muestra::CAMPOS * int(sizeof(double)) + BYTES_POR_LINEA - 1) /
+                                      BYTES_POR_LINEA;
+
+    /**
+     * @fn static qint64 coste(const QList<dmr_config> &, int)
+     * @brief Bytes de los ficheros de las muestras de un cromosoma para todos los trabajos
+     */
+    static qint64 coste(const QList<dmr_config> &trabajos, int chrom);
+
+    /**
+     * @fn static QList<int> orden(const QList<dmr_config> &)
+     * @brief Cromosomas de todos los trabajos del más costoso al menos; a igual coste, en el orden
+     *        en que aparecen
+     */
+    static QList<int> orden(const QList<dmr_config> &trabajos);
+
+    /**
+     * @fn static QList<QList<int>> lotes(const QList<dmr_config> &, int)
+     * @brief Reparte los cromosomas en lotes para varios procesos, del lote más costoso al menos
+     *
+     *        Un cromosoma con al menos 1 / (procesos * LOTES_POR_PROCESO) del coste total va solo; el
+     *        resto se agrupa, de mayor a menor, en el primer lote de pequeños donde no supera ese coste.
+     */
+    static QList<QList<int>> lotes(const QList<dmr_config> &trabajos, int procesos);
+
+    /**
+     * @fn static qint64 memoria(const QList<dmr_config> &, const QList<int> &)
+     * @brief Estimación de la memoria en bytes de un proceso que analiza un lote: la del cromosoma
+     *        que más necesita, con sus registros y, si su longitud se conoce por un .fai, la matriz
+     *        de datos y la de coeficientes, con una fila por muestra del trabajo con más muestras y
+     *        una columna por posición
+     */
+    static qint64 memoria(const QList<dmr_config> &trabajos, const QList<int> &lote);
+};
+
+#endif // PLANIFICADOR_H
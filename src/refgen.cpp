@@ -1,4 +1,5 @@
 #include "refgen.h"
+#include "telemetria.h"
 
 #include <QFile>
 #include <QDebug>
@@ -36,6 +37,8 @@ void RefGen::lectura()
 {
     // carga la matriz de referencias genómicas por posición correspondiente al cromosoma elegido
     // --------------------------------------------------------------------------------------------
+    Telemetria::Medida medida("references", chrom);
+
     vector<string> auxRef1;
     vector<vector<string>> auxRef2;
     QFile refGene;
@@ -61,6 +64,8 @@ void RefGen::lectura()
         auxRef2.push_back(auxRef1);
         auxRef1.clear();
     }
+    medida.bytes(refGene.size());
+    medida.sitios(qint64(auxRef2.size()));
     refGene.close();
 
     // reserva de memoria de la matriz
@@ -0,0 +1,90 @@
+#include "regiones_objetivo.h"
+#include "contigs.h"
+#include <QFile>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+
+// ************************************************************************************************
+// número de cromosoma de un nombre de BED, 0 si no es uno de los cromosomas analizados
+static int numero_cromosoma(QString nombre)
+{
+    if (nombre.startsWith("chr", Qt::CaseInsensitive))
+        nombre = nombre.mid(3);
+
+    if (nombre.compare("X", Qt::CaseInsensitive) == 0)
+        return 23;
+    if (nombre.compare("Y", Qt::CaseInsensitive) == 0)
+        return 24;
+
+    int n = nombre.toInt();
+    return (n > 0 && n < 25) ? n : 0;
+}
+
+// ************************************************************************************************
+bool Regiones_objetivo::leer(const QString &fichero, Regiones_objetivo &regiones, QString &error)
+{
+    QFile data(fichero);
+    if (!data.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        error = "regions file not found: " + fichero;
+        return false;
+    }
+
+    QMap<int, vector<pair<uint, uint>>> tramos;
+    QTextStream s(&data);
+    for (int numero = 1; !s.atEnd(); numero++)
+    {
+        QString linea = s.readLine().trimmed();
+        if (linea.isEmpty() || linea.startsWith('#') || linea.startsWith("track") || linea.startsWith("browser"))
+            continue;
+
+        QStringList campos = linea.split(QRegularExpression("\\s+"));
+        bool ok_inicio = false;
+        bool ok_fin    = false;
+        uint inicio    = campos.value(1).toUInt(&ok_inicio);
+        uint fin       = campos.value(2).toUInt(&ok_fin);
+        if (!ok_inicio || !ok_fin || fin < inicio)
+        {
+            error = "invalid line " + QString::number(numero) + " in regions file " + fichero;
+            return false;
+        }
+
+        // un contig ya conocido por su nombre exacto en los ficheros, o uno de los cromosomas numerados
+        int chrom = Contigs::buscar(campos.at(0));
+        if (chrom == 0)
+            chrom = numero_cromosoma(campos.at(0));
+        if (chrom > 0 && fin > inicio)
+            tramos[chrom].push_back(make_pair(inicio, fin));
+    }
+
+    // ordena y une las regiones que se solapan o se tocan
+    for (auto c = tramos.begin(); c != tramos.end(); ++c)
+    {
+        vector<pair<uint, uint>> &t = c.value();
+        sort(t.begin(), t.end());
+
+        size_t n = 0;
+        for (size_t i = 1; i < t.size(); i++)
+        {
+            if (t[i].first <= t[n].second)
+                t[n].second = max(t[n].second, t[i].second);
+            else
+                t[++n] = t[i];
+        }
+        t.resize(t.empty() ? 0 : n + 1);
+    }
+
+    regiones.tramos = tramos;
+    return true;
+}
+
+// ************************************************************************************************
+const vector<pair<uint, uint>> &Regiones_objetivo::cromosoma(int chrom) const
+{
+    static const vector<pair<uint, uint>> ninguno;
+
+    auto c = tramos.constFind(chrom);
+    return c == tramos.constEnd() ? ninguno : c.value();
+}
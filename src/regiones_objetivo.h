@@ -0,0 +1,47 @@
+#ifndef REGIONES_OBJETIVO_H
+#define REGIONES_OBJETIVO_H
+
+#include <QMap>
+#include <QString>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Regiones objetivo de un análisis (promotores, un panel de captura) leídas de un fichero BED.
+ *
+ *        Cada región es un tramo [inicio, fin) con las coordenadas del BED, que se comparan tal
+ *        cual con las posiciones de los ficheros de metilación. Un nombre de contig conocido por
+ *        Contigs es ese contig; si no, chr1..chr22, chrX y chrY (con o sin el prefijo chr) son los
+ *        cromosomas 1 a 24 y el resto de contigs se ignora.
+ *        Por cromosoma, las regiones quedan ordenadas y unidas cuando se solapan o se tocan.
+ */
+class Regiones_objetivo
+{
+public:
+    /**
+     * @fn static bool leer(const QString &, Regiones_objetivo &, QString &)
+     * @brief Lee un fichero BED: cromosoma, inicio y fin separados por tabuladores o espacios,
+     *        ignorando líneas vacías, comentarios y líneas track o browser
+     * @return          false si el fichero no se puede leer o alguna línea no es válida
+     */
+    static bool leer(const QString &fichero, Regiones_objetivo &regiones, QString &error);
+
+    /**
+     * @fn const vector<pair<uint, uint>> &cromosoma(int) const
+     * @brief Regiones de un cromosoma, vacío si no tiene
+     */
+    const vector<pair<uint, uint>> &cromosoma(int chrom) const;
+
+    /**
+     * @fn bool empty() const
+     * @brief true si ningún cromosoma tiene regiones
+     */
+    bool empty() const { return tramos.isEmpty(); }
+
+private:
+    QMap<int, vector<pair<uint, uint>>> tramos;
+};
+
+#endif // REGIONES_OBJETIVO_H
@@ -0,0 +1,100 @@
+#include "registros_muestra.h"
+#include <QDir>
+#include <QTemporaryFile>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// ************************************************************************************************
+Registros_muestra::almacen::almacen()
+{
+    fichero = nullptr;
+    mapa    = nullptr;
+}
+
+// ************************************************************************************************
+Registros_muestra::almacen::~almacen()
+{
+    // cerrar el fichero temporal deshace la proyección y lo borra
+    delete fichero;
+}
+
+// ************************************************************************************************
+Registros_muestra::Registros_muestra()
+{
+    inicio = nullptr;
+    n      = 0;
+}
+
+// ************************************************************************************************
+Registros_muestra::Registros_muestra(vector<double> &&datosx)
+{
+    datos = make_shared<almacen>();
+    datos->ram.swap(datosx);
+    inicio = datos->ram.data();
+    n      = datos->ram.size() / CAMPOS;
+}
+
+// ************************************************************************************************
+bool Registros_muestra::volcar(const QString &directorio, QString &error)
+{
+    if (n == 0 || datos->fichero != nullptr)
+        return true;
+
+    qint64 bytes = qint64(datos->ram.size() * sizeof(double));
+
+    QTemporaryFile *fichero = new QTemporaryFile(QDir(directorio).filePath("hpg_dhunter_XXXXXX.mc"));
+    if (!fichero->open() ||
+        fichero->write(reinterpret_cast<const char *>(datos->ram.data()), bytes) != bytes ||
+        !fichero->flush())
+    {
+        error = "An error occurred writing the scratch file in " + directorio + ": " + fichero->errorString();
+        delete fichero;
+        return false;
+    }
+
+    uchar *mapa = fichero->map(0, bytes);
+    if (mapa == nullptr)
+    {
+        error = "An error occurred mapping the scratch file in " + directorio + ": " + fichero->errorString();
+        delete fichero;
+        return false;
+    }
+
+#ifdef __linux__
+    // las etapas recorren los registros en orden, la lectura anticipada del sistema lo aprovecha
+    madvise(mapa, size_t(bytes), MADV_SEQUENTIAL);
+#endif
+
+    datos->fichero = fichero;
+    datos->mapa    = mapa;
+    vector<double>().swap(datos->ram);
+    inicio = reinterpret_cast<const double *>(mapa);
+
+    return true;
+}
+
+// ************************************************************************************************
+void Registros_muestra::soltar() const
+{
+#ifdef __linux__
+    // las páginas del fichero se vuelven a leer de disco si se necesitan de nuevo
+    if (n > 0 && datos->mapa != nullptr)
+        madvise(datos->mapa, n * CAMPOS * sizeof(double), MADV_DONTNEED);
+#endif
+}
+
+// ************************************************************************************************
+qint64 Registros_muestra::memoria() const
+{
+    return (n > 0 && datos->mapa == nullptr) ? qint64(n * CAMPOS * sizeof(double)) : 0;
+}
+
+// ************************************************************************************************
+void Registros_muestra::swap(Registros_muestra &otros)
+{
+    datos.swap(otros.datos);
+    std::swap(inicio, otros.inicio);
+    std::swap(n, otros.n);
+}
@@ -0,0 +1,117 @@
+#ifndef REGISTROS_MUESTRA_H
+#define REGISTROS_MUESTRA_H
+
+#include <QString>
+#include <QtGlobal>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+class QTemporaryFile;
+
+/**
+ * @brief Registros leídos de un cromosoma de una muestra, contiguos y de sólo lectura.
+ *
+ *        Cada registro son CAMPOS valores con el formato de mc (posición, proporción y cobertura de
+ *        mC, conteos, proporción y cobertura de hmC, cromosoma, muestra, grupo y cadena) y se lee
+ *        con la misma sintaxis que un vector de vectores, registros[k][campo].
+ *
+ *        Los registros están en memoria o, fuera de memoria, en un fichero temporal del disco de
+ *        trabajo proyectado en memoria: el sistema sólo mantiene en RAM las páginas que se están
+ *        recorriendo y las descarta sin escribirlas cuando necesita la memoria. Las copias comparten
+ *        los mismos datos.
+ */
+class Registros_muestra
+{
+public:
+    /**
+     * @brief valores por registro
+     */
+    static const int CAMPOS = 13;
+
+    Registros_muestra();
+
+    /**
+     * @fn Registros_muestra(vector<double> &&)
+     * @brief Toma los registros de un vector de size() * CAMPOS valores, sin copiarlos
+     */
+    explicit Registros_muestra(vector<double> &&datos);
+
+    /**
+     * @fn bool volcar(const QString &, QString &)
+     * @brief Pasa los registros a un fichero temporal en un directorio y libera su memoria, antes
+     *        de hacer copias
+     * @param directorio    disco de trabajo local
+     * @param error         descripción del error
+     * @return              false si no se puede escribir el fichero, los registros siguen en memoria
+     */
+    bool volcar(const QString &directorio, QString &error);
+
+    /**
+     * @fn void soltar() const
+     * @brief Tras recorrer unos registros volcados, devuelve al sistema sus páginas en memoria
+     */
+    void soltar() const;
+
+    /**
+     * @fn qint64 memoria() const
+     * @brief Bytes que ocupan los registros en memoria, 0 si están volcados
+     */
+    qint64 memoria() const;
+
+    /**
+     * @fn size_t size() const
+     * @brief Número de registros
+     */
+    size_t        size() const                   { return n; }
+
+    /**
+     * @fn bool empty() const
+     * @brief true si no hay registros
+     */
+    bool          empty() const                  { return n == 0; }
+
+    /**
+     * @fn const double *operator[](size_t) const
+     * @brief Campos del registro k, como la fila de un vector de vectores
+     */
+    const double *operator[](size_t k) const     { return inicio + k * CAMPOS; }
+
+    /**
+     * @fn const double *front() const
+     * @brief Campos del primer registro
+     */
+    const double *front() const                  { return inicio; }
+
+    /**
+     * @fn const double *back() const
+     * @brief Campos del último registro
+     */
+    const double *back() const                   { return inicio + (n - 1) * CAMPOS; }
+
+    void swap(Registros_muestra &otros);
+
+private:
+    /**
+     * @brief datos compartidos por todas las copias
+     * @param ram       registros en memoria
+     * @param fichero   fichero temporal con los registros volcados, nullptr en memoria
+     * @param mapa      proyección del fichero en memoria
+     */
+    struct almacen
+    {
+        vector<double>  ram;
+        QTemporaryFile *fichero;
+        uchar          *mapa;
+
+        almacen();
+        ~almacen();
+    };
+
+    shared_ptr<almacen>  datos;
+    const double        *inicio;
+    size_t               n;
+};
+
+#endif // REGISTROS_MUESTRA_H
@@ -0,0 +1,492 @@
+#include "run_file.h"
+#include "contigs.h"
+#include "dmr_engine.h"
+#include "regiones_objetivo.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QPair>
+#include <QRegularExpression>
+#include <QTextStream>
+
+// convierte un valor JSON (texto, número, lógico o lista) en la lista de textos de una opción
+static QStringList valores_json(const QJsonValue &valor)
+{
+    QStringList lista;
+
+    if (valor.isArray())
+        foreach (const QJsonValue &v, valor.toArray())
+            lista << valores_json(v);
+    else if (valor.isDouble())
+        lista << QString::number(valor.toDouble());
+    else if (valor.isBool())
+        lista << (valor.toBool() ? "true" : "false");
+    else
+        lista << valor.toString();
+
+    return lista;
+}
+
+// añade a un mapa de opciones las claves de un objeto JSON
+static void anyadir_json(const QJsonObject &objeto, QMap<QString, QStringList> &opciones)
+{
+    for (QJsonObject::const_iterator i = objeto.constBegin(); i != objeto.constEnd(); ++i)
+        opciones[i.key()] = valores_json(i.value());
+}
+
+// ************************************************************************************************
+QStringList Run_file::opciones()
+{
+    return QStringList() << "case" << "control" << "out" << "chroms" << "reference" << "signal" << "strand"
+                         << "mc-coverage" << "hmc-coverage" << "threshold" << "level" << "density" << "samples"
+                         << "regions" << "fai" << "stationary" << "refine" << "coarse-level"
+                         << "cpg-space" << "sample-sheet" << "contrasts"
+                         << "pairwise" << "pairwise-lists" << "permutations" << "beta-binomial";
+}
+
+// ************************************************************************************************
+bool Run_file::leer_entero(const QMap<QString, QStringList> &opciones, const QString &opcion,
+                           int minimo, int maximo, int &valor, QString &error)
+{
+    if (!opciones.contains(opcion))
+        return true;
+
+    bool ok;
+    int  v = opciones[opcion].join("").toInt(&ok);
+    if (!ok || v < minimo || v > maximo)
+    {
+        error = "invalid value for " + opcion + ": " + opciones[opcion].join(",") +
+                " (expected " + QString::number(minimo) + ".." + QString::number(maximo) + ")";
+        return false;
+    }
+
+    valor = v;
+    return true;
+}
+
+// ************************************************************************************************
+bool Run_file::leer_logico(const QMap<QString, QStringList> &opciones, const QString &opcion,
+                           bool &valor, QString &error)
+{
+    if (!opciones.contains(opcion))
+        return true;
+
+    QString v = opciones[opcion].join("").toLower();
+    if (v != "" && v != "true" && v != "false")
+    {
+        error = "invalid value for " + opcion + ": " + v + " (expected true or false)";
+        return false;
+    }
+
+    valor = v != "false";
+    return true;
+}
+
+// ************************************************************************************************
+bool Run_file::configurar(const QMap<QString, QStringList> &opciones, dmr_config &config, QString &error)
+{
+    foreach (const QString &clave, opciones.keys())
+        if (!Run_file::opciones().contains(clave))
+        {
+            error = "unknown option: " + clave;
+            return false;
+        }
+
+    // con una hoja de muestras los grupos y las muestras ya vienen de ella
+    if (opciones.contains("sample-sheet") && (opciones.contains("case") || opciones.contains("control")))
+    {
+        error = "sample-sheet cannot be combined with case or control";
+        return false;
+    }
+
+    if (opciones.contains("case"))
+        config.lista_casos   = opciones["case"];
+    if (opciones.contains("control"))
+        config.lista_control = opciones["control"];
+    if (opciones.contains("out"))
+        config.ruta_salida   = opciones["out"].join("");
+
+    if (config.lista_casos.isEmpty() || (config.lista_control.isEmpty() && config.grupos.isEmpty()) ||
+        config.ruta_salida.isEmpty())
+    {
+        error = "at least one case, one control (or a sample sheet) and the output folder are required";
+        return false;
+    }
+
+    if (!QDir(config.ruta_salida).exists())
+    {
+        error = "output folder does not exist: " + config.ruta_salida;
+        return false;
+    }
+
+    // genoma de referencia
+    if (opciones.contains("reference"))
+    {
+        QString reference = opciones["reference"].join("").toLower();
+        if (reference == "none")
+            config.genome_reference = 0;
+        else if (reference == "grch37")
+            config.genome_reference = 1;
+        else
+        {
+            error = "unknown reference: " + reference;
+            return false;
+        }
+    }
+
+    // señal a analizar
+    if (opciones.contains("signal"))
+    {
+        QString signal = opciones["signal"].join("").toLower();
+        config.mc  = signal == "mc"  || signal == "both";
+        config.hmc = signal == "hmc" || signal == "both";
+        if (!config.mc && !config.hmc)
+        {
+            error = "unknown signal: " + signal;
+            return false;
+        }
+    }
+
+    // cadenas a leer
+    if (opciones.contains("strand"))
+    {
+        QString strand = opciones["strand"].join("").toLower();
+        config.forward = strand == "forward" || strand == "both";
+        config.reverse = strand == "reverse" || strand == "both";
+        if (!config.forward && !config.reverse)
+        {
+            error = "unknown strand: " + strand;
+            return false;
+        }
+    }
+
+    // parámetros numéricos con los mismos rangos que los controles de la interfaz
+    if (!leer_entero(opciones, "mc-coverage",  1, 100000, config.mc_min_coverage,      error) ||
+        !leer_entero(opciones, "hmc-coverage", 1, 100000, config.hmc_min_coverage,     error) ||
+        !leer_entero(opciones, "threshold",    1, 99,     config.threshold,            error) ||
+        !leer_entero(opciones, "level",        1, 10,     config.dmr_dwt_level,        error) ||
+        !leer_entero(opciones, "density",      1, 50,     config.min_cpg_x_region,     error) ||
+        !leer_entero(opciones, "samples",      30, 100,   config.min_samples_x_region, error))
+        return false;
+
+    // transformada estacionaria, refinado de extremos y espacio de CpGs, como opciones sin valor en
+    // la línea de comandos
+    if (!leer_logico(opciones, "stationary", config.estacionaria, error) ||
+        !leer_logico(opciones, "refine",     config.refinar,      error) ||
+        !leer_logico(opciones, "cpg-space",  config.espacio_cpg,  error))
+        return false;
+    if (config.espacio_cpg && (config.estacionaria || opciones.contains("regions")))
+    {
+        error = "cpg-space cannot be combined with stationary or regions";
+        return false;
+    }
+
+    // comparación muestra a muestra, además de la de grupos
+    if (opciones.contains("pairwise"))
+    {
+        config.pares = opciones["pairwise"].join("").toLower();
+        if (config.pares != "all" && config.pares != "control")
+        {
+            error = "unknown pairwise mode: " + config.pares + " (expected all or control)";
+            return false;
+        }
+        if (opciones.contains("sample-sheet"))
+        {
+            error = "pairwise cannot be combined with sample-sheet";
+            return false;
+        }
+    }
+    if (!leer_logico(opciones, "pairwise-lists", config.listas_pares, error))
+        return false;
+    if (config.listas_pares && config.pares.isEmpty())
+    {
+        error = "pairwise-lists needs pairwise";
+        return false;
+    }
+
+    // p-valores empíricos de los DMRs por permutación de etiquetas
+    if (!leer_entero(opciones, "permutations", 10, 100000, config.permutaciones, error))
+        return false;
+
+    // p-valores de los DMRs con los reads de sus posiciones
+    if (!leer_logico(opciones, "beta-binomial", config.beta_binomial, error))
+        return false;
+
+    // búsqueda jerárquica desde un nivel más grueso que el del análisis
+    if (!leer_entero(opciones, "coarse-level", 2, 10, config.nivel_grueso, error))
+        return false;
+    if (config.nivel_grueso != 0 && config.nivel_grueso <= config.dmr_dwt_level)
+    {
+        error = "coarse-level must be greater than level (" + QString::number(config.dmr_dwt_level) + ")";
+        return false;
+    }
+    if (config.nivel_grueso != 0 && (config.estacionaria || opciones.contains("regions")))
+    {
+        error = "coarse-level cannot be combined with stationary or regions";
+        return false;
+    }
+
+    // regiones objetivo, se comprueba que el fichero BED es válido antes de empezar
+    if (opciones.contains("regions"))
+    {
+        Regiones_objetivo regiones;
+        config.fichero_regiones = opciones["regions"].join("");
+        if (!Regiones_objetivo::leer(config.fichero_regiones, regiones, error))
+            return false;
+    }
+
+    // contigs y longitudes de un índice .fai
+    QList<int> contigs_fai;
+    if (opciones.contains("fai") && !Contigs::leer_fai(opciones["fai"].join(""), contigs_fai, error))
+        return false;
+
+    // lista de cromosomas, 'all' son los contigs del .fai, los 24 cromosomas del genoma de
+    // referencia o, sin ninguno de los dos, los contigs con fichero en todas las muestras
+    QString chroms = opciones.contains("chroms") ? opciones["chroms"].join(",") : "all";
+    if (chroms.toLower() == "all")
+    {
+        if (!contigs_fai.isEmpty())
+            config.lista_chroms = contigs_fai;
+        else if (config.genome_reference == 1)
+            config.lista_chroms = {1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24};
+        else
+            config.lista_chroms = Contigs::descubrir(config.lista_casos + config.lista_control,
+                                                     config.forward, config.reverse);
+    }
+    else
+        config.lista_chroms = Dmr_engine::lista_cromosomas(chroms);
+
+    if (config.lista_chroms.isEmpty())
+    {
+        error = "the chromosome list to analyze is empty";
+        return false;
+    }
+
+    return true;
+}
+
+// ************************************************************************************************
+bool Run_file::leer_hoja(const QString &fichero, QStringList &muestras, QStringList &etiquetas, QString &error)
+{
+    QFile data(fichero);
+    if (!data.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        error = "sample sheet not found: " + fichero;
+        return false;
+    }
+
+    // directorio y grupo por línea, separados por un tabulador o, sin él, por espacios
+    // ..los directorios relativos lo son a la hoja
+    QDir       base = QFileInfo(fichero).absoluteDir();
+    QTextStream s(&data);
+    muestras.clear();
+    etiquetas.clear();
+    for (int linea = 1; !s.atEnd(); linea++)
+    {
+        QString texto = s.readLine().trimmed();
+        if (texto.isEmpty() || texto.startsWith('#'))
+            continue;
+
+        QStringList campos = texto.contains('\t') ? texto.split('\t') : texto.split(QRegularExpression("\\s+"));
+        if (campos.size() != 2 || campos.at(0).trimmed().isEmpty() || campos.at(1).trimmed().isEmpty())
+        {
+            error = "invalid line " + QString::number(linea) + " in sample sheet " + fichero +
+                    " (expected folder and group)";
+            return false;
+        }
+
+        muestras  << QDir::cleanPath(base.absoluteFilePath(campos.at(0).trimmed()));
+        etiquetas << campos.at(1).trimmed();
+    }
+
+    if (muestras.isEmpty())
+    {
+        error = "the sample sheet is empty: " + fichero;
+        return false;
+    }
+
+    return true;
+}
+
+// ************************************************************************************************
+bool Run_file::configurar_trabajos(const QMap<QString, QStringList> &opciones, QList<dmr_config> &trabajos,
+                                   QString &error)
+{
+    dmr_config config;
+    if (!opciones.contains("sample-sheet"))
+    {
+        if (opciones.contains("contrasts"))
+        {
+            error = "contrasts needs a sample-sheet";
+            return false;
+        }
+        if (!configurar(opciones, config, error))
+            return false;
+
+        trabajos << config;
+        return true;
+    }
+
+    // muestras de la hoja ordenadas por grupo, cada grupo en el orden en que aparece
+    QStringList muestras, etiquetas;
+    if (!leer_hoja(opciones["sample-sheet"].join(""), muestras, etiquetas, error))
+        return false;
+
+    QStringList nombres;
+    foreach (const QString &e, etiquetas)
+        if (!nombres.contains(e))
+            nombres << e;
+    if (nombres.size() < 2)
+    {
+        error = "the sample sheet needs at least two groups";
+        return false;
+    }
+
+    QList<QStringList> grupos;
+    for (int g = 0; g < nombres.size(); g++)
+    {
+        grupos << QStringList();
+        for (int i = 0; i < muestras.size(); i++)
+            if (etiquetas.at(i) == nombres.at(g))
+            {
+                grupos[g] << muestras.at(i);
+                config.lista_casos << muestras.at(i);
+                config.grupos << g;
+            }
+    }
+    config.cohorte = config.lista_casos;
+
+    if (!configurar(opciones, config, error))
+        return false;
+
+    // contrastes pedidos: pares A:B, all (todos los pares, por defecto) y any (algún grupo difiere)
+    QList<QPair<int, int>> pares;
+    bool                   cualquiera = false;
+    QStringList contrastes = opciones.contains("contrasts") ? opciones["contrasts"].join(",").split(',')
+                                                            : QStringList("all");
+    foreach (const QString &c, contrastes)
+    {
+        QString contraste = c.trimmed();
+        if (contraste.isEmpty())
+            continue;
+
+        if (contraste.toLower() == "any")
+            cualquiera = true;
+        else if (contraste.toLower() == "all")
+        {
+            for (int a = 0; a < nombres.size(); a++)
+                for (int b = a + 1; b < nombres.size(); b++)
+                    if (!pares.contains(qMakePair(a, b)))
+                        pares << qMakePair(a, b);
+        }
+        else
+        {
+            int a = nombres.indexOf(contraste.section(':', 0, 0));
+            int b = nombres.indexOf(contraste.section(':', 1));
+            if (contraste.count(':') != 1 || a < 0 || b < 0 || a == b)
+            {
+                error = "invalid contrast: " + contraste + " (expected group:group, all or any)";
+                return false;
+            }
+            if (!pares.contains(qMakePair(a, b)))
+                pares << qMakePair(a, b);
+        }
+    }
+
+    if (pares.isEmpty() && !cualquiera)
+    {
+        error = "the contrast list is empty";
+        return false;
+    }
+
+    // un trabajo de dos grupos por contraste, en su subdirectorio de la salida
+    // ..todos comparten la ventana del cromosoma que fija la cohorte, y con ella las muestras
+    // leídas, las transformadas y las sumas por grupo
+    QList<dmr_config> contraste_trabajos;
+    foreach (const auto &par, pares)
+    {
+        dmr_config trabajo    = config;
+        trabajo.lista_casos   = grupos.at(par.first);
+        trabajo.lista_control = grupos.at(par.second);
+        trabajo.grupos.clear();
+        trabajo.ruta_salida   = config.ruta_salida + "/" + nombres.at(par.first) + "_vs_" + nombres.at(par.second);
+        contraste_trabajos << trabajo;
+    }
+
+    // todos los grupos a la vez, sin refinado de extremos ni pruebas: comparan dos grupos
+    if (cualquiera)
+    {
+        dmr_config trabajo    = config;
+        trabajo.refinar       = false;
+        trabajo.permutaciones = 0;
+        trabajo.beta_binomial = false;
+        trabajo.ruta_salida   = config.ruta_salida + "/any_group";
+        contraste_trabajos << trabajo;
+    }
+
+    foreach (const dmr_config &trabajo, contraste_trabajos)
+        if (!QDir().mkpath(trabajo.ruta_salida))
+        {
+            error = "output folder cannot be created: " + trabajo.ruta_salida;
+            return false;
+        }
+
+    trabajos << contraste_trabajos;
+    return true;
+}
+
+// ************************************************************************************************
+bool Run_file::leer(const QString &fichero, QList<dmr_config> &trabajos, int &memoria_mb, QString &error)
+{
+    QFile data(fichero);
+    if (!data.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        error = "An error occurred opening the file: " + fichero;
+        return false;
+    }
+
+    QJsonParseError estado;
+    QJsonDocument documento = QJsonDocument::fromJson(data.readAll(), &estado);
+    data.close();
+
+    if (estado.error != QJsonParseError::NoError || !documento.isObject())
+    {
+        error = fichero + ": " + (estado.error != QJsonParseError::NoError ? estado.errorString() :
+                                                                              QString("a JSON object is expected"));
+        return false;
+    }
+
+    QJsonObject raiz = documento.object();
+    memoria_mb = raiz.value("memory-mb").toInt(0);
+
+    // opciones comunes a todos los trabajos
+    QMap<QString, QStringList> comunes;
+    anyadir_json(raiz.value("defaults").toObject(), comunes);
+
+    QJsonArray lista = raiz.value("jobs").toArray();
+    if (lista.isEmpty())
+    {
+        error = fichero + ": the job list is empty";
+        return false;
+    }
+
+    trabajos.clear();
+    for (int i = 0; i < lista.size(); i++)
+    {
+        QMap<QString, QStringList> opciones = comunes;
+        anyadir_json(lista.at(i).toObject(), opciones);
+
+        // una hoja de muestras da un trabajo por contraste
+        if (!configurar_trabajos(opciones, trabajos, error))
+        {
+            error = fichero + ", job " + QString::number(i + 1) + ": " + error;
+            return false;
+        }
+    }
+
+    return true;
+}
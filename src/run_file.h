@@ -0,0 +1,100 @@
+#ifndef RUN_FILE_H
+#define RUN_FILE_H
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include "dmr_config.h"
+
+/**
+ * @brief Traducción de opciones con nombre (línea de comandos o fichero de ejecución JSON)
+ *        a configuraciones de análisis.
+ *
+ *        El fichero de ejecución describe varios trabajos que se procesan juntos en un mismo
+ *        proceso, compartiendo las muestras leídas y transformadas:
+ *
+ *        {
+ *            "memory-mb": 16000,
+ *            "defaults":  { "out": "/datos/dmrs", "signal": "both", "threshold": 30 },
+ *            "jobs": [
+ *                { "case": ["/datos/c1", "/datos/c2"], "control": ["/datos/n1", "/datos/n2"] },
+ *                { "case": ["/datos/c3"],             "control": ["/datos/n1", "/datos/n2"], "chroms": "1,2" }
+ *            ]
+ *        }
+ *
+ *        Las claves de cada trabajo son las mismas que las opciones de hpg_dhunter_cli; las de
+ *        "defaults" se aplican a todos los trabajos salvo que el trabajo las redefina.
+ *
+ *        En lugar de casos y controles, un trabajo puede dar una hoja de muestras con el directorio
+ *        y el grupo de cada muestra por línea, y la lista de contrastes entre grupos ("A:B", "all"
+ *        para todos los pares o "any" para la diferencia entre cualquier par de grupos). Se
+ *        convierte en un trabajo por contraste en <out>/A_vs_B y <out>/any_group, que se procesan
+ *        juntos leyendo y transformando cada muestra una vez.
+ */
+class Run_file
+{
+public:
+    /**
+     * @fn static bool configurar(const QMap<QString, QStringList> &, dmr_config &, QString &)
+     * @brief Aplica un conjunto de opciones sobre una configuración y comprueba que es completa
+     * @param opciones  valores por nombre de opción (case, control, out, chroms, reference, signal,
+     *                  strand, mc-coverage, hmc-coverage, threshold, level, density, samples,
+     *                  regions, fai, stationary, refine, coarse-level, cpg-space,
+     *                  pairwise, pairwise-lists, permutations)
+     * @param config    configuración a completar, conserva los valores de las opciones ausentes
+     * @param error     descripción del primer error encontrado
+     * @return          false si alguna opción es desconocida o tiene un valor fuera de rango
+     */
+    static bool configurar(const QMap<QString, QStringList> &opciones, dmr_config &config, QString &error);
+
+    /**
+     * @fn static bool configurar_trabajos(const QMap<QString, QStringList> &, QList<dmr_config> &, QString &)
+     * @brief Configura los trabajos de un conjunto de opciones: uno, o uno por contraste con una hoja
+     *        de muestras (sample-sheet, contrasts), cuyos directorios de salida se crean
+     * @param trabajos  lista a la que se añaden los trabajos
+     */
+    static bool configurar_trabajos(const QMap<QString, QStringList> &opciones, QList<dmr_config> &trabajos,
+                                    QString &error);
+
+    /**
+     * @fn static bool leer(const QString &, QList<dmr_config> &, int &, QString &)
+     * @brief Lee un fichero de ejecución con varios trabajos
+     * @param fichero   ruta del fichero JSON
+     * @param trabajos  configuración de cada trabajo en el orden del fichero
+     * @param memoria_mb    límite de memoria para muestras compartidas, 0 si el fichero no lo indica
+     * @param error     descripción del primer error encontrado
+     */
+    static bool leer(const QString &fichero, QList<dmr_config> &trabajos, int &memoria_mb, QString &error);
+
+    /**
+     * @fn static QStringList opciones()
+     * @brief Nombres de todas las opciones de un trabajo
+     */
+    static QStringList opciones();
+
+private:
+    /**
+     * @fn static bool leer_hoja(const QString &, QStringList &, QStringList &, QString &)
+     * @brief Lee una hoja de muestras: directorio y grupo por línea, # para comentarios
+     * @param muestras  directorios de las muestras, relativos a la hoja si no son absolutos
+     * @param etiquetas grupo de cada muestra
+     */
+    static bool leer_hoja(const QString &fichero, QStringList &muestras, QStringList &etiquetas, QString &error);
+
+    /**
+     * @fn static bool leer_entero(const QMap<QString, QStringList> &, const QString &, int, int, int &, QString &)
+     * @brief Lee una opción entera dentro de un rango, si está presente
+     */
+    static bool leer_entero(const QMap<QString, QStringList> &opciones, const QString &opcion,
+                            int minimo, int maximo, int &valor, QString &error);
+
+    /**
+     * @fn static bool leer_logico(const QMap<QString, QStringList> &, const QString &, bool &, QString &)
+     * @brief Lee una opción lógica, si está presente: sin valor o true activa, false desactiva
+     */
+    static bool leer_logico(const QMap<QString, QStringList> &opciones, const QString &opcion,
+                            bool &valor, QString &error);
+};
+
+#endif // RUN_FILE_H
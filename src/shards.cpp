@@ -0,0 +1,527 @@
+#include "shards.h"
+#include "contigs.h"
+#include "dmr_engine.h"
+#include "bgzf_writer.h"
+#include "telemetria.h"
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QRegularExpression>
+#include <QCryptographicHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <vector>
+
+// ************************************************************************************************
+QString Shards::directorio(const dmr_config &config, int chrom)
+{
+    return config.ruta_salida + "/shards/chr" + Contigs::nombre(chrom);
+}
+
+// ************************************************************************************************
+QString Shards::marca(const dmr_config &config, int chrom, int mh)
+{
+    return directorio(config, chrom) + "/" + Dmr_engine::nombre_gff(config, mh) + ".done";
+}
+
+// ************************************************************************************************
+QString Shards::huella(const dmr_config &config)
+{
+    // un campo por línea en orden fijo, las listas de muestras en su orden porque fijan las columnas
+    QString texto;
+    QTextStream s(&texto);
+    s << "case:"      << config.lista_casos.join("|")   << "\n"
+      << "control:"   << config.lista_control.join("|") << "\n"
+      << "out:"       << config.ruta_salida             << "\n"
+      << "reference:" << config.genome_reference        << "\n"
+      << "signal:"    << config.mc << config.hmc        << "\n"
+      << "strand:"    << config.forward << config.reverse << "\n"
+      << "coverage:"  << config.mc_min_coverage << "," << config.hmc_min_coverage << "\n"
+      << "threshold:" << config.threshold               << "\n"
+      << "level:"     << config.dmr_dwt_level           << "\n"
+      << "density:"   << config.min_cpg_x_region        << "\n"
+      << "samples:"   << config.min_samples_x_region    << "\n";
+
+    // sólo los trabajos con regiones objetivo las incluyen, la huella del resto no cambia
+    if (!config.fichero_regiones.isEmpty())
+        s << "regions:" << config.fichero_regiones << "\n";
+    if (config.estacionaria)
+        s << "stationary:" << config.estacionaria << "\n";
+    if (config.refinar)
+        s << "refine:" << config.refinar << "\n";
+    if (config.nivel_grueso != 0)
+        s << "coarse:" << config.nivel_grueso << "\n";
+    if (config.espacio_cpg)
+        s << "cpg:" << config.espacio_cpg << "\n";
+    if (!config.grupos.isEmpty())
+    {
+        s << "groups:";
+        foreach (int g, config.grupos)
+            s << g << ",";
+        s << "\n";
+    }
+    if (!config.cohorte.isEmpty())
+        s << "cohort:" << config.cohorte.join("|") << "\n";
+    if (!config.pares.isEmpty())
+        s << "pairs:" << config.pares << config.listas_pares << "\n";
+    if (config.permutaciones > 0)
+        s << "permutations:" << config.permutaciones << "\n";
+    if (config.beta_binomial)
+        s << "betabinomial:" << config.beta_binomial << "\n";
+    s.flush();
+
+    return QString(QCryptographicHash::hash(texto.toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+// ************************************************************************************************
+bool Shards::preparar(QList<dmr_config> &trabajos, const QList<int> &chroms, QString &error)
+{
+    QList<dmr_config> shard;
+
+    // los resultados parciales de cada trabajo los limpia el motor antes de procesarlo,
+    // así un shard repetido conserva los trabajos que ya terminó
+    // ..en un lote cada cromosoma de cada trabajo es un trabajo con su propio directorio de shard
+    foreach (int chrom, chroms)
+    {
+        bool analizado = false;
+        foreach (dmr_config config, trabajos)
+        {
+            if (!config.lista_chroms.contains(chrom))
+                continue;
+
+            config.lista_chroms = {chrom};
+            config.ruta_shard   = directorio(config, chrom);
+            shard << config;
+            analizado = true;
+        }
+
+        if (!analizado)
+        {
+            error = "no job analyzes chromosome " + Contigs::nombre(chrom);
+            return false;
+        }
+    }
+
+    if (shard.isEmpty())
+    {
+        error = "no chromosome to analyze in the shard";
+        return false;
+    }
+
+    trabajos = shard;
+    return true;
+}
+
+// ************************************************************************************************
+bool Shards::limpiar(const dmr_config &config, int chrom, QString &error)
+{
+    QString ruta = directorio(config, chrom);
+
+    for (int mh = 0; mh < 2; mh++)
+    {
+        QFile::remove(marca(config, chrom, mh));
+        QFile::remove(ruta + "/" + Dmr_engine::nombre_csv(config, chrom, mh));
+        QFile::remove(ruta + "/" + Dmr_engine::nombre_gff(config, mh));
+        QFile::remove(ruta + "/" + Dmr_engine::nombre_pares(config, mh));
+        QFile::remove(ruta + "/" + Dmr_engine::nombre_lista_pares(config, chrom, mh));
+    }
+
+    if (!QDir().mkpath(ruta))
+    {
+        error = "An error occurred creating the folder: " + ruta;
+        return false;
+    }
+
+    return true;
+}
+
+// ************************************************************************************************
+bool Shards::escribir_manifiesto(const QList<dmr_config> &trabajos, QString &error)
+{
+    // un manifiesto por directorio de salida con los trabajos que escriben en él
+    QMap<QString, QJsonArray> manifiestos;
+    QList<int> orden = Dmr_engine::orden_cromosomas(trabajos);
+
+    foreach (const dmr_config &config, trabajos)
+    {
+        QJsonArray senyales, chroms;
+        for (int mh = 0; mh < 2; mh++)
+            if ((!mh && config.mc) || (mh && config.hmc))
+                senyales.append(Dmr_engine::nombre_gff(config, mh));
+        // los cromosomas numerados como número y el resto de contigs por su nombre
+        foreach (int chrom, orden)
+            if (config.lista_chroms.contains(chrom))
+                chroms.append(Contigs::numerado(chrom) ? QJsonValue(chrom) : QJsonValue(Contigs::nombre(chrom)));
+
+        QJsonObject trabajo;
+        trabajo["fingerprint"] = huella(config);
+        trabajo["gff"]         = senyales;
+        trabajo["chroms"]      = chroms;
+        manifiestos[config.ruta_salida].append(trabajo);
+    }
+
+    for (auto it = manifiestos.constBegin(); it != manifiestos.constEnd(); ++it)
+    {
+        QString ruta = it.key() + "/shards";
+        QJsonObject manifiesto;
+        manifiesto["jobs"] = it.value();
+
+        QSaveFile data(ruta + "/manifest.json");
+        if (!QDir().mkpath(ruta) || !data.open(QIODevice::WriteOnly))
+        {
+            error = "An error occurred writing the file: " + ruta + "/manifest.json";
+            return false;
+        }
+        data.write(QJsonDocument(manifiesto).toJson());
+        if (!data.commit())
+        {
+            error = "An error occurred writing the file: " + ruta + "/manifest.json";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// ************************************************************************************************
+void Shards::marcar(const dmr_config &config, int chrom, bool procesado)
+{
+    // la marca se escribe completa o no se escribe, para que la fusión no lea un shard a medias
+    QByteArray texto = QByteArray(procesado ? "done " : "skipped ") + huella(config).toUtf8() + "\n";
+
+    for (int mh = 0; mh < 2; mh++)
+    {
+        if ((!mh && !config.mc) || (mh && !config.hmc))
+            continue;
+
+        QSaveFile data(marca(config, chrom, mh));
+        if (data.open(QIODevice::WriteOnly))
+        {
+            data.write(texto);
+            data.commit();
+        }
+    }
+}
+
+// ************************************************************************************************
+bool Shards::terminado(const dmr_config &config, int chrom)
+{
+    QString firma = huella(config);
+
+    for (int mh = 0; mh < 2; mh++)
+    {
+        if ((!mh && !config.mc) || (mh && !config.hmc))
+            continue;
+
+        // una marca de otra configuración no cuenta: el cromosoma se vuelve a procesar
+        QFile data(marca(config, chrom, mh));
+        if (!data.open(QIODevice::ReadOnly) ||
+            QString::fromUtf8(data.readAll()).trimmed().split(' ').value(1) != firma)
+            return false;
+    }
+
+    return true;
+}
+
+// ************************************************************************************************
+QList<int> Shards::pendientes(const QList<dmr_config> &trabajos)
+{
+    QList<int> lista;
+
+    foreach (int chrom, Dmr_engine::orden_cromosomas(trabajos))
+        foreach (const dmr_config &config, trabajos)
+            if (config.lista_chroms.contains(chrom) && !terminado(config, chrom) && !lista.contains(chrom))
+                lista << chrom;
+
+    return lista;
+}
+
+// ************************************************************************************************
+bool Shards::sumar_pares(const QString &fichero, QString &cabecera, QStringList &filas,
+                         QList<QList<qint64>> &cuentas)
+{
+    // sin comparación muestra a muestra o con el cromosoma sin analizar no hay matriz
+    QFile data(fichero);
+    if (!data.open(QIODevice::ReadOnly | QIODevice::Text))
+        return true;
+
+    QString primera = QString::fromUtf8(data.readLine()).trimmed();
+    if (cabecera.isEmpty())
+        cabecera = primera;
+    else if (cabecera != primera)
+        return false;
+
+    for (int f = 0; !data.atEnd(); f++)
+    {
+        QStringList campos = QString::fromUtf8(data.readLine()).trimmed().split('\t');
+        if (f == filas.size())
+        {
+            filas << campos.at(0);
+            cuentas << QList<qint64>();
+            for (int c = 1; c < campos.size(); c++)
+                cuentas[f] << 0;
+        }
+        if (filas.at(f) != campos.at(0) || cuentas.at(f).size() != campos.size() - 1)
+            return false;
+
+        for (int c = 1; c < campos.size(); c++)
+            cuentas[f][c - 1] += campos.at(c).toLongLong();
+    }
+
+    return true;
+}
+
+// ************************************************************************************************
+bool Shards::escribir_pares(const QString &fichero, const QString &cabecera, const QStringList &filas,
+                            const QList<QList<qint64>> &cuentas)
+{
+    QSaveFile data(fichero);
+    if (!data.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream s(&data);
+    s << cabecera << "\n";
+    for (int f = 0; f < filas.size(); f++)
+    {
+        s << filas.at(f);
+        foreach (qint64 n, cuentas.at(f))
+            s << "\t" << n;
+        s << "\n";
+    }
+    s.flush();
+
+    return data.commit();
+}
+
+// ************************************************************************************************
+QMap<QString, QString> Shards::valores_q(const QStringList &p)
+{
+    // el FDR del i-ésimo menor de m p-valores es el mínimo de p_j * m / j con j >= i; p-valores
+    // iguales tienen el mismo
+    std::vector<std::pair<double, QString>> ordenados;
+    foreach (const QString &v, p)
+        ordenados.push_back({v.toDouble(), v});
+    std::sort(ordenados.begin(), ordenados.end());
+
+    QMap<QString, QString> q;
+    double                 minimo = 1.0;
+    for (size_t i = ordenados.size(); i > 0; i--)
+    {
+        minimo = qMin(minimo, ordenados[i - 1].first * double(ordenados.size()) / double(i));
+        q[ordenados[i - 1].second] = QString::number(minimo, 'g', 4);
+    }
+
+    return q;
+}
+
+// ************************************************************************************************
+bool Shards::anyadir_fdr(const QString &origen, const QString &destino, const QMap<QString, QString> &q)
+{
+    QFile entrada(origen);
+    QSaveFile salida(destino);
+    if (!entrada.open(QIODevice::ReadOnly | QIODevice::Text) || !salida.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    // la cabecera y cada línea de DMR, que empieza por su posición y acaba en su p-valor, ganan
+    // una columna; las líneas de las muestras empiezan por un espacio
+    QTextStream s(&salida);
+    while (!entrada.atEnd())
+    {
+        QString linea = QString::fromUtf8(entrada.readLine());
+        if (linea.endsWith('\n'))
+            linea.chop(1);
+
+        if (linea.startsWith("pos_init"))
+            linea += " fdr";
+        else if (!linea.isEmpty() && linea.at(0).isDigit())
+            linea += " " + q.value(linea.split(' ').last(), "1");
+        s << linea << "\n";
+    }
+    s.flush();
+    entrada.close();
+
+    return salida.commit();
+}
+
+// ************************************************************************************************
+bool Shards::fusionar(const QList<dmr_config> &trabajos, QStringList &avisos, QString &error)
+{
+    QList<int> faltan = pendientes(trabajos);
+    if (!faltan.isEmpty())
+    {
+        QStringList lista;
+        foreach (int chrom, faltan)
+            lista << Contigs::nombre(chrom);
+        error = "shards not finished for chromosomes: " + lista.join(", ");
+        return false;
+    }
+
+    Telemetria::Medida medida("merge");
+
+    QList<int> orden = Dmr_engine::orden_cromosomas(trabajos);
+    QRegularExpression region("Note=DMR_Region:(\\d+),");
+    QRegularExpression pvalor(";P_value=([^;\\s]+)");
+
+    foreach (const dmr_config &config, trabajos)
+    {
+        // GFF de texto y comprimido de cada señal, reescritos completos en cada fusión
+        // ..se crean con el primer DMR, como en una ejecución en un solo proceso
+        QSaveFile   gff[2];
+        Bgzf_writer gff_bgzf[2];
+
+        // matriz de DMRs por par de muestras de cada señal: cabecera, nombre de cada fila y cuentas
+        QString              cabecera_pares[2];
+        QStringList          filas_pares[2];
+        QList<QList<qint64>> cuentas_pares[2];
+
+        // FDR de Benjamini-Hochberg de cada p-valor de las permutaciones con los DMRs de todos los
+        // cromosomas de cada señal
+        QMap<QString, QString> valores_fdr[2];
+        for (int mh = 0; mh < 2 && config.permutaciones > 0; mh++)
+        {
+            QStringList p;
+            foreach (int chrom, orden)
+            {
+                QFile parcial(directorio(config, chrom) + "/" + Dmr_engine::nombre_gff(config, mh));
+                if (!config.lista_chroms.contains(chrom) || !parcial.open(QIODevice::ReadOnly | QIODevice::Text))
+                    continue;
+
+                while (!parcial.atEnd())
+                {
+                    QRegularExpressionMatch m = pvalor.match(QString::fromUtf8(parcial.readLine()));
+                    if (m.hasMatch())
+                        p << m.captured(1);
+                }
+            }
+            valores_fdr[mh] = valores_q(p);
+        }
+
+        // la numeración de regiones es única por trabajo y avanza por cromosoma y señal (mC, hmC),
+        // igual que en una ejecución en un solo proceso
+        uint region_gff = 0;
+        foreach (int chrom, orden)
+        {
+            if (!config.lista_chroms.contains(chrom))
+                continue;
+
+            QString ruta = directorio(config, chrom);
+            for (int mh = 0; mh < 2; mh++)
+            {
+                if ((!mh && !config.mc) || (mh && !config.hmc))
+                    continue;
+
+                QFile estado(marca(config, chrom, mh));
+                if (estado.open(QIODevice::ReadOnly) && estado.readAll().startsWith("skipped"))
+                    avisos << config.ruta_salida + ": chromosome " + Contigs::nombre(chrom) + " was skipped";
+
+                // csv del cromosoma y DMRs de cada par de muestras, copiados para que los shards sigan
+                // completos hasta el final de la fusión
+                foreach (const QString &csv, QStringList() << Dmr_engine::nombre_csv(config, chrom, mh)
+                                                           << Dmr_engine::nombre_lista_pares(config, chrom, mh))
+                {
+                    if (!QFile::exists(ruta + "/" + csv))
+                        continue;
+
+                    QFile::remove(config.ruta_salida + "/" + csv);
+                    if (config.permutaciones > 0 && csv == Dmr_engine::nombre_csv(config, chrom, mh))
+                    {
+                        if (!anyadir_fdr(ruta + "/" + csv, config.ruta_salida + "/" + csv, valores_fdr[mh]))
+                        {
+                            error = "An error occurred writing the file: " + config.ruta_salida + "/" + csv;
+                            return false;
+                        }
+                    }
+                    else if (!QFile::copy(ruta + "/" + csv, config.ruta_salida + "/" + csv))
+                    {
+                        error = "An error occurred copying the file: " + ruta + "/" + csv;
+                        return false;
+                    }
+                }
+
+                // número de DMRs de cada par de muestras, sumado en todos los cromosomas
+                if (!sumar_pares(ruta + "/" + Dmr_engine::nombre_pares(config, mh), cabecera_pares[mh],
+                                 filas_pares[mh], cuentas_pares[mh]))
+                {
+                    error = "invalid pairwise matrix: " + ruta + "/" + Dmr_engine::nombre_pares(config, mh);
+                    return false;
+                }
+
+                // gff parcial, con las regiones numeradas desde 1 en el shard
+                QFile parcial(ruta + "/" + Dmr_engine::nombre_gff(config, mh));
+                if (!parcial.open(QIODevice::ReadOnly | QIODevice::Text))
+                    continue;
+
+                while (!parcial.atEnd())
+                {
+                    QString linea = QString::fromUtf8(parcial.readLine());
+                    if (linea.trimmed().isEmpty())
+                        continue;
+
+                    region_gff++;
+                    QRegularExpressionMatch m = region.match(linea);
+                    if (m.hasMatch())
+                        linea.replace(m.capturedStart(1), m.capturedLength(1), QString::number(region_gff));
+
+                    QRegularExpressionMatch p = pvalor.match(linea);
+                    if (p.hasMatch())
+                        linea.insert(p.capturedEnd(0), ";FDR=" + valores_fdr[mh].value(p.captured(1), "1"));
+
+                    if (!gff[mh].isOpen())
+                    {
+                        QString fichero_gff = config.ruta_salida + "/" + Dmr_engine::nombre_gff(config, mh);
+                        gff[mh].setFileName(fichero_gff);
+                        if (!gff[mh].open(QIODevice::WriteOnly) ||
+                            !gff_bgzf[mh].abrir((fichero_gff + ".gz").toStdString()))
+                        {
+                            error = "An error occurred opening the file: " + fichero_gff;
+                            return false;
+                        }
+                    }
+
+                    QStringList columnas = linea.split('\t');
+                    QByteArray  registro = linea.toUtf8();
+                    gff[mh].write(registro);
+                    medida.bytes(registro.size());
+                    medida.dmrs(1);
+                    gff_bgzf[mh].escribir_registro(columnas.at(0).toStdString(),
+                                                   columnas.value(3).toUInt(),
+                                                   columnas.value(4).toUInt(),
+                                                   linea.toStdString());
+                }
+            }
+        }
+
+        for (int mh = 0; mh < 2; mh++)
+        {
+            if (!filas_pares[mh].isEmpty() &&
+                !escribir_pares(config.ruta_salida + "/" + Dmr_engine::nombre_pares(config, mh),
+                                cabecera_pares[mh], filas_pares[mh], cuentas_pares[mh]))
+            {
+                error = "An error occurred writing the file: " + Dmr_engine::nombre_pares(config, mh);
+                return false;
+            }
+
+            if (!gff[mh].isOpen())
+                continue;
+
+            gff_bgzf[mh].cerrar();
+            if (!gff[mh].commit())
+            {
+                error = "An error occurred writing the file: " + gff[mh].fileName();
+                return false;
+            }
+        }
+    }
+
+    // con todas las salidas escritas se borran los resultados parciales y los puntos de control
+    // ..una fusión interrumpida antes de este punto se puede repetir; después, los shards ya no existen
+    foreach (const dmr_config &config, trabajos)
+    {
+        QDir(config.ruta_salida + "/shards").removeRecursively();
+    }
+
+    return true;
+}
@@ -0,0 +1,139 @@
+#ifndef SHARDS_H
+#define SHARDS_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "dmr_config.h"
+
+/**
+ * @brief Ejecución repartida por cromosomas (shards), puntos de control y fusión determinista
+ *        de sus resultados.
+ *
+ *        Un shard es el análisis de un cromosoma para todos los trabajos de una ejecución que lo
+ *        incluyen. Cada shard guarda sus csv y sus gff parciales en <ruta_salida>/shards/chr<N>
+ *        (con el nombre del contig en lugar de N para los contigs con nombre) y deja un fichero
+ *        <gff>.done por señal al acabar, de forma que procesos independientes, en la misma máquina
+ *        o en varias con un sistema de ficheros compartido, pueden ejecutar los shards en cualquier
+ *        orden; un proceso puede ejecutar seguidos los shards de un lote de contigs pequeños. La
+ *        fusión coloca los csv en ruta_salida y concatena los gff en el orden de cromosomas de una
+ *        ejecución en un solo proceso, renumerando las regiones, con lo que obtiene los mismos
+ *        ficheros que esa ejecución.
+ *
+ *        Toda ejecución trabaja así, aunque no se reparta: las marcas llevan la huella de la
+ *        configuración del trabajo y repetir una ejecución interrumpida con la misma configuración
+ *        salta los cromosomas terminados y produce los mismos ficheros finales.
+ */
+class Shards
+{
+public:
+    /**
+     * @fn static QString directorio(const dmr_config &, int)
+     * @brief Directorio de resultados parciales de un cromosoma de un trabajo
+     */
+    static QString directorio(const dmr_config &config, int chrom);
+
+    /**
+     * @fn static QString huella(const dmr_config &)
+     * @brief Resumen SHA-1 de los parámetros que determinan los resultados de un trabajo, sin la
+     *        lista de cromosomas, que puede cambiar entre una ejecución y su continuación
+     */
+    static QString huella(const dmr_config &config);
+
+    /**
+     * @fn static bool preparar(QList<dmr_config> &, const QList<int> &, QString &)
+     * @brief Restringe los trabajos a un cromosoma, o a un lote de cromosomas que se analizan
+     *        seguidos, y les asigna su directorio de shard
+     * @param trabajos  trabajos de la ejecución, uno por trabajo y cromosoma del lote que lo analiza
+     * @param chroms    cromosomas del shard
+     * @param error     descripción del error
+     * @return          false si ningún trabajo analiza alguno de los cromosomas
+     */
+    static bool preparar(QList<dmr_config> &trabajos, const QList<int> &chroms, QString &error);
+
+    /**
+     * @fn static bool limpiar(const dmr_config &, int, QString &)
+     * @brief Borra los resultados parciales y las marcas de un cromosoma de un trabajo para que
+     *        repetir un cromosoma interrumpido no duplique resultados, y crea su directorio
+     * @return          false si no se puede crear el directorio
+     */
+    static bool limpiar(const dmr_config &config, int chrom, QString &error);
+
+    /**
+     * @fn static bool escribir_manifiesto(const QList<dmr_config> &, QString &)
+     * @brief Guarda en <ruta_salida>/shards/manifest.json los trabajos de la ejecución que escriben
+     *        en cada directorio de salida, con su huella, sus señales y sus cromosomas
+     * @return          false si no se puede escribir algún manifiesto
+     */
+    static bool escribir_manifiesto(const QList<dmr_config> &trabajos, QString &error);
+
+    /**
+     * @fn static void marcar(const dmr_config &, int, bool)
+     * @brief Marca como terminado el cromosoma de un trabajo con la huella de su configuración
+     * @param procesado false si el cromosoma falta en alguna muestra y no se ha analizado
+     */
+    static void marcar(const dmr_config &config, int chrom, bool procesado);
+
+    /**
+     * @fn static bool terminado(const dmr_config &, int)
+     * @brief Informa si todas las señales de un cromosoma de un trabajo tienen su marca de
+     *        terminado con la misma configuración
+     */
+    static bool terminado(const dmr_config &config, int chrom);
+
+    /**
+     * @fn static QList<int> pendientes(const QList<dmr_config> &)
+     * @brief Cromosomas con algún trabajo cuyo shard no está terminado
+     */
+    static QList<int> pendientes(const QList<dmr_config> &trabajos);
+
+    /**
+     * @fn static bool fusionar(const QList<dmr_config> &, QStringList &, QString &)
+     * @brief Fusiona los resultados de todos los shards y borra sus directorios
+     *
+     *        Los ficheros de los shards se copian y los directorios sólo se borran con todas las
+     *        salidas escritas, de forma que una fusión que falla a medias se puede repetir. Una
+     *        fusión completa gasta los shards: una segunda informa de que faltan.
+     * @param trabajos  trabajos de la ejecución completa
+     * @param avisos    cromosomas que no se han podido analizar en algún trabajo
+     * @param error     descripción del error
+     * @return          false si falta algún shard o no se pueden escribir los resultados
+     */
+    static bool fusionar(const QList<dmr_config> &trabajos, QStringList &avisos, QString &error);
+
+private:
+    /**
+     * @fn static QString marca(const dmr_config &, int, int)
+     * @brief Fichero que indica que una señal de un cromosoma de un trabajo está terminada
+     */
+    static QString marca(const dmr_config &config, int chrom, int mh);
+
+    /**
+     * @fn static bool sumar_pares(const QString &, QString &, QStringList &, QList<QList<qint64>> &)
+     * @brief Suma la matriz de DMRs por par de muestras de un cromosoma a la de la ejecución
+     * @return          false si la matriz no tiene las filas y columnas de las anteriores
+     */
+    static bool sumar_pares(const QString &fichero, QString &cabecera, QStringList &filas,
+                            QList<QList<qint64>> &cuentas);
+
+    /**
+     * @fn static bool escribir_pares(const QString &, const QString &, const QStringList &, const QList<QList<qint64>> &)
+     * @brief Escribe la matriz de DMRs por par de muestras de la ejecución
+     */
+    static bool escribir_pares(const QString &fichero, const QString &cabecera, const QStringList &filas,
+                               const QList<QList<qint64>> &cuentas);
+
+    /**
+     * @fn static QMap<QString, QString> valores_q(const QStringList &)
+     * @brief FDR de Benjamini-Hochberg de cada p-valor de una lista, por su texto
+     */
+    static QMap<QString, QString> valores_q(const QStringList &p);
+
+    /**
+     * @fn static bool anyadir_fdr(const QString &, const QString &, const QMap<QString, QString> &)
+     * @brief Copia el csv de un cromosoma a la salida con el FDR de cada DMR tras su p-valor
+     */
+    static bool anyadir_fdr(const QString &origen, const QString &destino, const QMap<QString, QString> &q);
+};
+
+#endif // SHARDS_H
@@ -0,0 +1,375 @@
+#include "telemetria.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThread>
+#include <chrono>
+
+std::atomic<bool>          Telemetria::activada(false);
+std::atomic<bool>          Telemetria::con_contadores(false);
+QVector<Telemetria::tramo> Telemetria::tramos;
+
+// protege la lista de tramos, el origen de tiempos y el estado de los contadores
+static QMutex mutex_tramos;
+static std::chrono::steady_clock::time_point origen = std::chrono::steady_clock::now();
+static QString estado;
+
+// medida más interna abierta en cada hilo, de la que cuelgan las anteriores
+static thread_local Telemetria::Medida *medida_hilo = nullptr;
+
+// suma de los tramos de una etapa
+struct totales
+{
+    qint64 tramos   = 0;
+    qint64 duracion = 0;
+    qint64 bytes    = 0;
+    qint64 sitios   = 0;
+    qint64 ventanas = 0;
+    qint64 dmrs     = 0;
+    qint64 contadores[Contadores::NUM_CONTADORES] = {0, 0, 0, 0};
+};
+
+// ************************************************************************************************
+static void acumular(totales &t, const Telemetria::tramo &tramo)
+{
+    t.tramos++;
+    t.duracion += tramo.duracion;
+    t.bytes    += tramo.bytes;
+    t.sitios   += tramo.sitios;
+    t.ventanas += tramo.ventanas;
+    t.dmrs     += tramo.dmrs;
+
+    // un contador que falta en algún tramo no se suma en el total
+    for (int c = 0; c < Contadores::NUM_CONTADORES; c++)
+        t.contadores[c] = (t.contadores[c] < 0 || tramo.contadores[c] < 0) ? -1 : t.contadores[c] + tramo.contadores[c];
+}
+
+// ************************************************************************************************
+static QJsonObject json_etapas(const QMap<QString, totales> &etapas)
+{
+    QJsonObject objeto;
+    for (auto it = etapas.constBegin(); it != etapas.constEnd(); ++it)
+    {
+        QJsonObject t;
+        t["count"]   = it.value().tramos;
+        t["ms"]      = it.value().duracion / 1000.0;
+        t["bytes"]   = it.value().bytes;
+        t["sites"]   = it.value().sitios;
+        t["windows"] = it.value().ventanas;
+        t["dmrs"]    = it.value().dmrs;
+
+        // contadores hardware y sus derivados: IPC, fallos por mil instrucciones y tráfico de
+        // memoria estimado con una línea de 64 bytes por fallo de LLC
+        const qint64 *c = it.value().contadores;
+        for (int i = 0; i < Contadores::NUM_CONTADORES; i++)
+            if (c[i] > 0)
+                t[Contadores::nombre(i)] = c[i];
+        if (c[Contadores::CICLOS] > 0 && c[Contadores::INSTRUCCIONES] >= 0)
+            t["ipc"] = double(c[Contadores::INSTRUCCIONES]) / c[Contadores::CICLOS];
+        if (c[Contadores::INSTRUCCIONES] > 0 && c[Contadores::FALLOS_LLC] >= 0)
+            t["llc_mpki"] = 1000.0 * c[Contadores::FALLOS_LLC] / c[Contadores::INSTRUCCIONES];
+        if (c[Contadores::INSTRUCCIONES] > 0 && c[Contadores::FALLOS_SALTO] >= 0)
+            t["branch_mpki"] = 1000.0 * c[Contadores::FALLOS_SALTO] / c[Contadores::INSTRUCCIONES];
+        if (it.value().duracion > 0 && c[Contadores::FALLOS_LLC] >= 0)
+            t["llc_miss_mb_s"] = 64.0 * c[Contadores::FALLOS_LLC] / it.value().duracion;
+
+        objeto[it.key()] = t;
+    }
+
+    return objeto;
+}
+
+// ************************************************************************************************
+static QString nombre_senyal(int mh)
+{
+    return mh == 0 ? "mc" : (mh == 1 ? "hmc" : "");
+}
+
+// ************************************************************************************************
+static bool escribir(const QString &fichero, const QJsonObject &objeto, QString &error)
+{
+    QSaveFile data(fichero);
+    if (!data.open(QIODevice::WriteOnly))
+    {
+        error = "An error occurred opening the file: " + fichero;
+        return false;
+    }
+
+    data.write(QJsonDocument(objeto).toJson(QJsonDocument::Compact));
+    if (!data.commit())
+    {
+        error = "An error occurred writing the file: " + fichero;
+        return false;
+    }
+
+    return true;
+}
+
+// ************************************************************************************************
+Telemetria::Medida::Medida(const char *etapa, int chrom, int mh, const QString &muestra)
+{
+    midiendo = activa();
+    if (!midiendo)
+        return;
+
+    datos.etapa    = etapa;
+    datos.chrom    = chrom;
+    datos.mh       = mh;
+    datos.muestra  = muestra;
+    datos.bytes    = 0;
+    datos.sitios   = 0;
+    datos.ventanas = 0;
+    datos.dmrs     = 0;
+    datos.hilo     = quintptr(QThread::currentThread());
+
+    // la medida queda como la más interna del hilo para los repartos que haga
+    anterior    = medida_hilo;
+    medida_hilo = this;
+
+    for (int c = 0; c < Contadores::NUM_CONTADORES; c++)
+    {
+        datos.contadores[c] = -1;
+        ajenos[c]           = 0;
+    }
+    if (con_contadores.load(std::memory_order_relaxed))
+    {
+        Contadores::valores inicio;
+        if (Contadores::leer(inicio))
+            for (int c = 0; c < Contadores::NUM_CONTADORES; c++)
+                datos.contadores[c] = inicio.cuenta[c];
+    }
+
+    datos.inicio   = ahora();
+}
+
+// ************************************************************************************************
+Telemetria::Medida::~Medida()
+{
+    if (!midiendo)
+        return;
+
+    datos.duracion = ahora() - datos.inicio;
+    medida_hilo    = anterior;
+
+    // incremento de los contadores durante el tramo en el hilo más los de los hilos de sus
+    // repartos, sin valor si falta alguna de las lecturas
+    if (con_contadores.load(std::memory_order_relaxed))
+    {
+        Contadores::valores fin;
+        Contadores::leer(fin);
+        for (int c = 0; c < Contadores::NUM_CONTADORES; c++)
+            datos.contadores[c] = (datos.contadores[c] < 0 || fin.cuenta[c] < 0 || ajenos[c] < 0) ?
+                                  -1 : fin.cuenta[c] - datos.contadores[c] + ajenos[c];
+    }
+
+    registrar(datos);
+}
+
+// ************************************************************************************************
+Telemetria::Reparto::Reparto()
+{
+    medida = con_contadores.load(std::memory_order_relaxed) ? medida_hilo : nullptr;
+    for (int c = 0; c < Contadores::NUM_CONTADORES; c++)
+        cuenta[c] = 0;
+}
+
+// ************************************************************************************************
+Telemetria::Reparto::~Reparto()
+{
+    // los hilos ya han terminado: sus contadores pasan a todas las medidas abiertas en el hilo
+    for (Medida *m = medida; m != nullptr; m = m->anterior)
+        for (int c = 0; c < Contadores::NUM_CONTADORES; c++)
+            m->ajenos[c] = (m->ajenos[c] < 0 || cuenta[c] < 0) ? -1 : m->ajenos[c] + cuenta[c];
+}
+
+// ************************************************************************************************
+Telemetria::Reparto::Hilo::Hilo(Reparto &repartox)
+{
+    reparto = &repartox;
+    leido   = reparto->medida != nullptr && Contadores::leer(inicio);
+
+    // un hilo sin contadores deja la suma del reparto sin valor
+    if (reparto->medida != nullptr && !leido)
+    {
+        QMutexLocker bloqueo(&reparto->mutex);
+        for (int c = 0; c < Contadores::NUM_CONTADORES; c++)
+            reparto->cuenta[c] = -1;
+    }
+}
+
+// ************************************************************************************************
+Telemetria::Reparto::Hilo::~Hilo()
+{
+    if (!leido)
+        return;
+
+    Contadores::valores fin;
+    Contadores::leer(fin);
+
+    QMutexLocker bloqueo(&reparto->mutex);
+    for (int c = 0; c < Contadores::NUM_CONTADORES; c++)
+        reparto->cuenta[c] = (reparto->cuenta[c] < 0 || inicio.cuenta[c] < 0 || fin.cuenta[c] < 0) ?
+                             -1 : reparto->cuenta[c] + fin.cuenta[c] - inicio.cuenta[c];
+}
+
+// ************************************************************************************************
+void Telemetria::activar(bool contadores)
+{
+    QString motivo;
+    bool    disponibles = contadores && Contadores::disponibles(motivo);
+
+    mutex_tramos.lock();
+    tramos.clear();
+    origen = std::chrono::steady_clock::now();
+    estado = contadores ? motivo : QString();
+    mutex_tramos.unlock();
+
+    con_contadores = disponibles;
+    activada       = true;
+}
+
+// ************************************************************************************************
+QString Telemetria::estado_contadores()
+{
+    mutex_tramos.lock();
+    QString texto = estado;
+    mutex_tramos.unlock();
+
+    return texto;
+}
+
+// ************************************************************************************************
+qint64 Telemetria::ahora()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+           std::chrono::steady_clock::now() - origen).count();
+}
+
+// ************************************************************************************************
+void Telemetria::registrar(const tramo &t)
+{
+    mutex_tramos.lock();
+    tramos.append(t);
+    mutex_tramos.unlock();
+}
+
+// ************************************************************************************************
+QVector<Telemetria::tramo> Telemetria::registrados()
+{
+    mutex_tramos.lock();
+    QVector<tramo> lista = tramos;
+    mutex_tramos.unlock();
+
+    return lista;
+}
+
+// ************************************************************************************************
+bool Telemetria::guardar(const QString &prefijo, QString &error)
+{
+    QVector<tramo> lista = registrados();
+
+    // resumen: totales por etapa, por cromosoma (etapa.señal) y por muestra
+    QMap<QString, totales>                etapas;
+    QMap<int, QMap<QString, totales>>     cromosomas;
+    QMap<QString, QMap<QString, totales>> muestras;
+    qint64 fin = 0;
+
+    foreach (const tramo &t, lista)
+    {
+        QString etapa = QString(t.etapa);
+        acumular(etapas[etapa], t);
+
+        if (t.chrom >= 0)
+            acumular(cromosomas[t.chrom][t.mh >= 0 ? etapa + "." + nombre_senyal(t.mh) : etapa], t);
+        if (!t.muestra.isEmpty())
+            acumular(muestras[t.muestra][etapa], t);
+
+        fin = qMax(fin, t.inicio + t.duracion);
+    }
+
+    QJsonArray lista_cromosomas;
+    for (auto it = cromosomas.constBegin(); it != cromosomas.constEnd(); ++it)
+    {
+        QJsonObject c;
+        c["chrom"]  = it.key();
+        c["stages"] = json_etapas(it.value());
+        lista_cromosomas.append(c);
+    }
+
+    QJsonArray lista_muestras;
+    for (auto it = muestras.constBegin(); it != muestras.constEnd(); ++it)
+    {
+        QJsonObject m;
+        m["sample"] = it.key();
+        m["stages"] = json_etapas(it.value());
+        lista_muestras.append(m);
+    }
+
+    QJsonObject resumen;
+    resumen["wall_ms"]     = fin / 1000.0;
+    resumen["stages"]      = json_etapas(etapas);
+    resumen["chromosomes"] = lista_cromosomas;
+    resumen["samples"]     = lista_muestras;
+    if (con_contadores || !estado_contadores().isEmpty())
+    {
+        QJsonObject contadores;
+        contadores["enabled"] = bool(con_contadores);
+        if (!estado_contadores().isEmpty())
+            contadores["note"] = estado_contadores();
+        resumen["counters"] = contadores;
+    }
+
+    // traza: un evento completo por tramo, con los hilos numerados en orden de aparición
+    QMap<quintptr, int> hilos;
+    QJsonArray eventos;
+    foreach (const tramo &t, lista)
+    {
+        if (!hilos.contains(t.hilo))
+        {
+            int tid = hilos.size();
+            hilos.insert(t.hilo, tid);
+
+            QJsonObject nombre, metadatos;
+            nombre["name"]     = "thread " + QString::number(tid);
+            metadatos["name"]  = "thread_name";
+            metadatos["ph"]    = "M";
+            metadatos["pid"]   = 1;
+            metadatos["tid"]   = tid;
+            metadatos["args"]  = nombre;
+            eventos.append(metadatos);
+        }
+
+        QJsonObject args;
+        if (t.chrom >= 0)           args["chrom"]   = t.chrom;
+        if (t.mh >= 0)              args["signal"]  = nombre_senyal(t.mh);
+        if (!t.muestra.isEmpty())   args["sample"]  = t.muestra;
+        if (t.bytes)                args["bytes"]   = t.bytes;
+        if (t.sitios)               args["sites"]   = t.sitios;
+        if (t.ventanas)             args["windows"] = t.ventanas;
+        if (t.dmrs)                 args["dmrs"]    = t.dmrs;
+        for (int c = 0; c < Contadores::NUM_CONTADORES; c++)
+            if (t.contadores[c] >= 0)
+                args[Contadores::nombre(c)] = t.contadores[c];
+
+        QJsonObject evento;
+        evento["name"] = QString(t.etapa);
+        evento["cat"]  = "stage";
+        evento["ph"]   = "X";
+        evento["ts"]   = t.inicio;
+        evento["dur"]  = t.duracion;
+        evento["pid"]  = 1;
+        evento["tid"]  = hilos.value(t.hilo);
+        evento["args"] = args;
+        eventos.append(evento);
+    }
+
+    QJsonObject traza;
+    traza["traceEvents"]     = eventos;
+    traza["displayTimeUnit"] = "ms";
+
+    return escribir(prefijo + ".json", resumen, error) &&
+           escribir(prefijo + ".trace.json", traza, error);
+}
@@ -0,0 +1,215 @@
+#ifndef TELEMETRIA_H
+#define TELEMETRIA_H
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include "contadores.h"
+
+/**
+ * @brief Registro de tiempos y volúmenes de datos de cada etapa del proceso.
+ *
+ *        Cada etapa (lectura de una muestra, volcado a la matriz contigua, envío a GPU,
+ *        transformada, búsqueda de DMRs, anotación, escritura, fusión) se registra como un tramo
+ *        con su cromosoma, su señal y su muestra cuando tienen sentido, su duración y los bytes,
+ *        posiciones, ventanas y DMRs que ha manejado. Al terminar se guarda un resumen JSON con
+ *        los totales por etapa, por cromosoma y por muestra y una traza en formato Chrome trace
+ *        que se abre con chrome://tracing o con https://ui.perfetto.dev.
+ *
+ *        Opcionalmente cada tramo lleva también los contadores hardware (ciclos, instrucciones,
+ *        fallos de LLC y de predicción de saltos) del hilo que lo mide y de los hilos a los que ese
+ *        hilo reparte trabajo mientras lo mide, y el resumen añade el IPC y las tasas de fallos por
+ *        etapa.
+ *
+ *        Desactivada (por defecto) cada medida se reduce a comprobar un indicador.
+ */
+class Telemetria
+{
+public:
+    /**
+     * @brief tramo medido
+     * @param etapa     nombre de la etapa
+     * @param chrom     cromosoma, -1 si no corresponde
+     * @param mh        señal: 0 mC, 1 hmC, -1 si no corresponde
+     * @param muestra   directorio de la muestra, vacío si no corresponde
+     * @param inicio    microsegundos desde que se activó la telemetría
+     * @param duracion  microsegundos
+     * @param bytes     bytes leídos, copiados o escritos
+     * @param sitios    posiciones con datos
+     * @param ventanas  coeficientes de la transformada recorridos
+     * @param dmrs      DMRs encontrados o escritos
+     * @param hilo      identificador del hilo que lo ha medido
+     * @param contadores    incremento de cada contador hardware durante el tramo en su hilo y en
+     *                      los hilos de sus repartos, -1 sin contador
+     */
+    struct tramo
+    {
+        const char *etapa;
+        int         chrom;
+        int         mh;
+        QString     muestra;
+        qint64      inicio;
+        qint64      duracion;
+        qint64      bytes;
+        qint64      sitios;
+        qint64      ventanas;
+        qint64      dmrs;
+        quintptr    hilo;
+        qint64      contadores[Contadores::NUM_CONTADORES];
+    };
+
+    class Reparto;
+
+    /**
+     * @brief Medida de un tramo desde su construcción hasta su destrucción
+     */
+    class Medida
+    {
+    public:
+        Medida(const char *etapa, int chrom = -1, int mh = -1, const QString &muestra = QString());
+        ~Medida();
+
+        /**
+         * @fn void bytes(qint64)
+         * @brief Acumula los bytes leídos o escritos en el tramo; sin telemetría datos no se
+         *        inicializa y no se toca
+         */
+        void bytes(qint64 n)    { if (midiendo) datos.bytes    += n; }
+
+        /**
+         * @fn void sitios(qint64)
+         * @brief Acumula los sitios recorridos en el tramo, sólo con telemetría
+         */
+        void sitios(qint64 n)   { if (midiendo) datos.sitios   += n; }
+
+        /**
+         * @fn void ventanas(qint64)
+         * @brief Acumula las ventanas recorridas en el tramo, sólo con telemetría
+         */
+        void ventanas(qint64 n) { if (midiendo) datos.ventanas += n; }
+
+        /**
+         * @fn void dmrs(qint64)
+         * @brief Acumula los DMRs encontrados en el tramo, sólo con telemetría
+         */
+        void dmrs(qint64 n)     { if (midiendo) datos.dmrs     += n; }
+
+    private:
+        friend class Reparto;
+
+        /**
+         * @brief datos del tramo
+         * @param datos     tramo medido
+         * @param midiendo  se mide el tramo
+         * @param anterior  medida abierta antes que esta en el mismo hilo, nullptr si no hay
+         * @param ajenos    contadores de los hilos de los repartos hechos durante el tramo, -1 si
+         *                  falta en alguno
+         */
+        tramo   datos;
+        bool    midiendo;
+        Medida *anterior;
+        qint64  ajenos[Contadores::NUM_CONTADORES];
+    };
+
+    /**
+     * @brief Reparto del trabajo de un hilo entre otros hilos, cuyos contadores hardware se suman
+     *        al terminar a las medidas abiertas en el hilo que reparte
+     *
+     *        El hilo que reparte crea el reparto antes de lanzar los hilos y lo destruye después de
+     *        esperarlos; cada hilo lanzado mide su parte con un Reparto::Hilo. Sin contadores no
+     *        hace nada.
+     */
+    class Reparto
+    {
+    public:
+        Reparto();
+        ~Reparto();
+
+        /**
+         * @brief Parte de un reparto medida en un hilo lanzado, desde su construcción hasta su
+         *        destrucción
+         */
+        class Hilo
+        {
+        public:
+            explicit Hilo(Reparto &repartox);
+            ~Hilo();
+
+        private:
+            Reparto            *reparto;
+            Contadores::valores inicio;
+            bool                leido;
+        };
+
+    private:
+        /**
+         * @brief suma de los hilos del reparto
+         * @param medida    medida más interna abierta en el hilo que reparte, nullptr si no hay
+         * @param cuenta    suma de cada contador en los hilos, -1 si falta en alguno
+         * @param mutex     control de acceso a cuenta desde los hilos
+         */
+        Medida *medida;
+        qint64  cuenta[Contadores::NUM_CONTADORES];
+        QMutex  mutex;
+    };
+
+    /**
+     * @fn static void activar(bool)
+     * @brief Descarta los tramos anteriores y empieza a medir con el tiempo a cero
+     * @param contadores    mide también los contadores hardware si el sistema lo permite
+     */
+    static void activar(bool contadores = false);
+
+    /**
+     * @fn static QString estado_contadores()
+     * @brief Descripción de los contadores hardware que no se han podido medir, vacía si todos
+     */
+    static QString estado_contadores();
+
+    /**
+     * @fn static bool activa()
+     * @brief Informa si se están midiendo los tramos
+     */
+    static bool activa() { return activada.load(std::memory_order_relaxed); }
+
+    /**
+     * @fn static QVector<tramo> registrados()
+     * @brief Copia de los tramos terminados desde que se activó la telemetría
+     */
+    static QVector<tramo> registrados();
+
+    /**
+     * @fn static bool guardar(const QString &, QString &)
+     * @brief Guarda el resumen en prefijo + ".json" y la traza en prefijo + ".trace.json"
+     * @param prefijo   ruta de los ficheros sin extensión
+     * @param error     descripción del error
+     * @return          false si no se puede escribir alguno de los ficheros
+     */
+    static bool guardar(const QString &prefijo, QString &error);
+
+private:
+    /**
+     * @fn static qint64 ahora()
+     * @brief Microsegundos desde que se activó la telemetría
+     */
+    static qint64 ahora();
+
+    /**
+     * @fn static void registrar(const tramo &)
+     * @brief Añade un tramo terminado, desde cualquier hilo
+     */
+    static void registrar(const tramo &t);
+
+    /**
+     * @brief estado compartido por todos los hilos
+     * @param activada  se están midiendo los tramos
+     * @param con_contadores    los tramos llevan contadores hardware
+     * @param tramos    tramos terminados en orden de finalización
+     */
+    static std::atomic<bool> activada;
+    static std::atomic<bool> con_contadores;
+    static QVector<tramo>    tramos;
+};
+
+#endif // TELEMETRIA_H
@@ -0,0 +1,36 @@
+#-------------------------------------------------
+#
+# Pruebas de la lectura de ficheros de muestras,
+# sin el resto del motor ni la GPU
+#
+#-------------------------------------------------
+
+QT          += core testlib
+QT          -= gui
+
+TARGET       = hpg_dhunter_tests
+TEMPLATE     = app
+
+DEFINES     += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ..
+
+SOURCES     += tst_files_worker.cpp \
+               ../files_worker.cpp \
+               ../indice_posiciones.cpp \
+               ../registros_muestra.cpp \
+               ../telemetria.cpp \
+               ../contadores.cpp
+
+HEADERS     += ../files_worker.h \
+               ../indice_posiciones.h \
+               ../registros_muestra.h \
+               ../telemetria.h \
+               ../contadores.h
+
+CONFIG      += console testcase
+CONFIG      -= app_bundle
+CONFIG      += C++11
+
+DESTDIR      = $$system(pwd)
+OBJECTS_DIR  = $$DESTDIR/Obj
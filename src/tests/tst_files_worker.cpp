@@ -0,0 +1,95 @@
+#include "files_worker.h"
+#include <QMutex>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QtTest>
+
+// registros del fichero de prueba, uno cada PASO bases desde PASO, en más de una marca del índice
+static const uint REGISTROS = 20000;
+static const uint PASO      = 10;
+
+class Tst_files_worker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void tramo_final_con_siguientes();
+    void tramos_con_siguientes();
+    void fichero_entero();
+
+private:
+    /**
+     * @fn vector<uint> leer(const vector<pair<uint, uint>> &, int)
+     * @brief Lee el fichero de prueba con unos tramos y devuelve las posiciones guardadas
+     */
+    vector<uint> leer(const vector<pair<uint, uint>> &tramos, int siguientes);
+
+    QTemporaryDir directorio;
+};
+
+// ************************************************************************************************
+void Tst_files_worker::initTestCase()
+{
+    QVERIFY(directorio.isValid());
+
+    QFile fichero(Files_worker::fichero_muestra(directorio.path(), true, true, "1"));
+    QVERIFY(fichero.open(QIODevice::WriteOnly | QIODevice::Text));
+
+    // posición, C, nC, mC, C de hmC, nC de hmC y hmC, como en los ficheros de muestra
+    QTextStream salida(&fichero);
+    for (uint i = 1; i <= REGISTROS; i++)
+        salida << i * PASO << " 6 0 4 9 0 1\n";
+}
+
+// ************************************************************************************************
+vector<uint> Tst_files_worker::leer(const vector<pair<uint, uint>> &tramos, int siguientes)
+{
+    vector<Registros_muestra> mc(1);
+    QMutex                    mutex;
+    Files_worker              worker;
+
+    // forward y reverse, cromosoma 1, primera muestra de casos, en memoria, contig "1"
+    worker.limitar_tramos(tramos, siguientes);
+    worker.solicitud_lectura({directorio.path()}, {}, {"1", "1", "1", "0", "", "1"}, mc, mutex);
+    worker.lectura();
+
+    vector<uint> posiciones;
+    for (size_t k = 0; k < mc[0].size(); k++)
+        posiciones.push_back(uint(mc[0][k][0]));
+
+    return posiciones;
+}
+
+// ************************************************************************************************
+void Tst_files_worker::tramo_final_con_siguientes()
+{
+    // el último tramo acaba lejos del final del fichero y tras sus siguientes quedan registros
+    vector<uint> posiciones = leer({{50000, 50030}}, 2);
+
+    vector<uint> esperadas = {50000, 50010, 50020, 50030, 50040, 50050};
+    QCOMPARE(posiciones, esperadas);
+}
+
+// ************************************************************************************************
+void Tst_files_worker::tramos_con_siguientes()
+{
+    // los siguientes de un tramo se leen antes de saltar al próximo, más de una marca por delante
+    vector<uint> posiciones = leer({{30, 30}, {150000, 150010}}, 2);
+
+    vector<uint> esperadas = {30, 40, 50, 150000, 150010, 150020, 150030};
+    QCOMPARE(posiciones, esperadas);
+}
+
+// ************************************************************************************************
+void Tst_files_worker::fichero_entero()
+{
+    vector<uint> posiciones = leer({}, 2);
+
+    QCOMPARE(posiciones.size(), size_t(REGISTROS));
+    QCOMPARE(posiciones.front(), PASO);
+    QCOMPARE(posiciones.back(), REGISTROS * PASO);
+}
+
+QTEST_GUILESS_MAIN(Tst_files_worker)
+#include "tst_files_worker.moc"
@@ -0,0 +1,45 @@
+#ifndef VISTA_MATRIZ_H
+#define VISTA_MATRIZ_H
+
+#include <cstddef>
+
+/**
+ * @brief Vista de una matriz contigua de floats por filas, sin copia ni propiedad de los datos.
+ *
+ *        Permite leer la matriz de coeficientes que la transformada deja en la memoria de la
+ *        ejecución con la misma sintaxis que un vector de vectores, matriz[fila][columna].
+ *        Deja de ser válida cuando la memoria se reserva de nuevo o se libera.
+ */
+class Vista_matriz
+{
+public:
+    Vista_matriz() : datos(nullptr), filas(0), n_columnas(0) {}
+    Vista_matriz(float *datosx, size_t filasx, size_t columnasx) :
+        datos(datosx), filas(filasx), n_columnas(columnasx) {}
+
+    /**
+     * @fn size_t size() const
+     * @brief Número de filas
+     */
+    size_t size() const { return filas; }
+
+    /**
+     * @fn size_t columnas() const
+     * @brief Número de valores por fila
+     */
+    size_t columnas() const { return n_columnas; }
+
+    /**
+     * @fn float *operator[](size_t)
+     * @brief Principio de una fila
+     */
+    float       *operator[](size_t fila)       { return datos + fila * n_columnas; }
+    const float *operator[](size_t fila) const { return datos + fila * n_columnas; }
+
+private:
+    float  *datos;
+    size_t  filas;
+    size_t  n_columnas;
+};
+
+#endif // VISTA_MATRIZ_H